@@ -9,9 +9,23 @@
 
 #include "SRTNet.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <optional>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
 #include "SRTNetInternal.h"
+#include "srt/srtcore/access_control.h"
 
 namespace {
 
@@ -66,25 +80,256 @@ private:
     uint16_t mPort;
 };
 
+///
+/// @brief Parse an IP address and port into a sockaddr_storage
+/// @param ip The IPv4 or IPv6 address
+/// @param port The port
+/// @return The address and its length, nullopt if ip is not a valid IPv4 or IPv6 address
+std::optional<std::pair<sockaddr_storage, int>> toSocketAddressStorage(const std::string& ip, uint16_t port) {
+    SocketAddress socketAddress(ip, port);
+    sockaddr_storage storage{};
+    std::optional<sockaddr_in> ipv4Address = socketAddress.getIPv4();
+    if (ipv4Address.has_value()) {
+        std::memcpy(&storage, &ipv4Address.value(), sizeof(sockaddr_in));
+        return std::make_pair(storage, static_cast<int>(sizeof(sockaddr_in)));
+    }
+    std::optional<sockaddr_in6> ipv6Address = socketAddress.getIPv6();
+    if (ipv6Address.has_value()) {
+        std::memcpy(&storage, &ipv6Address.value(), sizeof(sockaddr_in6));
+        return std::make_pair(storage, static_cast<int>(sizeof(sockaddr_in6)));
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+// Shared with the other SRTNet components, see SRTNetInternal.h
+namespace SRTNetInternal {
+
+std::optional<std::pair<sockaddr_storage, int>> resolveAddress(const std::string& host, uint16_t port) {
+    struct addrinfo hints = {0};
+    struct addrinfo* svr = nullptr;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+    hints.ai_family = AF_UNSPEC;
+    std::string portAsString = std::to_string(port);
+    int result = getaddrinfo(host.c_str(), portAsString.c_str(), &hints, &svr);
+    if (result || svr == nullptr) {
+        SRT_LOGGER(true, LOGG_ERROR,
+                   "Failed getting the IP target for > " << host << ":" << port << " Errno: " << result);
+        return std::nullopt;
+    }
+    sockaddr_storage storage{};
+    std::memcpy(&storage, svr->ai_addr, svr->ai_addrlen);
+    int length = static_cast<int>(svr->ai_addrlen);
+    freeaddrinfo(svr);
+    return std::make_pair(storage, length);
+}
+
+bool applySocketOptions(SRTSOCKET socket,
+                        int reorder,
+                        int32_t latency,
+                        int overhead,
+                        int mtu,
+                        int32_t peerIdleTimeout,
+                        const std::string& psk,
+                        const std::string& packetFilter) {
+    int result = srt_setsockflag(socket, SRTO_LATENCY, &latency, sizeof(latency));
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_LATENCY: " << srt_getlasterror_str());
+        return false;
+    }
+
+    result = srt_setsockflag(socket, SRTO_LOSSMAXTTL, &reorder, sizeof(reorder));
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_LOSSMAXTTL: " << srt_getlasterror_str());
+        return false;
+    }
+
+    result = srt_setsockflag(socket, SRTO_OHEADBW, &overhead, sizeof(overhead));
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_OHEADBW: " << srt_getlasterror_str());
+        return false;
+    }
+
+    result = srt_setsockflag(socket, SRTO_PAYLOADSIZE, &mtu, sizeof(mtu));
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PAYLOADSIZE: " << srt_getlasterror_str());
+        return false;
+    }
+
+    if (psk.length()) {
+        int32_t aes128 = 16;
+        result = srt_setsockflag(socket, SRTO_PBKEYLEN, &aes128, sizeof(aes128));
+        if (result == SRT_ERROR) {
+            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PBKEYLEN: " << srt_getlasterror_str());
+            return false;
+        }
+
+        result = srt_setsockflag(socket, SRTO_PASSPHRASE, psk.c_str(), psk.length());
+        if (result == SRT_ERROR) {
+            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PASSPHRASE: " << srt_getlasterror_str());
+            return false;
+        }
+    }
+
+    result = srt_setsockflag(socket, SRTO_PEERIDLETIMEO, &peerIdleTimeout, sizeof(peerIdleTimeout));
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag : SRTO_PEERIDLETIMEO" << srt_getlasterror_str());
+        return false;
+    }
+
+    if (!packetFilter.empty()) {
+        result = srt_setsockflag(socket, SRTO_PACKETFILTER, packetFilter.c_str(), packetFilter.length());
+        if (result == SRT_ERROR) {
+            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PACKETFILTER: " << srt_getlasterror_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace SRTNetInternal
+
+using SRTNetInternal::applySocketOptions;
+using SRTNetInternal::resolveAddress;
+
+namespace {
+
+///
+/// @brief Build the SRTO_PACKETFILTER configuration string for the built-in FEC filter
+std::string toPacketFilterString(const SRTNetCore::FecConfig& config) {
+    std::string filter = "fec,cols:" + std::to_string(config.mColumns) + ",rows:" + std::to_string(config.mRows);
+    filter += config.mLayout == SRTNetCore::FecConfig::Layout::even ? ",layout:even" : ",layout:staircase";
+    switch (config.mArq) {
+    case SRTNetCore::FecConfig::Arq::always:
+        filter += ",arq:always";
+        break;
+    case SRTNetCore::FecConfig::Arq::onreq:
+        filter += ",arq:onreq";
+        break;
+    case SRTNetCore::FecConfig::Arq::never:
+        filter += ",arq:never";
+        break;
+    }
+    return filter;
+}
+
+/// @return The IP address as text, empty if the address family is not supported
+std::string toIPString(const sockaddr* address) {
+    char ip[INET6_ADDRSTRLEN] = {};
+    if (address->sa_family == AF_INET) {
+        inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in*>(address)->sin_addr, ip, sizeof(ip));
+    } else if (address->sa_family == AF_INET6) {
+        inet_ntop(AF_INET6, &reinterpret_cast<const sockaddr_in6*>(address)->sin6_addr, ip, sizeof(ip));
+    }
+    return ip;
+}
+
+std::string defaultThreadName(SRTNetCore::ThreadRole role) {
+    switch (role) {
+    case SRTNetCore::ThreadRole::accept:
+        return "srt-accept";
+    case SRTNetCore::ThreadRole::event:
+        return "srt-event";
+    case SRTNetCore::ThreadRole::client:
+        return "srt-client";
+    case SRTNetCore::ThreadRole::dispatchWorker:
+        return "srt-dispatch";
+    case SRTNetCore::ThreadRole::monitor:
+        return "srt-monitor";
+    }
+    return "srt";
+}
+
+/// @brief Name the calling thread, names longer than the platform allows are truncated
+void setCurrentThreadName(const std::string& name) {
+#if defined(__linux__)
+    // Linux allows 15 characters plus the terminating null
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(__APPLE__)
+    pthread_setname_np(name.substr(0, 63).c_str());
+#endif
+}
+
+/// @brief Restrict the calling thread to a set of CPUs
+void setCurrentThreadAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "pthread_setaffinity_np failed: " << std::strerror(result));
+    }
+#elif defined(WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "SetThreadAffinityMask failed: " << GetLastError());
+    }
+#else
+    SRT_LOGGER(true, LOGG_WARN, "Thread affinity is not supported on this platform");
+#endif
+}
+
+/// @brief Set SCHED_FIFO with the realtime priority if given, otherwise the nice value of the calling thread
+void setCurrentThreadScheduling(const std::optional<int>& realtimePriority, const std::optional<int>& nice) {
+#if defined(__linux__)
+    if (realtimePriority.has_value()) {
+        sched_param param{};
+        param.sched_priority = realtimePriority.value();
+        int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (result != 0) {
+            SRT_LOGGER(true, LOGG_ERROR, "pthread_setschedparam SCHED_FIFO failed: " << std::strerror(result));
+        }
+    } else if (nice.has_value()) {
+        // On Linux the nice value is a property of the thread, addressed by its thread id
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice.value()) != 0) {
+            SRT_LOGGER(true, LOGG_ERROR, "setpriority failed: " << std::strerror(errno));
+        }
+    }
+#else
+    SRT_LOGGER(true, LOGG_WARN, "Thread scheduling is not supported on this platform");
+#endif
+}
+
 } // namespace
 
-SRTNet::SRTNet() {
+SRTNetCore::SRTNetCore() {
     SRT_LOGGER(true, LOGG_NOTIFY, "SRTNet constructed");
 }
 
-SRTNet::~SRTNet() {
-    stop();
+SRTNetCore::~SRTNetCore() {
+    // The derived class stops the service, the receive loops and callbacks it provides are already gone here
+    stopOverloadMonitor();
+    if (mMonitorThread.joinable()) {
+        // Destroyed from the overload callback
+        mMonitorThread.detach();
+    }
+    delete mSendTargets.exchange(nullptr);
     SRT_LOGGER(true, LOGG_NOTIFY, "SRTNet destruct")
 }
 
-void SRTNet::closeAllClientSockets() {
+void SRTNetCore::logSrtError(const char* operation) {
+    SRT_LOGGER(true, LOGG_ERROR, operation << " error: " << srt_getlasterror_str());
+}
+
+void SRTNetCore::closeAllClientSockets() {
     std::lock_guard<std::mutex> lock(mClientListMtx);
     for (auto& client : mClientList) {
         SRTSOCKET socket = client.first;
         int result = srt_close(socket);
-        if (clientDisconnected) {
-            clientDisconnected(client.second, socket);
-        }
+        releaseConnection(socket);
+        onClientDisconnected(client.second, socket);
         if (result == SRT_ERROR) {
             SRT_LOGGER(true, LOGG_ERROR, "srt_close failed: " << srt_getlasterror_str());
         }
@@ -92,7 +337,32 @@ void SRTNet::closeAllClientSockets() {
     mClientList.clear();
 }
 
-bool SRTNet::startServer(const std::string& ip,
+void SRTNetCore::publishSendTargets(std::unique_ptr<SendTargets> targets) {
+    const SendTargets* previous = mSendTargets.exchange(targets.release());
+    if (previous) {
+        mEpoch.retire([previous]() { delete previous; });
+    }
+}
+
+void SRTNetCore::publishServerTargets() {
+    auto targets = std::make_unique<SendTargets>();
+    targets->mMode = Mode::server;
+    targets->mServerClients.reserve(mClientList.size());
+    for (const auto& client : mClientList) {
+        targets->mServerClients.push_back(client.first); // Sorted, mClientList is ordered
+    }
+    publishSendTargets(std::move(targets));
+}
+
+void SRTNetCore::retireSocket(SRTSOCKET socket) {
+    mEpoch.retire([socket]() {
+        if (srt_close(socket) == SRT_ERROR) {
+            SRT_LOGGER(true, LOGG_ERROR, "srt_close failed: " << srt_getlasterror_str());
+        }
+    });
+}
+
+bool SRTNetCore::startServer(const std::string& ip,
                          uint16_t port,
                          int reorder,
                          int32_t latency,
@@ -117,7 +387,7 @@ bool SRTNet::startServer(const std::string& ip,
         return false;
     }
 
-    if (!clientConnected) {
+    if (!canAcceptClients()) {
         SRT_LOGGER(true, LOGG_FATAL, "waitForSRTClient needs clientConnected callback method terminating server!");
         return false;
     }
@@ -137,51 +407,38 @@ bool SRTNet::startServer(const std::string& ip,
         return false;
     }
 
-    result = srt_setsockflag(mContext, SRTO_LATENCY, &latency, sizeof(latency));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_LATENCY: " << srt_getlasterror_str());
-        return false;
-    }
-
-    result = srt_setsockflag(mContext, SRTO_LOSSMAXTTL, &reorder, sizeof(reorder));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_LOSSMAXTTL: " << srt_getlasterror_str());
-        return false;
-    }
-
-    result = srt_setsockflag(mContext, SRTO_OHEADBW, &overhead, sizeof(overhead));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_OHEADBW: " << srt_getlasterror_str());
+    if (!applySocketOptions(mContext, reorder, latency, overhead, mtu, peerIdleTimeout, psk, mPacketFilter)) {
+        srt_close(mContext);
         return false;
     }
 
-    result = srt_setsockflag(mContext, SRTO_PAYLOADSIZE, &mtu, sizeof(mtu));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PAYLOADSIZE: " << srt_getlasterror_str());
-        return false;
+    {
+        std::lock_guard<std::mutex> admissionLock(mAdmissionMtx);
+        mAdmissionStats = {};
+        mAdmittedPeers.clear();
+        mConnectionsPerIP.clear();
+        mAdmissionTokens = static_cast<double>(mAdmissionConfig.mConnectionBurst);
+        mAdmissionTokensUpdated = std::chrono::steady_clock::now();
     }
-
-    if (psk.length()) {
-        int32_t aes128 = 16;
-        result = srt_setsockflag(mContext, SRTO_PBKEYLEN, &aes128, sizeof(aes128));
+    if (mAdmissionConfig.mMaxConnections || mAdmissionConfig.mMaxConnectionRate > 0.0 ||
+        mAdmissionConfig.mMaxConnectionsPerIP) {
+        result = srt_listen_callback(mContext, &SRTNetCore::admissionCallback, this);
         if (result == SRT_ERROR) {
-            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PBKEYLEN: " << srt_getlasterror_str());
+            SRT_LOGGER(true, LOGG_FATAL, "srt_listen_callback: " << srt_getlasterror_str());
+            srt_close(mContext);
             return false;
         }
+    }
 
-        result = srt_setsockflag(mContext, SRTO_PASSPHRASE, psk.c_str(), psk.length());
+    if (mAllowGroupConnections) {
+        result = srt_setsockflag(mContext, SRTO_GROUPCONNECT, &yes, sizeof(yes));
         if (result == SRT_ERROR) {
-            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PASSPHRASE: " << srt_getlasterror_str());
+            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_GROUPCONNECT: " << srt_getlasterror_str());
+            srt_close(mContext);
             return false;
         }
     }
 
-    result = srt_setsockflag(mContext, SRTO_PEERIDLETIMEO, &peerIdleTimeout, sizeof(peerIdleTimeout));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag : SRTO_PEERIDLETIMEO" << srt_getlasterror_str());
-        return false;
-    }
-
     std::optional<sockaddr_in> ipv4Address = socketAddress.getIPv4();
     if (ipv4Address.has_value()) {
         result = srt_bind(mContext, reinterpret_cast<sockaddr*>(&ipv4Address.value()), sizeof(ipv4Address.value()));
@@ -201,112 +458,565 @@ bool SRTNet::startServer(const std::string& ip,
             return false;
         }
     }
-
-    result = srt_listen(mContext, 2);
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_listen: " << srt_getlasterror_str());
-        srt_close(mContext);
-        return false;
-    }
-    mServerActive = true;
-    mCurrentMode = Mode::server;
-    mWorkerThread = std::thread(&SRTNet::waitForSRTClient, this, singleSender);
+
+    result = srt_listen(mContext, 2);
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_listen: " << srt_getlasterror_str());
+        srt_close(mContext);
+        return false;
+    }
+
+    // Created here and not in the accept thread so that stop() can always release it to wake the event thread
+    mPollID = srt_epoll_create();
+    if (mPollID == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_epoll_create: " << srt_getlasterror_str());
+        srt_close(mContext);
+        return false;
+    }
+    srt_epoll_set(mPollID, SRT_EPOLL_ENABLE_EMPTY);
+
+    startDispatch();
+    startOverloadMonitor();
+    mRecording = mRecorder != nullptr;
+    mAnalyzing = mTSAnalysisConfig.has_value();
+    mServerActive = true;
+    mCurrentMode = Mode::server;
+    {
+        std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+        publishServerTargets();
+    }
+    mLifecycle = Lifecycle::running;
+    mWorkerThread = startThread(ThreadRole::accept, 0, [this, singleSender]() { waitForSRTClient(singleSender); });
+    return true;
+}
+
+void SRTNetCore::waitForSRTClient(bool singleSender) {
+    int result = SRT_ERROR;
+    mEventThread = startThread(ThreadRole::event, 0, [this]() { serverEventHandler(); });
+
+    closeAllClientSockets();
+
+    while (mServerActive) {
+        struct sockaddr_storage theirAddr = {0};
+        SRT_LOGGER(true, LOGG_NOTIFY, "SRT Server wait for client");
+        int addrSize = sizeof(theirAddr);
+        SRTSOCKET newSocketCandidate = srt_accept(mContext, reinterpret_cast<sockaddr*>(&theirAddr), &addrSize);
+        if (newSocketCandidate == -1) {
+            continue;
+        }
+        SRT_LOGGER(true, LOGG_NOTIFY, "Client connected: " << newSocketCandidate);
+        if (!admit(newSocketCandidate, toIPString(reinterpret_cast<sockaddr*>(&theirAddr)))) {
+            SRT_LOGGER(true, LOGG_WARN, "Connection limit reached, closing " << newSocketCandidate);
+            srt_close(newSocketCandidate);
+            continue;
+        }
+        mConnectingSocket = newSocketCandidate;
+        auto ctx = onClientConnected(*reinterpret_cast<sockaddr*>(&theirAddr), newSocketCandidate, mConnectionContext);
+
+        if (ctx) {
+            {
+                std::lock_guard<std::mutex> admissionLock(mAdmissionMtx);
+                mAdmissionStats.mAccepted++;
+            }
+            const int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+            std::lock_guard<std::mutex> lock(mClientListMtx);
+            mClientList[newSocketCandidate] = ctx;
+            publishServerTargets();
+            mConnectingSocket = SRT_INVALID_SOCK;
+            auto load = addConnectionLoad(newSocketCandidate, ctx);
+            if (mRecording) {
+                mRecordings[newSocketCandidate] = mRecorder->open(std::to_string(newSocketCandidate));
+            }
+            if (mAnalyzing) {
+                mAnalyzers[newSocketCandidate] = std::make_shared<SRTNetTSAnalyzer>(*mTSAnalysisConfig);
+            }
+            if (mDispatching) {
+                mDispatchQueues[newSocketCandidate] = addDispatchQueue(newSocketCandidate, ctx, load);
+            }
+            result = srt_epoll_add_usock(mPollID, newSocketCandidate, &events);
+            if (result == SRT_ERROR) {
+                SRT_LOGGER(true, LOGG_FATAL, "srt_epoll_add_usock error: " << srt_getlasterror_str());
+            }
+
+            if (singleSender) {
+                int result = srt_close(mContext);
+                if (result == SRT_ERROR) {
+                    SRT_LOGGER(true, LOGG_ERROR, "srt_close failed: " << srt_getlasterror_str());
+                }
+                break;
+            }
+        } else {
+            releaseAdmission(newSocketCandidate);
+            {
+                std::lock_guard<std::mutex> admissionLock(mAdmissionMtx);
+                mAdmissionStats.mRejectedByCallback++;
+            }
+            // The callback may have sent to the socket
+            mConnectingSocket = SRT_INVALID_SOCK;
+            retireSocket(newSocketCandidate);
+        }
+    }
+}
+
+bool SRTNetCore::setAdmissionControl(const AdmissionConfig& config) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "Admission control must be configured before the server is started");
+        return false;
+    }
+    if (config.mMaxConnectionRate < 0.0 || (config.mMaxConnectionRate > 0.0 && config.mConnectionBurst == 0)) {
+        SRT_LOGGER(true, LOGG_ERROR, "Invalid connection rate limit");
+        return false;
+    }
+    mAdmissionConfig = config;
+    return true;
+}
+
+SRTNetCore::AdmissionStatistics SRTNetCore::getAdmissionStatistics() {
+    std::lock_guard<std::mutex> lock(mAdmissionMtx);
+    AdmissionStatistics admissionStats = mAdmissionStats;
+    admissionStats.mConnections = mAdmittedPeers.size();
+    return admissionStats;
+}
+
+int SRTNetCore::admissionCallback(void* opaque,
+                                  SRTSOCKET newSocket,
+                                  int hsVersion,
+                                  const struct sockaddr* peerAddress,
+                                  const char* streamId) {
+    auto* net = static_cast<SRTNetCore*>(opaque);
+    std::lock_guard<std::mutex> lock(net->mAdmissionMtx);
+    if (!net->checkAdmissionLimits(toIPString(peerAddress), true)) {
+        srt_setrejectreason(newSocket, SRT_REJX_OVERLOAD);
+        return -1;
+    }
+    return 0;
+}
+
+bool SRTNetCore::checkAdmissionLimits(const std::string& peerIP, bool takeToken) {
+    if (mAdmissionConfig.mMaxConnections && mAdmittedPeers.size() >= mAdmissionConfig.mMaxConnections) {
+        mAdmissionStats.mRejectedMaxConnections++;
+        return false;
+    }
+    if (mAdmissionConfig.mMaxConnectionsPerIP) {
+        auto iterator = mConnectionsPerIP.find(peerIP);
+        if (iterator != mConnectionsPerIP.end() && iterator->second >= mAdmissionConfig.mMaxConnectionsPerIP) {
+            mAdmissionStats.mRejectedPerIP++;
+            return false;
+        }
+    }
+    if (takeToken && mAdmissionConfig.mMaxConnectionRate > 0.0) {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - mAdmissionTokensUpdated).count();
+        mAdmissionTokensUpdated = now;
+        mAdmissionTokens = std::min(static_cast<double>(mAdmissionConfig.mConnectionBurst),
+                                    mAdmissionTokens + elapsed * mAdmissionConfig.mMaxConnectionRate);
+        if (mAdmissionTokens < 1.0) {
+            mAdmissionStats.mRejectedRate++;
+            return false;
+        }
+        mAdmissionTokens -= 1.0;
+    }
+    return true;
+}
+
+bool SRTNetCore::admit(SRTSOCKET socket, const std::string& peerIP) {
+    std::lock_guard<std::mutex> lock(mAdmissionMtx);
+    // Callers that passed the handshake check at the same time can together exceed the limits, check again
+    if (!checkAdmissionLimits(peerIP, false)) {
+        return false;
+    }
+    mAdmittedPeers[socket] = peerIP;
+    mConnectionsPerIP[peerIP]++;
+    return true;
+}
+
+void SRTNetCore::releaseConnection(SRTSOCKET socket) {
+    releaseAdmission(socket);
+    auto recording = mRecordings.find(socket);
+    if (recording != mRecordings.end()) {
+        recording->second->close();
+        mRecordings.erase(recording);
+    }
+    mAnalyzers.erase(socket);
+}
+
+void SRTNetCore::recordReceived(SRTSOCKET socket, const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+    auto recording = mRecordings.find(socket);
+    if (recording != mRecordings.end()) {
+        recording->second->write(data, size, msgCtrl);
+    }
+}
+
+void SRTNetCore::analyzeReceived(SRTSOCKET socket, const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+    auto analyzer = mAnalyzers.find(socket);
+    if (analyzer != mAnalyzers.end()) {
+        analyzer->second->analyze(data, size, sourceTime(msgCtrl));
+    }
+}
+
+bool SRTNetCore::setRecorder(std::shared_ptr<SRTNetRecorder> recorder) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "The recorder must be set before the service is started");
+        return false;
+    }
+    mRecorder = std::move(recorder);
+    return true;
+}
+
+bool SRTNetCore::setTSAnalysis(const std::optional<SRTNetTSAnalyzer::Config>& config) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "TS analysis must be configured before the service is started");
+        return false;
+    }
+    mTSAnalysisConfig = config;
+    return true;
+}
+
+void SRTNetCore::releaseAdmission(SRTSOCKET socket) {
+    std::lock_guard<std::mutex> lock(mAdmissionMtx);
+    auto iterator = mAdmittedPeers.find(socket);
+    if (iterator == mAdmittedPeers.end()) {
+        return;
+    }
+    auto perIP = mConnectionsPerIP.find(iterator->second);
+    if (perIP != mConnectionsPerIP.end() && --perIP->second == 0) {
+        mConnectionsPerIP.erase(perIP);
+    }
+    mAdmittedPeers.erase(iterator);
+}
+
+bool SRTNetCore::setAllowGroupConnections(bool allow) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "Group connections must be configured before the server is started");
+        return false;
+    }
+    mAllowGroupConnections = allow;
+    return true;
+}
+
+bool SRTNetCore::setForwardErrorCorrection(const std::optional<FecConfig>& config) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "FEC must be configured before the service is started");
+        return false;
+    }
+    if (!config.has_value()) {
+        mPacketFilter.clear();
+        return true;
+    }
+    // SRT accepts a negative row count for column only FEC, zero is invalid
+    if (config->mColumns < 1 || config->mRows == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "Invalid FEC configuration " << config->mColumns << "x" << config->mRows);
+        return false;
+    }
+    mPacketFilter = toPacketFilterString(config.value());
+    return true;
+}
+
+bool SRTNetCore::setDispatch(const DispatchConfig& config) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "Dispatching must be configured before the service is started");
+        return false;
+    }
+    if (config.mWorkers > 0 && config.mQueueSize == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The dispatch queue size must be at least 1");
+        return false;
+    }
+    mDispatchConfig = config;
+    return true;
+}
+
+bool SRTNetCore::setThreadConfig(ThreadRole role, const ThreadConfig& config) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "Threads must be configured before the service is started");
+        return false;
+    }
+    if (config.mRealtimePriority.has_value() &&
+        (config.mRealtimePriority.value() < 1 || config.mRealtimePriority.value() > 99)) {
+        SRT_LOGGER(true, LOGG_ERROR, "Invalid realtime priority " << config.mRealtimePriority.value());
+        return false;
+    }
+    if (config.mNice.has_value() && (config.mNice.value() < -20 || config.mNice.value() > 19)) {
+        SRT_LOGGER(true, LOGG_ERROR, "Invalid nice value " << config.mNice.value());
+        return false;
+    }
+    for (int cpu : config.mCpus) {
+        if (cpu < 0) {
+            SRT_LOGGER(true, LOGG_ERROR, "Invalid CPU " << cpu);
+            return false;
+        }
+    }
+    mThreadConfigs[role] = config;
+    return true;
+}
+
+void SRTNetCore::applyThreadConfig(ThreadRole role, size_t index) const {
+    ThreadConfig config;
+    auto iterator = mThreadConfigs.find(role);
+    if (iterator != mThreadConfigs.end()) {
+        config = iterator->second;
+    }
+    std::string name = config.mName.empty() ? defaultThreadName(role) : config.mName;
+    if (role == ThreadRole::dispatchWorker) {
+        name += "-" + std::to_string(index);
+    }
+    std::vector<int> cpus = config.mCpus;
+    if (config.mSpreadOverCpus && !cpus.empty()) {
+        cpus = {config.mCpus[index % config.mCpus.size()]};
+    }
+    setCurrentThreadName(name);
+    if (!cpus.empty()) {
+        setCurrentThreadAffinity(cpus);
+    }
+    if (config.mRealtimePriority.has_value() || config.mNice.has_value()) {
+        setCurrentThreadScheduling(config.mRealtimePriority, config.mNice);
+    }
+}
+
+void SRTNetCore::startDispatch() {
+    mDispatching = mDispatchConfig.mWorkers > 0;
+    for (size_t i = 0; i < mDispatchConfig.mWorkers; ++i) {
+        mDispatchWorkers.push_back(std::make_unique<SRTNetDispatchWorker>());
+    }
+    for (size_t i = 0; i < mDispatchWorkers.size(); ++i) {
+        SRTNetDispatchWorker& worker = *mDispatchWorkers[i];
+        worker.mThread = startThread(ThreadRole::dispatchWorker, i, [this, &worker]() { dispatchWorker(worker); });
+    }
+}
+
+void SRTNetCore::stopDispatch() {
+    if (!mDispatching) {
+        return;
+    }
+    // The receive threads are gone, close what is left so that the workers deliver the disconnects and exit
+    {
+        std::lock_guard<std::mutex> lock(mClientListMtx);
+        for (auto& queue : mDispatchQueues) {
+            queue.second->close();
+            queue.second->mWorker.wakeUp();
+        }
+        mDispatchQueues.clear();
+    }
+    if (mClientDispatchQueue) {
+        mClientDispatchQueue->close();
+        mClientDispatchQueue->mWorker.wakeUp();
+    }
+    for (auto& worker : mDispatchWorkers) {
+        worker->stop();
+    }
+}
+
+void SRTNetCore::releaseDispatch() {
+    mDispatchWorkers.clear();
+    mClientDispatchQueue = nullptr;
+    mDispatching = false;
+}
+
+std::shared_ptr<SRTNetDispatchQueue> SRTNetCore::addDispatchQueue(SRTSOCKET socket,
+                                                                  std::shared_ptr<NetworkConnection>& ctx,
+                                                                  std::shared_ptr<SRTNetConnectionLoad> load) {
+    // Put the connection on the worker with the fewest connections, it stays there for its lifetime
+    SRTNetDispatchWorker* worker = mDispatchWorkers.front().get();
+    size_t fewestQueues = worker->getQueueCount();
+    for (auto& candidate : mDispatchWorkers) {
+        size_t queues = candidate->getQueueCount();
+        if (queues < fewestQueues) {
+            worker = candidate.get();
+            fewestQueues = queues;
+        }
+    }
+    auto queue = std::make_shared<SRTNetDispatchQueue>(mDispatchConfig.mQueueSize, socket, ctx, *worker);
+    queue->mLoad = std::move(load);
+    worker->addQueue(queue);
+    return queue;
+}
+
+SRTNetDispatchQueue* SRTNetCore::findDispatchQueue(SRTSOCKET socket) {
+    auto iterator = mDispatchQueues.find(socket);
+    if (iterator == mDispatchQueues.end()) {
+        return nullptr;
+    }
+    return iterator->second.get();
+}
+
+void SRTNetCore::queueForDispatch(SRTNetDispatchQueue& queue,
+                                  const uint8_t* data,
+                                  size_t size,
+                                  const SRT_MSGCTRL& msgCtrl) {
+    if (!queue.push(data, size, msgCtrl)) {
+        SRT_LOGGER(true, LOGG_WARN, "Dispatch queue full, message dropped for socket " << queue.mSocket);
+    }
+    queue.mWorker.wakeUp();
+}
+
+void SRTNetCore::closeDispatchQueue(SRTSOCKET socket) {
+    auto iterator = mDispatchQueues.find(socket);
+    if (iterator == mDispatchQueues.end()) {
+        return;
+    }
+    iterator->second->close();
+    iterator->second->mWorker.wakeUp();
+    mDispatchQueues.erase(iterator);
+}
+
+bool SRTNetCore::setOverloadDetection(const OverloadConfig& config, OverloadCallback callback) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR, "Overload detection must be configured before the service is started");
+        return false;
+    }
+    if (callback) {
+        if (config.mInterval.count() <= 0) {
+            SRT_LOGGER(true, LOGG_ERROR, "The overload check interval must be positive");
+            return false;
+        }
+        if (config.mHighBufferMs <= 0 && config.mHighBufferPackets <= 0 && config.mHighCallbackLoad <= 0.0) {
+            SRT_LOGGER(true, LOGG_ERROR, "Overload detection needs at least one high threshold");
+            return false;
+        }
+        if ((config.mHighBufferMs > 0 && config.mLowBufferMs > config.mHighBufferMs) ||
+            (config.mHighBufferPackets > 0 && config.mLowBufferPackets > config.mHighBufferPackets) ||
+            (config.mHighCallbackLoad > 0.0 && config.mLowCallbackLoad > config.mHighCallbackLoad)) {
+            SRT_LOGGER(true, LOGG_ERROR, "An overload low threshold is above its high threshold");
+            return false;
+        }
+    }
+    mOverloadConfig = config;
+    mOverloadCallback = std::move(callback);
     return true;
 }
 
-void SRTNet::serverEventHandler() {
-    SRT_EPOLL_EVENT ready[MAX_WORKERS];
-    while (mServerActive) {
-        int ret = srt_epoll_uwait(mPollID, &ready[0], MAX_WORKERS, 1000);
-
-        if (ret > 0) {
-            for (size_t i = 0; i < ret; i++) {
-                uint8_t msg[2048];
-                SRT_MSGCTRL thisMSGCTRL = srt_msgctrl_default;
-                SRTSOCKET thisSocket = ready[i].fd;
-                int result = srt_recvmsg2(thisSocket, reinterpret_cast<char*>(msg), sizeof(msg), &thisMSGCTRL);
+void SRTNetCore::startOverloadMonitor() {
+    mMonitoring = mOverloadCallback != nullptr;
+    if (!mMonitoring) {
+        return;
+    }
+    // A monitor stopped from its own callback ended when the callback returned, it is joined here
+    stopOverloadMonitor();
+    std::lock_guard<std::mutex> lock(mMonitorMtx);
+    mMonitorActive = true;
+    mMonitorThread = startThread(ThreadRole::monitor, 0, [this]() { overloadMonitor(); });
+}
 
-                std::lock_guard<std::mutex> lock(mClientListMtx);
-                auto iterator = mClientList.find(thisSocket);
-                if (result == SRT_ERROR) {
-                    SRT_LOGGER(true, LOGG_ERROR, "srt_recvmsg error: " << result << " " << srt_getlasterror_str());
-                    if (iterator == mClientList.end()) {
-                        continue; // This client has already been removed by closeAllClientSockets()
-                    }
-                    auto ctx = iterator->second;
-                    mClientList.erase(iterator->first);
-                    srt_epoll_remove_usock(mPollID, thisSocket);
-                    srt_close(thisSocket);
-                    if (clientDisconnected) {
-                        clientDisconnected(ctx, thisSocket);
-                    }
-                } else if (result > 0 && receivedData) {
-                    auto pointer = std::make_unique<std::vector<uint8_t>>(msg, msg + result);
-                    receivedData(pointer, thisMSGCTRL, iterator->second, thisSocket);
-                } else if (result > 0 && receivedDataNoCopy) {
-                    receivedDataNoCopy(msg, result, thisMSGCTRL, iterator->second, thisSocket);
-                }
-            }
-            if (mClientList.empty()) {
-                break;
-            }
-        } else if (ret == -1) {
-            SRT_LOGGER(true, LOGG_ERROR, "epoll error: " << srt_getlasterror_str());
+void SRTNetCore::stopOverloadMonitor() {
+    std::thread monitor;
+    {
+        std::lock_guard<std::mutex> lock(mMonitorMtx);
+        mMonitorActive = false;
+        mMonitorCondition.notify_one();
+        // When stop is called from the overload callback the monitor thread can't join itself, it ends once the
+        // callback returns and is joined by the next start or the destructor
+        if (mMonitorThread.joinable() && mMonitorThread.get_id() != std::this_thread::get_id()) {
+            monitor = std::move(mMonitorThread);
         }
     }
-    SRT_LOGGER(true, LOGG_NOTIFY, "serverEventHandler exit");
-
-    srt_epoll_release(mPollID);
+    if (monitor.joinable()) {
+        monitor.join();
+    }
 }
 
-void SRTNet::waitForSRTClient(bool singleSender) {
-    int result = SRT_ERROR;
-    mPollID = srt_epoll_create();
-    srt_epoll_set(mPollID, SRT_EPOLL_ENABLE_EMPTY);
-    mEventThread = std::thread(&SRTNet::serverEventHandler, this);
+std::shared_ptr<SRTNetConnectionLoad> SRTNetCore::addConnectionLoad(SRTSOCKET socket,
+                                                                    std::shared_ptr<NetworkConnection>& ctx) {
+    if (!mMonitoring) {
+        return nullptr;
+    }
+    auto load = std::make_shared<SRTNetConnectionLoad>(socket, ctx);
+    mConnectionLoads[socket] = load;
+    return load;
+}
 
-    closeAllClientSockets();
+SRTNetConnectionLoad* SRTNetCore::findConnectionLoad(SRTSOCKET socket) {
+    auto iterator = mConnectionLoads.find(socket);
+    if (iterator == mConnectionLoads.end()) {
+        return nullptr;
+    }
+    return iterator->second.get();
+}
 
-    while (mServerActive) {
-        struct sockaddr_storage theirAddr = {0};
-        SRT_LOGGER(true, LOGG_NOTIFY, "SRT Server wait for client");
-        int addrSize = sizeof(theirAddr);
-        SRTSOCKET newSocketCandidate = srt_accept(mContext, reinterpret_cast<sockaddr*>(&theirAddr), &addrSize);
-        if (newSocketCandidate == -1) {
-            continue;
+void SRTNetCore::overloadMonitor() {
+    auto lastCheck = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mMonitorMtx);
+    while (mMonitorActive) {
+        mMonitorCondition.wait_for(lock, mOverloadConfig.mInterval, [this]() { return !mMonitorActive; });
+        if (!mMonitorActive) {
+            break;
         }
-        SRT_LOGGER(true, LOGG_NOTIFY, "Client connected: " << newSocketCandidate);
-        auto ctx = clientConnected(*reinterpret_cast<sockaddr*>(&theirAddr), newSocketCandidate, mConnectionContext);
+        lock.unlock();
+        auto now = std::chrono::steady_clock::now();
+        checkOverload(now - lastCheck);
+        lastCheck = now;
+        lock.lock();
+    }
+}
 
-        if (ctx) {
-            const int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
-            std::lock_guard<std::mutex> lock(mClientListMtx);
-            mClientList[newSocketCandidate] = ctx;
-            result = srt_epoll_add_usock(mPollID, newSocketCandidate, &events);
-            if (result == SRT_ERROR) {
-                SRT_LOGGER(true, LOGG_FATAL, "srt_epoll_add_usock error: " << srt_getlasterror_str());
+void SRTNetCore::checkOverload(std::chrono::steady_clock::duration elapsed) {
+    std::vector<std::shared_ptr<SRTNetConnectionLoad>> loads;
+    {
+        std::lock_guard<std::mutex> lock(mClientListMtx);
+        for (auto iterator = mConnectionLoads.begin(); iterator != mConnectionLoads.end();) {
+            // Server connections that are gone are dropped here, the receive path does not need to care
+            if (mServerActive && mClientList.find(iterator->first) == mClientList.end()) {
+                iterator = mConnectionLoads.erase(iterator);
+                continue;
             }
+            loads.push_back(iterator->second);
+            ++iterator;
+        }
+    }
 
-            if (singleSender) {
-                int result = srt_close(mContext);
-                if (result == SRT_ERROR) {
-                    SRT_LOGGER(true, LOGG_ERROR, "srt_close failed: " << srt_getlasterror_str());
-                }
-                break;
-            }
-        } else {
-            close(newSocketCandidate);
+    // The callback is called without holding any lock, it may use the SRTNet API
+    const OverloadConfig& config = mOverloadConfig;
+    double elapsedNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    for (auto& load : loads) {
+        SRT_TRACEBSTATS stats = {};
+        if (srt_bistats(load->mSocket, &stats, 0, 1) == SRT_ERROR) {
+            continue;
+        }
+        uint64_t callbackTime = 0;
+        uint64_t maxCallbackTime = 0;
+        load->takeCallbackTime(callbackTime, maxCallbackTime);
+
+        OverloadStatus status;
+        status.mBufferMs = stats.msRcvBuf;
+        status.mBufferPackets = stats.pktRcvBuf;
+        status.mCallbackLoad = elapsedNs > 0.0 ? static_cast<double>(callbackTime) / elapsedNs : 0.0;
+        status.mMaxCallbackTime = std::chrono::microseconds(maxCallbackTime / 1000);
+        status.mDroppedPackets = stats.pktRcvDropTotal;
+
+        bool overloaded = (config.mHighBufferMs > 0 && status.mBufferMs > config.mHighBufferMs) ||
+                          (config.mHighBufferPackets > 0 && status.mBufferPackets > config.mHighBufferPackets) ||
+                          (config.mHighCallbackLoad > 0.0 && status.mCallbackLoad > config.mHighCallbackLoad);
+        bool recovered = (config.mHighBufferMs <= 0 || status.mBufferMs <= config.mLowBufferMs) &&
+                         (config.mHighBufferPackets <= 0 || status.mBufferPackets <= config.mLowBufferPackets) &&
+                         (config.mHighCallbackLoad <= 0.0 || status.mCallbackLoad <= config.mLowCallbackLoad);
+
+        if (!load->mOverloaded && overloaded) {
+            load->mOverloaded = true;
+            SRT_LOGGER(true, LOGG_WARN, "Socket " << load->mSocket << " overloaded, receive buffer "
+                                                  << status.mBufferMs << " ms callback load "
+                                                  << status.mCallbackLoad);
+            mOverloadCallback(OverloadEvent::overload, status, load->mCtx, load->mSocket);
+        } else if (load->mOverloaded && recovered) {
+            load->mOverloaded = false;
+            SRT_LOGGER(true, LOGG_NOTIFY, "Socket " << load->mSocket << " recovered from overload");
+            mOverloadCallback(OverloadEvent::recovered, status, load->mCtx, load->mSocket);
         }
     }
 }
 
-void SRTNet::getActiveClients(
+void SRTNetCore::getActiveClients(
     const std::function<void(std::map<SRTSOCKET, std::shared_ptr<NetworkConnection>>&)>& function) {
     std::lock_guard<std::mutex> lock(mClientListMtx);
     function(mClientList);
 }
 
-bool SRTNet::startClient(const std::string& host,
+bool SRTNetCore::startClient(const std::string& host,
                          uint16_t port,
                          int reorder,
                          int32_t latency,
@@ -320,7 +1030,7 @@ bool SRTNet::startClient(const std::string& host,
 
 // Host can provide a IP or name meaning any IPv4 or IPv6 address or name type www.google.com
 // There is no IP-Version preference if a name is given. the first IP-version found will be used
-bool SRTNet::startClient(const std::string& host,
+bool SRTNetCore::startClient(const std::string& host,
                          uint16_t port,
                          const std::string& localHost,
                          uint16_t localPort,
@@ -339,6 +1049,10 @@ bool SRTNet::startClient(const std::string& host,
         return false;
     }
 
+    if (!isValidClientContext(ctx)) {
+        SRT_LOGGER(true, LOGG_ERROR, "The client context is not of the Handler's Context type");
+        return false;
+    }
     mClientContext = ctx;
 
     int result = 0;
@@ -357,48 +1071,8 @@ bool SRTNet::startClient(const std::string& host,
         return false;
     }
 
-    result = srt_setsockflag(mContext, SRTO_LATENCY, &latency, sizeof(latency));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_LATENCY: " << srt_getlasterror_str());
-        return false;
-    }
-
-    result = srt_setsockflag(mContext, SRTO_LOSSMAXTTL, &reorder, sizeof(reorder));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_LOSSMAXTTL: " << srt_getlasterror_str());
-        return false;
-    }
-
-    result = srt_setsockflag(mContext, SRTO_OHEADBW, &overhead, sizeof(overhead));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_OHEADBW: " << srt_getlasterror_str());
-        return false;
-    }
-
-    result = srt_setsockflag(mContext, SRTO_PAYLOADSIZE, &mtu, sizeof(mtu));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PAYLOADSIZE: " << srt_getlasterror_str());
-        return false;
-    }
-
-    if (psk.length()) {
-        int32_t aes128 = 16;
-        result = srt_setsockflag(mContext, SRTO_PBKEYLEN, &aes128, sizeof(aes128));
-        if (result == SRT_ERROR) {
-            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PBKEYLEN: " << srt_getlasterror_str());
-            return false;
-        }
-
-        result = srt_setsockflag(mContext, SRTO_PASSPHRASE, psk.c_str(), psk.length());
-        if (result == SRT_ERROR) {
-            SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag SRTO_PASSPHRASE: " << srt_getlasterror_str());
-            return false;
-        }
-    }
-
-    result = srt_setsockflag(mContext, SRTO_PEERIDLETIMEO, &peerIdleTimeout, sizeof(peerIdleTimeout));
-    if (result == SRT_ERROR) {
-        SRT_LOGGER(true, LOGG_FATAL, "srt_setsockflag : SRTO_PEERIDLETIMEO" << srt_getlasterror_str());
+    if (!applySocketOptions(mContext, reorder, latency, overhead, mtu, peerIdleTimeout, psk, mPacketFilter)) {
+        srt_close(mContext);
         return false;
     }
 
@@ -474,63 +1148,189 @@ bool SRTNet::startClient(const std::string& host,
         return false;
     }
     freeaddrinfo(svr);
+    startDispatch();
+    startOverloadMonitor();
+    {
+        std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+        mClientLoad = addConnectionLoad(mContext, mClientContext);
+    }
+    mRecording = mRecorder != nullptr;
+    if (mRecording) {
+        mClientRecording = mRecorder->open(std::to_string(mContext));
+    }
+    mAnalyzing = mTSAnalysisConfig.has_value();
+    if (mAnalyzing) {
+        mClientAnalyzer = std::make_shared<SRTNetTSAnalyzer>(*mTSAnalysisConfig);
+    }
+    if (mDispatching) {
+        mClientDispatchQueue = addDispatchQueue(mContext, mClientContext, mClientLoad);
+    }
     mCurrentMode = Mode::client;
     mClientActive = true;
-    mWorkerThread = std::thread(&SRTNet::clientWorker, this);
+    auto targets = std::make_unique<SendTargets>();
+    targets->mMode = Mode::client;
+    targets->mClient = mContext;
+    publishSendTargets(std::move(targets));
+    mLifecycle = Lifecycle::running;
+    mWorkerThread = startThread(ThreadRole::client, 0, [this]() { clientWorker(); });
     return true;
 }
 
-void SRTNet::clientWorker() {
-    while (mClientActive) {
-        uint8_t msg[2048];
-        SRT_MSGCTRL thisMSGCTRL = srt_msgctrl_default;
-        int result = srt_recvmsg2(mContext, reinterpret_cast<char*>(msg), sizeof(msg), &thisMSGCTRL);
-        if (result == SRT_ERROR) {
-            if (mClientActive) {
-                SRT_LOGGER(true, LOGG_ERROR, "srt_recvmsg error: " << srt_getlasterror_str());
-            }
-            if (clientDisconnected) {
-                clientDisconnected(mClientContext, mContext);
+bool SRTNetCore::startClientGroup(SRT_GROUP_TYPE groupType,
+                              const std::vector<GroupMember>& members,
+                              int reorder,
+                              int32_t latency,
+                              int overhead,
+                              std::shared_ptr<NetworkConnection>& ctx,
+                              int mtu,
+                              int32_t peerIdleTimeout,
+                              const std::string& psk) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mCurrentMode != Mode::unknown) {
+        SRT_LOGGER(true, LOGG_ERROR,
+                   " "
+                       << "SRTNet mode is already set");
+        return false;
+    }
+
+    if (groupType != SRT_GTYPE_BROADCAST && groupType != SRT_GTYPE_BACKUP) {
+        SRT_LOGGER(true, LOGG_ERROR, "Unsupported group type: " << groupType);
+        return false;
+    }
+
+    if (members.empty()) {
+        SRT_LOGGER(true, LOGG_ERROR, "A socket group needs at least one member");
+        return false;
+    }
+
+    // Resolve all links before creating the group so that a bad address does not leave a half configured group
+    std::vector<SRT_SOCKGROUPCONFIG> endpoints;
+    for (const auto& member : members) {
+        std::optional<std::pair<sockaddr_storage, int>> remoteAddress = resolveAddress(member.mHost, member.mPort);
+        if (!remoteAddress.has_value()) {
+            return false;
+        }
+
+        std::optional<std::pair<sockaddr_storage, int>> localAddress;
+        if (!member.mLocalHost.empty()) {
+            localAddress = toSocketAddressStorage(member.mLocalHost, member.mLocalPort);
+            if (!localAddress.has_value()) {
+                SRT_LOGGER(true, LOGG_FATAL, "Failed to parse local socket address: " << member.mLocalHost);
+                return false;
             }
-            break;
-        } else if (result > 0 && receivedData) {
-            auto data = std::make_unique<std::vector<uint8_t>>(msg, msg + result);
-            receivedData(data, thisMSGCTRL, mClientContext, mContext);
-        } else if (result > 0 && receivedDataNoCopy) {
-            receivedDataNoCopy(msg, result, thisMSGCTRL, mClientContext, mContext);
+        } else if (member.mLocalPort != 0) {
+            SRT_LOGGER(true, LOGG_FATAL,
+                       "Local port was provided but local IP is not set, cannot bind to local address");
+            return false;
+        }
+
+        SRT_SOCKGROUPCONFIG endpoint =
+            srt_prepare_endpoint(localAddress.has_value() ? reinterpret_cast<sockaddr*>(&localAddress->first) : nullptr,
+                                 reinterpret_cast<sockaddr*>(&remoteAddress->first), remoteAddress->second);
+        endpoint.weight = member.mWeight;
+        endpoints.push_back(endpoint);
+    }
+
+    if (!isValidClientContext(ctx)) {
+        SRT_LOGGER(true, LOGG_ERROR, "The client context is not of the Handler's Context type");
+        return false;
+    }
+    mClientContext = ctx;
+
+    SRT_LOGGER(true, LOGG_NOTIFY, "SRT group client startup");
+
+    mContext = srt_create_group(groupType);
+    if (mContext == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_FATAL, "srt_create_group: " << srt_getlasterror_str());
+        return false;
+    }
+
+    // Options set on the group are inherited by all member sockets
+    if (!applySocketOptions(mContext, reorder, latency, overhead, mtu, peerIdleTimeout, psk, mPacketFilter)) {
+        srt_close(mContext);
+        return false;
+    }
+
+    SRT_LOGGER(true, LOGG_NOTIFY, "SRT group connect");
+    // Blocks until the first member is connected, the remaining members keep connecting in the background
+    int result = srt_connect_group(mContext, endpoints.data(), static_cast<int>(endpoints.size()));
+    if (result == SRT_ERROR) {
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            SRT_LOGGER(true, LOGG_ERROR,
+                       "Group member " << members[i].mHost << ":" << members[i].mPort
+                                       << " error code: " << endpoints[i].errorcode);
         }
+        SRT_LOGGER(true, LOGG_FATAL, "srt_connect_group failed: " << srt_getlasterror_str());
+        srt_close(mContext);
+        return false;
+    }
+
+    startDispatch();
+    startOverloadMonitor();
+    {
+        std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+        mClientLoad = addConnectionLoad(mContext, mClientContext);
+    }
+    mRecording = mRecorder != nullptr;
+    if (mRecording) {
+        mClientRecording = mRecorder->open(std::to_string(mContext));
     }
-    mClientActive = false;
+    mAnalyzing = mTSAnalysisConfig.has_value();
+    if (mAnalyzing) {
+        mClientAnalyzer = std::make_shared<SRTNetTSAnalyzer>(*mTSAnalysisConfig);
+    }
+    if (mDispatching) {
+        mClientDispatchQueue = addDispatchQueue(mContext, mClientContext, mClientLoad);
+    }
+    mCurrentMode = Mode::client;
+    mClientActive = true;
+    auto targets = std::make_unique<SendTargets>();
+    targets->mMode = Mode::client;
+    targets->mClient = mContext;
+    publishSendTargets(std::move(targets));
+    mLifecycle = Lifecycle::running;
+    mWorkerThread = startThread(ThreadRole::client, 0, [this]() { clientWorker(); });
+    return true;
 }
 
-std::pair<SRTSOCKET, std::shared_ptr<SRTNet::NetworkConnection>> SRTNet::getConnectedServer() {
+std::pair<SRTSOCKET, std::shared_ptr<SRTNetCore::NetworkConnection>> SRTNetCore::getConnectedServer() {
     if (mCurrentMode == Mode::client) {
         return {mContext, mClientContext};
     }
     return {0, nullptr};
 }
 
-SRTSOCKET SRTNet::getBoundSocket() const {
+SRTSOCKET SRTNetCore::getBoundSocket() const {
     return mContext;
 }
 
-SRTNet::Mode SRTNet::getCurrentMode() const {
+SRTNetCore::Mode SRTNetCore::getCurrentMode() const {
     std::lock_guard<std::mutex> lock(mNetMtx);
     return mCurrentMode;
 }
 
-bool SRTNet::sendData(const uint8_t* data, size_t len, SRT_MSGCTRL* msgCtrl, SRTSOCKET targetSystem) {
-    int result;
-
-    if (mCurrentMode == Mode::client && mContext && mClientActive) {
-        result = srt_sendmsg2(mContext, reinterpret_cast<const char*>(data), len, msgCtrl);
-    } else if (mCurrentMode == Mode::server && targetSystem && mServerActive) {
-        result = srt_sendmsg2(targetSystem, reinterpret_cast<const char*>(data), len, msgCtrl);
-    } else {
+bool SRTNetCore::sendData(const uint8_t* data, size_t len, SRT_MSGCTRL* msgCtrl, SRTSOCKET targetSystem) {
+    // No locks, the sockets found in the send targets stay open until the guard is gone
+    SRTNetEpoch::Guard guard(mEpoch);
+    SRTSOCKET socket = SRT_INVALID_SOCK;
+    const SendTargets* targets = mSendTargets.load();
+    if (targets && mLifecycle == Lifecycle::running) {
+        if (targets->mMode == Mode::client && mClientActive) {
+            socket = targets->mClient;
+        } else if (targets->mMode == Mode::server && targetSystem &&
+                   (targetSystem == mConnectingSocket ||
+                    std::binary_search(targets->mServerClients.begin(), targets->mServerClients.end(),
+                                       targetSystem))) {
+            socket = targetSystem;
+        }
+    }
+    if (socket == SRT_INVALID_SOCK) {
         SRT_LOGGER(true, LOGG_WARN, "Can't send data, the client is not active.");
         return false;
     }
 
+    int result = srt_sendmsg2(socket, reinterpret_cast<const char*>(data), len, msgCtrl);
+
     if (result == SRT_ERROR) {
         SRT_LOGGER(true, LOGG_ERROR, "srt_sendmsg2 failed: " << srt_getlasterror_str());
         return false;
@@ -544,10 +1344,25 @@ bool SRTNet::sendData(const uint8_t* data, size_t len, SRT_MSGCTRL* msgCtrl, SRT
     return true;
 }
 
-bool SRTNet::stop() {
-    std::lock_guard<std::mutex> lock(mNetMtx);
-    if (mCurrentMode == Mode::server) {
-        mServerActive = false;
+bool SRTNetCore::stop() {
+    // The callbacks may use the SRTNet API. The threads running them, the overload monitor, the receive threads and
+    // the dispatch workers, are joined without mNetMtx so that a callback never waits for a lock held by the thread
+    // waiting for it. mStopMtx keeps a second stop out meanwhile, start fails until the mode is reset
+    stopOverloadMonitor();
+    std::lock_guard<std::mutex> stopLock(mStopMtx);
+    Mode mode = Mode::unknown;
+    {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        mode = mCurrentMode;
+        if (mode == Mode::unknown) {
+            return true;
+        }
+        stopSending();
+        if (mode == Mode::server) {
+            mServerActive = false;
+        } else {
+            mClientActive = false;
+        }
         if (mContext) {
             int result = srt_close(mContext);
             if (result == SRT_ERROR) {
@@ -555,37 +1370,102 @@ bool SRTNet::stop() {
                 return false;
             }
         }
-        closeAllClientSockets();
-        if (mWorkerThread.joinable()) {
-            mWorkerThread.join();
+        if (mode == Mode::server) {
+            // Closing the listen socket wakes srt_accept in the accept thread. Releasing the epoll wakes
+            // srt_epoll_uwait in the event thread within milliseconds instead of when its timeout expires
+            closeAllClientSockets();
+            srt_epoll_release(mPollID);
         }
-        if (mEventThread.joinable()) {
-            mEventThread.join();
+    }
+
+    if (mWorkerThread.joinable()) {
+        mWorkerThread.join();
+    }
+    if (mEventThread.joinable()) {
+        mEventThread.join();
+    }
+    stopDispatch();
+
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    releaseDispatch();
+    if (mode == Mode::server) {
+        {
+            std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+            mConnectionLoads.clear();
+            mRecordings.clear();
+            mAnalyzers.clear();
         }
         SRT_LOGGER(true, LOGG_NOTIFY, "Server stopped");
-        mCurrentMode = Mode::unknown;
-        return true;
-    } else if (mCurrentMode == Mode::client) {
-        mClientActive = false;
-        if (mContext) {
-            int result = srt_close(mContext);
-            if (result == SRT_ERROR) {
-                SRT_LOGGER(true, LOGG_ERROR, "srt_close failed: " << srt_getlasterror_str());
-                return false;
+    } else {
+        {
+            std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+            mConnectionLoads.clear();
+        }
+        mClientLoad = nullptr;
+        if (mClientRecording) {
+            mClientRecording->close();
+            mClientRecording = nullptr;
+        }
+        mClientAnalyzer = nullptr;
+        SRT_LOGGER(true, LOGG_NOTIFY, "Client stopped");
+    }
+    mCurrentMode = Mode::unknown;
+    mLifecycle = Lifecycle::stopped;
+    return true;
+}
+
+void SRTNetCore::stopSending() {
+    mLifecycle = Lifecycle::stopping;
+    publishSendTargets(nullptr);
+    // Senders that found a socket before are done with it after this, the sockets can be closed
+    mEpoch.synchronize();
+}
+
+bool SRTNetCore::stop(std::chrono::milliseconds drainTimeout) {
+    bool drained = waitForSendBuffersToDrain(drainTimeout);
+    return stop() && drained;
+}
+
+bool SRTNetCore::waitForSendBuffersToDrain(std::chrono::milliseconds timeout) {
+    std::vector<SRTSOCKET> sockets;
+    {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        if (mCurrentMode == Mode::client && mClientActive) {
+            sockets.push_back(mContext);
+        } else if (mCurrentMode == Mode::server && mServerActive) {
+            std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+            for (const auto& client : mClientList) {
+                sockets.push_back(client.first);
             }
         }
+    }
 
-        if (mWorkerThread.joinable()) {
-            mWorkerThread.join();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!sockets.empty()) {
+        // Sent data stays in the send buffer until the receiver has acknowledged it
+        sockets.erase(std::remove_if(sockets.begin(), sockets.end(),
+                                     [](SRTSOCKET socket) {
+                                         size_t blocks = 0;
+                                         size_t bytes = 0;
+                                         if (srt_getsndbuffer(socket, &blocks, &bytes) == SRT_ERROR) {
+                                             return true; // Broken or not a single socket (a group), nothing to wait for
+                                         }
+                                         return bytes == 0;
+                                     }),
+                      sockets.end());
+        if (sockets.empty()) {
+            break;
         }
-        SRT_LOGGER(true, LOGG_NOTIFY, "Client stopped");
-        mCurrentMode = Mode::unknown;
-        return true;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            SRT_LOGGER(true, LOGG_WARN, "Send buffers not drained when stopping, " << sockets.size() << " connections");
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     return true;
 }
 
-bool SRTNet::getStatistics(SRT_TRACEBSTATS* currentStats, int clear, int instantaneous, SRTSOCKET targetSystem) {
+bool SRTNetCore::getStatistics(SRT_TRACEBSTATS* currentStats, int clear, int instantaneous, SRTSOCKET targetSystem) {
     std::lock_guard<std::mutex> lock(mNetMtx);
     if (mCurrentMode == Mode::client && mClientActive && mContext) {
         int result = srt_bistats(mContext, currentStats, clear, instantaneous);
@@ -605,3 +1485,163 @@ bool SRTNet::getStatistics(SRT_TRACEBSTATS* currentStats, int clear, int instant
     }
     return true;
 }
+
+bool SRTNetCore::getGroupStatistics(std::vector<GroupMemberStatistics>& members,
+                                int clear,
+                                int instantaneous,
+                                SRTSOCKET targetSystem) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    SRTSOCKET group = 0;
+    if (mCurrentMode == Mode::client && mClientActive && mContext) {
+        group = mContext;
+    } else if (mCurrentMode == Mode::server && mServerActive && targetSystem) {
+        group = targetSystem;
+    } else {
+        SRT_LOGGER(true, LOGG_ERROR, "Group statistics not available");
+        return false;
+    }
+
+    if ((group & SRTGROUP_MASK) == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "Socket " << group << " is not a socket group");
+        return false;
+    }
+
+    std::vector<SRT_SOCKGROUPDATA> groupData(kGroupMembers);
+    size_t groupSize = groupData.size();
+    int result = srt_group_data(group, groupData.data(), &groupSize);
+    // When the buffer is too small srt_group_data fails and reports the member count, links may come and go between
+    // the calls so the retries are bounded
+    for (int retry = 0; retry < 3 && result == SRT_ERROR && groupSize > groupData.size(); ++retry) {
+        groupData.resize(groupSize);
+        result = srt_group_data(group, groupData.data(), &groupSize);
+    }
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_group_data failed: " << srt_getlasterror_str());
+        return false;
+    }
+
+    members.clear();
+    for (size_t i = 0; i < groupSize; ++i) {
+        GroupMemberStatistics member;
+        member.mSocket = groupData[i].id;
+        member.mSocketState = groupData[i].sockstate;
+        member.mMemberState = groupData[i].memberstate;
+        member.mWeight = groupData[i].weight;
+        member.mPeerAddress = groupData[i].peeraddr;
+        // A member that is not yet (or no longer) connected has no statistics, report it with zeroed counters
+        if (srt_bistats(member.mSocket, &member.mStats, clear, instantaneous) == SRT_ERROR) {
+            member.mStats = {};
+        }
+        members.push_back(member);
+    }
+    return true;
+}
+
+bool SRTNetCore::getFilterStatistics(FilterStatistics& filterStats, SRTSOCKET targetSystem) {
+    SRT_TRACEBSTATS stats = {};
+    if (!getStatistics(&stats, SRTNetClearStats::no, SRTNetInstant::no, targetSystem)) {
+        return false;
+    }
+    filterStats.mFecPacketsSent = stats.pktSndFilterExtraTotal;
+    filterStats.mFecPacketsReceived = stats.pktRcvFilterExtraTotal;
+    filterStats.mPacketsRecovered = stats.pktRcvFilterSupplyTotal;
+    filterStats.mPacketsUnrecovered = stats.pktRcvFilterLossTotal;
+    return true;
+}
+
+bool SRTNetCore::getTSStatistics(SRTNetTSAnalyzer::Statistics& tsStats, SRTSOCKET targetSystem) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    tsStats = {};
+    if (!mAnalyzing) {
+        SRT_LOGGER(true, LOGG_ERROR, "TS statistics not available");
+        return false;
+    }
+    if (mCurrentMode == Mode::client && mClientAnalyzer) {
+        tsStats = mClientAnalyzer->getStatistics();
+        return true;
+    }
+    std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+    auto analyzer = mAnalyzers.find(targetSystem);
+    if (analyzer == mAnalyzers.end()) {
+        SRT_LOGGER(true, LOGG_ERROR, "No TS analysis for socket " << targetSystem);
+        return false;
+    }
+    tsStats = analyzer->second->getStatistics();
+    return true;
+}
+
+bool SRTNetCore::getDispatchStatistics(DispatchStatistics& dispatchStats, SRTSOCKET targetSystem) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    dispatchStats = {};
+    if (!mDispatching) {
+        SRT_LOGGER(true, LOGG_ERROR, "Dispatch statistics not available");
+        return false;
+    }
+    if (mCurrentMode == Mode::client && mClientDispatchQueue) {
+        mClientDispatchQueue->getStatistics(dispatchStats);
+        return true;
+    }
+    std::lock_guard<std::mutex> clientListLock(mClientListMtx);
+    if (targetSystem == 0) {
+        for (const auto& queue : mDispatchQueues) {
+            queue.second->getStatistics(dispatchStats);
+        }
+        return true;
+    }
+    SRTNetDispatchQueue* queue = findDispatchQueue(targetSystem);
+    if (!queue) {
+        SRT_LOGGER(true, LOGG_ERROR, "No dispatch queue for socket " << targetSystem);
+        return false;
+    }
+    queue->getStatistics(dispatchStats);
+    return true;
+}
+
+template class SRTNetT<SRTNetCallbackHandler>;
+
+std::shared_ptr<SRTNetCore::NetworkConnection>
+SRTNetCallbackHandler::clientConnected(SRTNetT<SRTNetCallbackHandler>& net,
+                                       struct sockaddr& sin,
+                                       SRTSOCKET newSocket,
+                                       std::shared_ptr<SRTNetCore::NetworkConnection>& ctx) {
+    return static_cast<SRTNet&>(net).clientConnected(sin, newSocket, ctx);
+}
+
+void SRTNetCallbackHandler::receivedData(SRTNetT<SRTNetCallbackHandler>& net,
+                                         const uint8_t* data,
+                                         size_t size,
+                                         SRT_MSGCTRL& msgCtrl,
+                                         std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                                         SRTSOCKET socket) {
+    auto& srtNet = static_cast<SRTNet&>(net);
+    if (srtNet.receivedData) {
+        // The vector is reused for the next message of this thread unless the callback takes it, it keeps its capacity
+        // and the copy does not allocate
+        thread_local std::unique_ptr<std::vector<uint8_t>> spare;
+        if (!spare) {
+            spare = std::make_unique<std::vector<uint8_t>>();
+        }
+        spare->assign(data, data + size);
+        srtNet.receivedData(spare, msgCtrl, ctx, socket);
+    } else if (srtNet.receivedDataNoCopy) {
+        srtNet.receivedDataNoCopy(data, size, msgCtrl, ctx, socket);
+    }
+}
+
+void SRTNetCallbackHandler::clientDisconnected(SRTNetT<SRTNetCallbackHandler>& net,
+                                               std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                                               SRTSOCKET socket) {
+    auto& srtNet = static_cast<SRTNet&>(net);
+    if (srtNet.clientDisconnected) {
+        srtNet.clientDisconnected(ctx, socket);
+    }
+}
+
+SRTNet::~SRTNet() {
+    // Stop before the callbacks are destroyed
+    stop();
+}
+
+bool SRTNet::canAcceptClients() const {
+    return clientConnected != nullptr;
+}
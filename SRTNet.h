@@ -19,9 +19,19 @@
 #include <map>
 #include <mutex>
 #include <any>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
 
 #include "srt/srtcore/srt.h"
+#include "SRTNetEpoch.h"
+#include "SRTNetLogger.h"
+#include "SRTNetRecorder.h"
+#include "SRTNetTSAnalyzer.h"
 
 #ifdef WIN32
 #include <Winsock2.h>
@@ -45,7 +55,14 @@ namespace SRTNetInstant {
 enum SRTNetInstant : int { no, yes };
 }
 
-class SRTNet {
+class SRTNetDispatchQueue;
+class SRTNetDispatchWorker;
+class SRTNetConnectionLoad;
+
+///
+/// @brief The connection handling shared by SRTNetT and SRTNet. Sockets, configuration, threads and the connection
+/// table live here, the derived class supplies the receive loops and the connection callbacks.
+class SRTNetCore {
 public:
 
     enum class Mode {
@@ -54,15 +71,135 @@ public:
         client
     };
 
-    // Fill this class with all information you need for the duration of the connection both client and server
+    // Fill this class with all information you need for the duration of the connection both client and server.
+    // SRTNetT handlers can derive their own context from this class instead, see SRTNetT
     class NetworkConnection {
     public:
+        virtual ~NetworkConnection() = default;
         std::any mObject;
     };
 
-    SRTNet();
+    // One link of a socket group, see startClientGroup
+    struct GroupMember {
+        std::string mHost;        // Remote host IP or hostname
+        uint16_t mPort = 0;       // Remote host port
+        std::string mLocalHost;   // Optional local IP to bind this link to (selects the outgoing interface)
+        uint16_t mLocalPort = 0;  // Optional local port, 0 picks an unused port
+        uint16_t mWeight = 0;     // Backup groups only, the link priority (see SRT_SOCKGROUPCONFIG::weight)
+    };
+
+    // SRT built-in forward error correction (SRTO_PACKETFILTER), see setForwardErrorCorrection
+    struct FecConfig {
+        enum class Layout { even, staircase };
+        enum class Arq { always, onreq, never };
+        int mColumns = 10;                   // Packets per row group
+        int mRows = 5;                       // Packets per column group, 1 == row FEC only
+        Layout mLayout = Layout::staircase;  // Arrangement of the column groups
+        Arq mArq = Arq::onreq;               // When to also use retransmission: always, only for packets FEC could
+                                             // not recover or never
+    };
+
+    // Packet filter (FEC) counters for one connection, see getFilterStatistics
+    struct FilterStatistics {
+        int64_t mFecPacketsSent = 0;     // FEC control packets sent
+        int64_t mFecPacketsReceived = 0; // FEC control packets received
+        int64_t mPacketsRecovered = 0;   // Lost packets rebuilt by the filter
+        int64_t mPacketsUnrecovered = 0; // Lost packets the filter could not rebuild
+    };
+
+    // State and statistics of one link of a socket group, see getGroupStatistics
+    struct GroupMemberStatistics {
+        SRTSOCKET mSocket = 0;
+        SRT_SOCKSTATUS mSocketState = SRTS_NONEXIST;
+        SRT_MEMBERSTATUS mMemberState = SRT_GST_BROKEN;
+        uint16_t mWeight = 0;
+        sockaddr_storage mPeerAddress = {};
+        SRT_TRACEBSTATS mStats = {};
+    };
+
+    // Hand received data to a pool of worker threads instead of calling the callbacks on the receive thread,
+    // see setDispatch
+    struct DispatchConfig {
+        size_t mWorkers = 0;     // Number of worker threads, 0 calls the callbacks on the receive thread
+        size_t mQueueSize = 512; // Messages queued per connection, rounded up to a power of two
+    };
 
-    virtual ~SRTNet();
+    // Limits on the connections a server accepts, see setAdmissionControl
+    struct AdmissionConfig {
+        size_t mMaxConnections = 0;      // Max concurrent connections, 0 == no limit
+        double mMaxConnectionRate = 0.0; // Max new connections per second (token bucket), 0 == no limit
+        size_t mConnectionBurst = 1;     // New connections accepted at once before the rate limit applies
+        size_t mMaxConnectionsPerIP = 0; // Max concurrent connections from one source IP, 0 == no limit
+    };
+
+    // Admission counters, see getAdmissionStatistics
+    struct AdmissionStatistics {
+        size_t mConnections = 0;              // Connections now
+        uint64_t mAccepted = 0;               // Connections accepted
+        uint64_t mRejectedMaxConnections = 0; // Rejected, mMaxConnections reached
+        uint64_t mRejectedRate = 0;           // Rejected, mMaxConnectionRate exceeded
+        uint64_t mRejectedPerIP = 0;          // Rejected, mMaxConnectionsPerIP reached for the source IP
+        uint64_t mRejectedByCallback = 0;     // Rejected by the clientConnected callback
+    };
+
+    // The threads started by SRTNet, see setThreadConfig
+    enum class ThreadRole {
+        accept,        // Server, accepts new connections
+        event,         // Server, receives from all connections
+        client,        // Client, receives from the server
+        dispatchWorker, // Runs the callbacks when dispatching is used, see setDispatch
+        monitor         // Checks the connections for overload, see setOverloadDetection
+    };
+
+    // Placement of a thread, see setThreadConfig
+    struct ThreadConfig {
+        std::vector<int> mCpus;                // CPUs the thread may run on, empty keeps the default
+        bool mSpreadOverCpus = false;          // Thread pools only, pin thread i to CPU mCpus[i % size] only
+        std::optional<int> mRealtimePriority;  // Run with SCHED_FIFO at this priority (1 - 99)
+        std::optional<int> mNice;              // Nice value (-20 - 19), ignored when mRealtimePriority is set
+        std::string mName;                     // Thread name, empty uses the default name. Max 15 characters
+    };
+
+    // Dispatch queue counters, see getDispatchStatistics
+    struct DispatchStatistics {
+        size_t mQueueDepth = 0;    // Messages waiting for a worker now
+        size_t mMaxQueueDepth = 0; // The largest queue depth seen
+        uint64_t mQueued = 0;      // Messages queued for the workers
+        uint64_t mOverflows = 0;   // Messages dropped since the queue was full
+    };
+
+    // Receive side overload detection, see setOverloadDetection. A connection is overloaded when any of the enabled
+    // high thresholds is exceeded and recovered when all enabled values are at or below their low thresholds
+    struct OverloadConfig {
+        std::chrono::milliseconds mInterval{100}; // How often the connections are checked
+        int mHighBufferMs = 0;          // Receive buffer occupancy in ms (msRcvBuf), 0 turns the check off
+        int mLowBufferMs = 0;
+        int mHighBufferPackets = 0;     // Receive buffer occupancy in packets (pktRcvBuf), 0 turns the check off
+        int mLowBufferPackets = 0;
+        double mHighCallbackLoad = 0.0; // Share of the time spent in the callbacks of the connection, 1.0 == the
+        double mLowCallbackLoad = 0.0;  // callbacks ran all the time. 0 turns the check off
+    };
+
+    enum class OverloadEvent {
+        overload, // A high threshold was exceeded, data will be lost unless the receiving side catches up
+        recovered // Back at or below the low thresholds
+    };
+
+    // The receive side of a connection when an overload event is reported
+    struct OverloadStatus {
+        int mBufferMs = 0;                              // msRcvBuf
+        int mBufferPackets = 0;                         // pktRcvBuf
+        double mCallbackLoad = 0.0;                     // Share of the last interval spent in the callbacks
+        std::chrono::microseconds mMaxCallbackTime{0};  // The longest callback in the last interval
+        int64_t mDroppedPackets = 0;                    // pktRcvDropTotal
+    };
+
+    using OverloadCallback = std::function<void(OverloadEvent event,
+                                                const OverloadStatus& status,
+                                                std::shared_ptr<NetworkConnection>& ctx,
+                                                SRTSOCKET socket)>;
+
+    virtual ~SRTNetCore();
 
     /**
      *
@@ -151,12 +288,159 @@ public:
 
     /**
      *
-     * Stops the service
+     * Starts an SRT Client connecting through a socket group (connection bonding). The group is seen as one
+     * connection, data is sent and received through the group and the receivedData / receivedDataNoCopy /
+     * clientDisconnected callbacks are called with the group id as socket.
+     * The server must allow group connections, see setAllowGroupConnections.
+     *
+     * @param groupType SRT_GTYPE_BROADCAST sends all data over all links (hitless dual-path delivery)
+     * SRT_GTYPE_BACKUP sends over the main link and fails over to a backup link when the main link becomes unstable
+     * @param members the links to connect
+     * @param reorder number of packets in re-order window
+     * @param latency Max re-send window (ms) / also the delay of transmission
+     * @param overhead % extra of the BW that will be allowed for re-transmission packets
+     * @param ctx the context used in the receivedData and receivedDataNoCopy callback
+     * @param mtu sets the MTU
+     * @param peerIdleTimeout Optional Connection considered broken if no packet received before this timeout.
+     * Defaults to 5 seconds.
+     * @param psk Optional Pre Shared Key (AES-128)
+     * @return true if at least one link of the group was able to connect to the server
+     */
+    bool startClientGroup(SRT_GROUP_TYPE groupType,
+                          const std::vector<GroupMember>& members,
+                          int reorder,
+                          int32_t latency,
+                          int overhead,
+                          std::shared_ptr<NetworkConnection>& ctx,
+                          int mtu,
+                          int32_t peerIdleTimeout = 5000,
+                          const std::string& psk = "");
+
+    /**
+     *
+     * Allow callers to connect using socket groups. Must be set before startServer is called.
+     * A connecting group is reported once to clientConnected with the group id as socket.
+     *
+     * @param allow true to accept group connections
+     * @return true if the setting was applied, false if the service is already started
+     */
+    bool setAllowGroupConnections(bool allow);
+
+    /**
+     *
+     * Use SRT forward error correction on the connections. Must be set before the server or client is started,
+     * applies to both. When only one side configures FEC the other side takes over the configuration, when both
+     * sides configure it the configurations must be compatible or the connection is rejected.
+     *
+     * @param config the FEC configuration or std::nullopt to turn FEC off
+     * @return true if the setting was applied, false if the service is already started or config is invalid
+     */
+    bool setForwardErrorCorrection(const std::optional<FecConfig>& config);
+
+    /**
+     *
+     * Run the receivedData / receivedDataNoCopy / clientDisconnected callbacks on a pool of worker threads. The receive
+     * thread only reads the messages and queues them per connection, a slow callback for one connection then no
+     * longer delays the reading of the other connections. Every connection is served by one worker so the callbacks
+     * of a connection are called in order and never concurrently. When a connection's queue is full new messages
+     * are dropped and counted, see getDispatchStatistics. Must be set before the server or client is started.
+     *
+     * @param config the dispatch configuration, mWorkers 0 turns dispatching off
+     * @return true if the setting was applied, false if the service is already started or config is invalid
+     */
+    bool setDispatch(const DispatchConfig& config);
+
+    /**
+     *
+     * Limit the connections the server accepts. The limits are checked while SRT handles the handshake of a caller,
+     * before the connection is established, and rejected callers get the SRT_REJX_OVERLOAD reject reason. Total and
+     * per IP limits are checked again when the connection is accepted. Must be set before startServer is called.
+     *
+     * @param config the limits
+     * @return true if the setting was applied, false if the service is already started or config is invalid
+     */
+    bool setAdmissionControl(const AdmissionConfig& config);
+
+    /**
+     *
+     * Get the admission counters of the server, see setAdmissionControl
+     *
+     * @return The counters since the server was started
+     */
+    AdmissionStatistics getAdmissionStatistics();
+
+    /**
+     *
+     * Set the CPU affinity, scheduling and name of the threads of a role. The threads are named srt-accept,
+     * srt-event, srt-client and srt-dispatch-N by default. Settings the platform does not support (or that the
+     * process lacks the privileges for, as SCHED_FIFO or negative nice values) are logged and the thread runs with
+     * the defaults for them. Must be set before the server or client is started.
+     * Affinity and scheduling are supported on Linux, names on Linux and macOS, affinity on Windows.
+     *
+     * @param role the threads to configure
+     * @param config the placement of the threads
+     * @return true if the setting was applied, false if the service is already started or config is invalid
+     */
+    bool setThreadConfig(ThreadRole role, const ThreadConfig& config);
+
+    /**
+     *
+     * Watch the receive buffer occupancy and the time spent in the receive callbacks of every connection and report
+     * when a connection is about to fall behind, so that the application can shed load before SRT drops data. The
+     * callback is called from the srt-monitor thread with overload once a high threshold is exceeded and with
+     * recovered once the connection is back at or below the low thresholds. When dispatching is used (see
+     * setDispatch) the callback time is measured on the dispatch workers. The callback may use the SRTNet API and may
+     * call stop, it must not start the service again. Must be set before the server or client is started.
+     *
+     * @param config the thresholds and the check interval
+     * @param callback the event callback, nullptr turns overload detection off
+     * @return true if the setting was applied, false if the service is already started or config is invalid
+     */
+    bool setOverloadDetection(const OverloadConfig& config, OverloadCallback callback);
+
+    /**
+     *
+     * Record every received message of every connection to disk. The receive thread copies the messages into the
+     * buffers of the recorder and continues, the recorder writes them in the background. See SRTNetRecorder for the
+     * file format and rotation. A recorder can be shared by several SRTNet objects. Must be set before the server or
+     * client is started.
+     *
+     * @param recorder the recorder, nullptr turns recording off
+     * @return true if the setting was applied, false if the service is already started
+     */
+    bool setRecorder(std::shared_ptr<SRTNetRecorder> recorder);
+
+    /**
+     *
+     * Check every received message of every connection as MPEG-TS: sync bytes, transport error indicators,
+     * continuity counters and PCR jitter, see SRTNetTSAnalyzer. The receive thread checks the messages before the
+     * callbacks are called, the results are read with getTSStatistics. Must be set before the server or client is
+     * started.
+     *
+     * @param config the analyzer configuration or std::nullopt to turn the analysis off
+     * @return true if the setting was applied, false if the service is already started
+     */
+    bool setTSAnalysis(const std::optional<SRTNetTSAnalyzer::Config>& config);
+
+    /**
+     *
+     * Stops the service. Messages already queued for the dispatch workers are delivered first, the callbacks
+     * running meanwhile may use the getters.
      *
      * @return true if the service stopped successfully.
      */
     bool stop();
 
+    /**
+     *
+     * Stops the service after waiting for the data already sent to be acknowledged by the receiving side(s)
+     *
+     * @param drainTimeout the longest time to wait for the send buffers to drain, the service is stopped when the
+     * timeout expires even if there is data left
+     * @return true if the service stopped successfully and all data was delivered before the timeout.
+     */
+    bool stop(std::chrono::milliseconds drainTimeout);
+
     /**
      *
      * Send data
@@ -166,6 +450,10 @@ public:
      * @param msgCtrl pointer to a SRT_MSGCTRL struct.
      * @param targetSystem the target sending the data to (used in server mode only)
      * @return true if sendData was able to send the data to the target.
+     *
+     * Takes no locks and does not allocate, any number of threads may send at the same time, also while the service
+     * stops or connections come and go. A socket is closed only once no sendData can use it. In server mode a new
+     * connection can be sent to from within the clientConnected callback.
      */
     bool sendData(const uint8_t* data, size_t size, SRT_MSGCTRL* msgCtrl, SRTSOCKET targetSystem = 0);
 
@@ -181,6 +469,52 @@ public:
      */
     bool getStatistics(SRT_TRACEBSTATS* currentStats, int clear, int instantaneous, SRTSOCKET targetSystem = 0);
 
+    /**
+     *
+     * Get packet filter (FEC) statistics, the totals since the connection was established
+     *
+     * @param filterStats the statistics struct to populate
+     * @param targetSystem The target connection to get statistics about (used in server mode only)
+     * @return true if statistics was populated.
+     */
+    bool getFilterStatistics(FilterStatistics& filterStats, SRTSOCKET targetSystem = 0);
+
+    /**
+     *
+     * Get the dispatch queue counters, see setDispatch
+     *
+     * @param dispatchStats the statistics struct to populate
+     * @param targetSystem The target connection to get statistics about (used in server mode only), 0 sums up all
+     * connections
+     * @return true if dispatching is used and statistics was populated.
+     */
+    bool getDispatchStatistics(DispatchStatistics& dispatchStats, SRTSOCKET targetSystem = 0);
+
+    /**
+     *
+     * Get the MPEG-TS analysis of a connection, see setTSAnalysis
+     *
+     * @param tsStats the statistics struct to populate
+     * @param targetSystem The target connection to get statistics about (required in server mode)
+     * @return true if TS analysis is used and statistics was populated.
+     */
+    bool getTSStatistics(SRTNetTSAnalyzer::Statistics& tsStats, SRTSOCKET targetSystem = 0);
+
+    /**
+     *
+     * Get state and statistics for every link of a socket group
+     *
+     * @param members filled with one entry per group member
+     * @param clear Clears the data after reading SRTNetClearStats::yes or no
+     * @param instantaneous Get the parameters now SRTNetInstant::yes or filtered values SRTNetInstant::no
+     * @param targetSystem The group to get statistics about (used in server mode only)
+     * @return true if the connection is a socket group and the statistics was populated.
+     */
+    bool getGroupStatistics(std::vector<GroupMemberStatistics>& members,
+                            int clear,
+                            int instantaneous,
+                            SRTSOCKET targetSystem = 0);
+
     /**
      *
      * Get active clients (A server method)
@@ -218,19 +552,757 @@ public:
     */
     Mode getCurrentMode() const;
 
+    // delete copy and move constructors and assign operators
+    SRTNetCore(SRTNetCore const&) = delete;            // Copy construct
+    SRTNetCore(SRTNetCore&&) = delete;                 // Move construct
+    SRTNetCore& operator=(SRTNetCore const&) = delete; // Copy assign
+    SRTNetCore& operator=(SRTNetCore&&) = delete;      // Move assign
+
+protected:
+    SRTNetCore();
+
+    /// Called from the accept thread for every new connection, return nullptr to reject the connection
+    virtual std::shared_ptr<NetworkConnection>
+    onClientConnected(struct sockaddr& sin, SRTSOCKET newSocket, std::shared_ptr<NetworkConnection>& ctx) = 0;
+
+    /// Called when a connection is closed, by the peer or by stop()
+    virtual void onClientDisconnected(std::shared_ptr<NetworkConnection>& ctx, SRTSOCKET socket) = 0;
+
+    /// Server receive loop, runs on its own thread for the lifetime of the server
+    virtual void serverEventHandler() = 0;
+
+    /// Client receive loop, runs on its own thread for the lifetime of the connection
+    virtual void clientWorker() = 0;
+
+    /// Dispatch worker loop, runs on its own thread when dispatching is used
+    virtual void dispatchWorker(SRTNetDispatchWorker& worker) = 0;
+
+    /// @return The dispatch queue of a server connection, nullptr if there is none. mClientListMtx must be held
+    SRTNetDispatchQueue* findDispatchQueue(SRTSOCKET socket);
+
+    /// Queue a received message for the dispatch worker of the connection
+    static void queueForDispatch(SRTNetDispatchQueue& queue, const uint8_t* data, size_t size,
+                                 const SRT_MSGCTRL& msgCtrl);
+
+    /// A server connection is gone, free its share of the admission limits and close its recording. mClientListMtx
+    /// must be held
+    void releaseConnection(SRTSOCKET socket);
+
+    /// Publish the server connections to sendData after mClientList changed. mClientListMtx must be held
+    void publishServerTargets();
+
+    /// Close a socket once no sendData can use it any more, unlink it from the send targets first
+    void retireSocket(SRTSOCKET socket);
+
+    /// Close the retired sockets a sender was still using at retireSocket, never blocks
+    void reclaimSockets() {
+        mEpoch.reclaim();
+    }
+
+    /// Record a received message of a server connection. mClientListMtx must be held
+    void recordReceived(SRTSOCKET socket, const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl);
+
+    /// Check a received message of a server connection as MPEG-TS. mClientListMtx must be held
+    void analyzeReceived(SRTSOCKET socket, const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl);
+
+    /// @return The time the sender handed a received message to SRT, now if SRT did not tell
+    static int64_t sourceTime(const SRT_MSGCTRL& msgCtrl) {
+        return msgCtrl.srctime ? msgCtrl.srctime : srt_time_now();
+    }
+
+    /// @return The callback time counters of a server connection, nullptr if there are none. mClientListMtx must be
+    /// held
+    SRTNetConnectionLoad* findConnectionLoad(SRTSOCKET socket);
+
+    /// No more messages for a server connection, the worker calls clientDisconnected once the queue is drained.
+    /// mClientListMtx must be held
+    void closeDispatchQueue(SRTSOCKET socket);
+
+    /// @return false if the server can not be started since there is no way to accept clients
+    virtual bool canAcceptClients() const {
+        return true;
+    }
+
+    /// @return false if ctx can not be used as the context of a client connection
+    virtual bool isValidClientContext(const std::shared_ptr<NetworkConnection>& ctx) const {
+        return true;
+    }
+
+    /// Log the last SRT error of a failed operation in the receive loops
+    static void logSrtError(const char* operation);
+
+    // Server active? true == yes
+    std::atomic<bool> mServerActive = {false};
+    // Client active? true == yes
+    std::atomic<bool> mClientActive = {false};
+
+    SRTSOCKET mContext = 0;
+    int mPollID = 0;
+    std::map<SRTSOCKET, std::shared_ptr<NetworkConnection>> mClientList = {};
+    std::mutex mClientListMtx;
+    std::shared_ptr<NetworkConnection> mClientContext = nullptr;
+    // true if the callbacks are run by the dispatch workers, fixed while the service runs
+    bool mDispatching = false;
+    std::shared_ptr<SRTNetDispatchQueue> mClientDispatchQueue = nullptr;
+    // true if the callback time is measured for overload detection, fixed while the service runs
+    bool mMonitoring = false;
+    std::shared_ptr<SRTNetConnectionLoad> mClientLoad = nullptr;
+    // true if the received messages are recorded, fixed while the service runs
+    bool mRecording = false;
+    std::shared_ptr<SRTNetRecording> mClientRecording = nullptr;
+    // true if the received messages are checked as MPEG-TS, fixed while the service runs
+    bool mAnalyzing = false;
+    std::shared_ptr<SRTNetTSAnalyzer> mClientAnalyzer = nullptr;
+
+private:
+    // Internal variables and methods
+
+    // Room for the members of a group in getGroupStatistics, larger groups get a second srt_group_data call
+    static constexpr size_t kGroupMembers = 16;
+
+    void waitForSRTClient(bool singleSender);
+
+    void closeAllClientSockets();
+
+    bool waitForSendBuffersToDrain(std::chrono::milliseconds timeout);
+
+    /// srt_listen_callback, called by SRT during the handshake of a caller
+    static int admissionCallback(void* opaque,
+                                 SRTSOCKET newSocket,
+                                 int hsVersion,
+                                 const struct sockaddr* peerAddress,
+                                 const char* streamId);
+
+    /// Check the limits for a caller, takes a token of the rate limit. mAdmissionMtx must be held
+    bool checkAdmissionLimits(const std::string& peerIP, bool takeToken);
+
+    /// Reserve a connection's share of the limits
+    /// @return false if the total or per IP limits are reached
+    bool admit(SRTSOCKET socket, const std::string& peerIP);
+
+    void releaseAdmission(SRTSOCKET socket);
+
+    void startDispatch();
+
+    /// Start a thread of a role, placed as configured with setThreadConfig
+    template <typename Function>
+    std::thread startThread(ThreadRole role, size_t index, Function&& function) {
+        return std::thread([this, role, index, function = std::forward<Function>(function)]() {
+            applyThreadConfig(role, index);
+            function();
+        });
+    }
+
+    void applyThreadConfig(ThreadRole role, size_t index) const;
+
+    /// Drain and join the dispatch workers, called without mNetMtx since the workers run the callbacks
+    void stopDispatch();
+
+    /// Drop the stopped dispatch workers, called with mNetMtx held
+    void releaseDispatch();
+
+    std::shared_ptr<SRTNetDispatchQueue> addDispatchQueue(SRTSOCKET socket,
+                                                          std::shared_ptr<NetworkConnection>& ctx,
+                                                          std::shared_ptr<SRTNetConnectionLoad> load);
+
+    void startOverloadMonitor();
+
+    void stopOverloadMonitor();
+
+    /// Start measuring a connection, nullptr if overload detection is not used. mClientListMtx must be held
+    std::shared_ptr<SRTNetConnectionLoad> addConnectionLoad(SRTSOCKET socket, std::shared_ptr<NetworkConnection>& ctx);
+
+    void overloadMonitor();
+
+    void checkOverload(std::chrono::steady_clock::duration elapsed);
+
+    std::thread mWorkerThread;
+    std::thread mEventThread;
+
+    bool mAllowGroupConnections = false;
+    std::string mPacketFilter;
+    mutable std::mutex mNetMtx;
+    // Held through stop, which joins the threads running the callbacks without mNetMtx
+    std::mutex mStopMtx;
+    // Atomic since sendData reads it without mNetMtx, changed under mNetMtx
+    std::atomic<Mode> mCurrentMode = {Mode::unknown};
+
+    /// The service as sendData sees it: stopped -> running when a start succeeded, running -> stopping -> stopped in
+    /// stop
+    enum class Lifecycle {
+        stopped,
+        running,
+        stopping
+    };
+    std::atomic<Lifecycle> mLifecycle = {Lifecycle::stopped};
+
+    /// What sendData may send to, replaced as a whole and retired through mEpoch when the connections change
+    struct SendTargets {
+        Mode mMode = Mode::unknown;
+        SRTSOCKET mClient = SRT_INVALID_SOCK;  // The connection of a client
+        std::vector<SRTSOCKET> mServerClients; // The connections of a server, sorted
+    };
+
+    /// Replace the send targets, nullptr == nothing can be sent
+    void publishSendTargets(std::unique_ptr<SendTargets> targets);
+
+    /// Stop sendData and wait for the senders still using a socket, called with mNetMtx held before stop closes them
+    void stopSending();
+
+    SRTNetEpoch mEpoch;
+    std::atomic<const SendTargets*> mSendTargets = {nullptr};
+    // The server connection in the clientConnected callback, not in mSendTargets yet but sendData may use it
+    std::atomic<SRTSOCKET> mConnectingSocket = {SRT_INVALID_SOCK};
+    std::shared_ptr<NetworkConnection> mConnectionContext = nullptr;
+    DispatchConfig mDispatchConfig;
+    std::map<ThreadRole, ThreadConfig> mThreadConfigs = {};
+    AdmissionConfig mAdmissionConfig;
+    std::mutex mAdmissionMtx;
+    AdmissionStatistics mAdmissionStats;
+    std::map<SRTSOCKET, std::string> mAdmittedPeers = {};
+    std::map<std::string, size_t> mConnectionsPerIP = {};
+    double mAdmissionTokens = 0.0;
+    std::chrono::steady_clock::time_point mAdmissionTokensUpdated;
+    std::vector<std::unique_ptr<SRTNetDispatchWorker>> mDispatchWorkers;
+    std::map<SRTSOCKET, std::shared_ptr<SRTNetDispatchQueue>> mDispatchQueues = {};
+    OverloadConfig mOverloadConfig;
+    OverloadCallback mOverloadCallback = nullptr;
+    std::map<SRTSOCKET, std::shared_ptr<SRTNetConnectionLoad>> mConnectionLoads = {};
+    std::thread mMonitorThread;
+    std::mutex mMonitorMtx;
+    std::condition_variable mMonitorCondition;
+    bool mMonitorActive = false;
+    std::shared_ptr<SRTNetRecorder> mRecorder = nullptr;
+    std::map<SRTSOCKET, std::shared_ptr<SRTNetRecording>> mRecordings = {};
+    std::optional<SRTNetTSAnalyzer::Config> mTSAnalysisConfig;
+    std::map<SRTSOCKET, std::shared_ptr<SRTNetTSAnalyzer>> mAnalyzers = {};
+};
+
+///
+/// @brief Time spent in the receive callbacks of one connection, measured when overload detection is used
+class SRTNetConnectionLoad {
+public:
+    SRTNetConnectionLoad(SRTSOCKET socket, std::shared_ptr<SRTNetCore::NetworkConnection> ctx)
+        : mSocket(socket)
+        , mCtx(std::move(ctx)) {
+    }
+
+    ///
+    /// @brief Add the duration of one callback, called by the thread running the callbacks of the connection
+    void addCallbackTime(std::chrono::steady_clock::duration duration) {
+        auto nanoseconds =
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+        mCallbackTime.fetch_add(nanoseconds, std::memory_order_relaxed);
+        if (nanoseconds > mMaxCallbackTime.load(std::memory_order_relaxed)) {
+            mMaxCallbackTime.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    ///
+    /// @brief Get and reset the callback time in ns since the last call, called by the monitor thread
+    void takeCallbackTime(uint64_t& callbackTime, uint64_t& maxCallbackTime) {
+        callbackTime = mCallbackTime.exchange(0, std::memory_order_relaxed);
+        maxCallbackTime = mMaxCallbackTime.exchange(0, std::memory_order_relaxed);
+    }
+
+    const SRTSOCKET mSocket;
+    std::shared_ptr<SRTNetCore::NetworkConnection> mCtx;
+    // Overload reported and not recovered yet, only used by the monitor thread
+    bool mOverloaded = false;
+
+private:
+    std::atomic<uint64_t> mCallbackTime = {0};
+    std::atomic<uint64_t> mMaxCallbackTime = {0};
+};
+
+///
+/// @brief Single producer single consumer message queue between the receive thread and the dispatch worker of one
+/// connection. The messages are copied into preallocated slots, nothing is allocated per message.
+class SRTNetDispatchQueue {
+public:
+    static constexpr size_t kMaxMessageSize = 2048;
+
+    struct Message {
+        SRT_MSGCTRL mMsgCtrl;
+        size_t mSize;
+        uint8_t mData[kMaxMessageSize];
+    };
+
+    SRTNetDispatchQueue(size_t capacity,
+                        SRTSOCKET socket,
+                        std::shared_ptr<SRTNetCore::NetworkConnection> ctx,
+                        SRTNetDispatchWorker& worker)
+        : mSocket(socket)
+        , mCtx(std::move(ctx))
+        , mWorker(worker) {
+        mCapacity = 1;
+        while (mCapacity < capacity) {
+            mCapacity <<= 1;
+        }
+        mMessages = std::make_unique<Message[]>(mCapacity);
+    }
+
+    ///
+    /// @brief Producer side, copy a message into the queue
+    /// @return false if the queue is full, the message is dropped and counted as an overflow
+    bool push(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+        size_t write = mWrite.load(std::memory_order_relaxed);
+        size_t read = mRead.load(std::memory_order_acquire);
+        if (write - read == mCapacity) {
+            mOverflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Message& message = mMessages[write & (mCapacity - 1)];
+        message.mMsgCtrl = msgCtrl;
+        message.mSize = size < kMaxMessageSize ? size : kMaxMessageSize;
+        std::memcpy(message.mData, data, message.mSize);
+        // Sequentially consistent, pairs with the worker announcing that it goes to sleep
+        mWrite.store(write + 1);
+        mQueued.fetch_add(1, std::memory_order_relaxed);
+        size_t depth = write + 1 - read;
+        if (depth > mMaxDepth.load(std::memory_order_relaxed)) {
+            mMaxDepth.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    ///
+    /// @brief Consumer side, get the oldest message
+    /// @return The oldest message, valid until pop is called, nullptr if the queue is empty
+    Message* front() {
+        size_t read = mRead.load(std::memory_order_relaxed);
+        if (read == mWrite.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &mMessages[read & (mCapacity - 1)];
+    }
+
+    ///
+    /// @brief Consumer side, release the oldest message
+    void pop() {
+        mRead.store(mRead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return mRead.load(std::memory_order_acquire) == mWrite.load();
+    }
+
+    ///
+    /// @brief Producer side, no more messages will be pushed
+    void close() {
+        mClosed = true;
+    }
+
+    bool isClosed() const {
+        return mClosed;
+    }
+
+    void getStatistics(SRTNetCore::DispatchStatistics& dispatchStats) const {
+        dispatchStats.mQueueDepth += mWrite.load() - mRead.load();
+        size_t maxDepth = mMaxDepth.load(std::memory_order_relaxed);
+        if (maxDepth > dispatchStats.mMaxQueueDepth) {
+            dispatchStats.mMaxQueueDepth = maxDepth;
+        }
+        dispatchStats.mQueued += mQueued.load(std::memory_order_relaxed);
+        dispatchStats.mOverflows += mOverflows.load(std::memory_order_relaxed);
+    }
+
+    const SRTSOCKET mSocket;
+    std::shared_ptr<SRTNetCore::NetworkConnection> mCtx;
+    SRTNetDispatchWorker& mWorker;
+    // Callback time counters of the connection, nullptr if overload detection is not used
+    std::shared_ptr<SRTNetConnectionLoad> mLoad = nullptr;
+
+private:
+    size_t mCapacity;
+    std::unique_ptr<Message[]> mMessages;
+    alignas(64) std::atomic<size_t> mWrite = {0};
+    alignas(64) std::atomic<size_t> mRead = {0};
+    std::atomic<bool> mClosed = {false};
+    std::atomic<size_t> mMaxDepth = {0};
+    std::atomic<uint64_t> mQueued = {0};
+    std::atomic<uint64_t> mOverflows = {0};
+};
+
+///
+/// @brief A dispatch worker thread and the connection queues it serves
+class SRTNetDispatchWorker {
+public:
+    void addQueue(const std::shared_ptr<SRTNetDispatchQueue>& queue) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueues.push_back(queue);
+        mVersion++;
+        mCondition.notify_one();
+    }
+
+    ///
+    /// @brief Remove a closed and drained queue, called by the worker thread
+    void removeQueue(const SRTNetDispatchQueue* queue) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto iterator = mQueues.begin(); iterator != mQueues.end(); ++iterator) {
+            if (iterator->get() == queue) {
+                mQueues.erase(iterator);
+                mVersion++;
+                break;
+            }
+        }
+    }
+
+    ///
+    /// @brief Get the queues to serve, only copies the list when it changed
+    void getQueues(std::vector<std::shared_ptr<SRTNetDispatchQueue>>& queues, uint64_t& version) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (version != mVersion) {
+            queues = mQueues;
+            version = mVersion;
+        }
+    }
+
+    size_t getQueueCount() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mQueues.size();
+    }
+
+    ///
+    /// @brief Wake the worker if it is waiting for work, called after a message is queued or a queue is closed
+    void wakeUp() {
+        if (mSleeping) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCondition.notify_one();
+        }
+    }
+
+    ///
+    /// @brief Wait until there is something to do in any of the queues
+    /// @return false when the worker is stopped and all its queues are gone
+    bool waitForWork(const std::vector<std::shared_ptr<SRTNetDispatchQueue>>& queues, uint64_t version) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mActive && mQueues.empty()) {
+            return false;
+        }
+        mSleeping = true;
+        bool pending = version != mVersion;
+        for (const auto& queue : queues) {
+            pending = pending || !queue->empty() || queue->isClosed();
+        }
+        if (!pending) {
+            // The timeout only guards the shutdown, messages and closed queues always wake the worker
+            mCondition.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        mSleeping = false;
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mActive = false;
+            mCondition.notify_one();
+        }
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+    }
+
+    std::thread mThread;
+
+private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<std::shared_ptr<SRTNetDispatchQueue>> mQueues;
+    uint64_t mVersion = 0;
+    bool mActive = true;
+    std::atomic<bool> mSleeping = {false};
+};
+
+///
+/// @brief SRTNet with the callbacks resolved at compile time. The Handler is a type with the static member functions
+/// below, the compiler can inline them into the receive loops. There is no std::function call per packet.
+///
+/// serverEventHandler, clientWorker and dispatchWorker do not allocate once connected, a packet is received into a
+/// buffer on the stack and handed to the Handler from there. Recording and overload detection are not covered.
+///
+/// struct Handler {
+///     // Accept or reject a connecting client (only server mode), return nullptr to reject. A client only Handler can
+///     // simply return nullptr
+///     static std::shared_ptr<SRTNetCore::NetworkConnection> clientConnected(SRTNetT<Handler>& net,
+///         struct sockaddr& sin, SRTSOCKET newSocket, std::shared_ptr<SRTNetCore::NetworkConnection>& ctx);
+///     // Data received, the data is only valid during the call
+///     static void receivedData(SRTNetT<Handler>& net, const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+///         std::shared_ptr<SRTNetCore::NetworkConnection>& ctx, SRTSOCKET socket);
+///     // A connection was closed (server and client mode)
+///     static void clientDisconnected(SRTNetT<Handler>& net, std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+///         SRTSOCKET socket);
+/// };
+///
+/// The handler functions are called from the SRTNet threads, the same way as the SRTNet callbacks.
+///
+/// A Handler can declare a typed connection context with a type alias, the type must derive from
+/// SRTNetCore::NetworkConnection:
+///
+/// struct Handler {
+///     using Context = MyConnection;
+///     static std::shared_ptr<MyConnection> clientConnected(SRTNetT<Handler>& net, struct sockaddr& sin,
+///         SRTSOCKET newSocket, std::shared_ptr<SRTNetCore::NetworkConnection>& ctx);
+///     static void receivedData(SRTNetT<Handler>& net, const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+///         MyConnection& ctx, SRTSOCKET socket);
+///     static void clientDisconnected(SRTNetT<Handler>& net, MyConnection& ctx, SRTSOCKET socket);
+/// };
+///
+/// The context object returned by clientConnected is the entry in the connection table, the receive loops hand it
+/// out with a static_cast, there is no std::any_cast or other type check per packet. In client mode the ctx given to
+/// startClient must be a MyConnection, this is checked once when the client is started.
+template <typename Handler>
+class SRTNetT : public SRTNetCore {
+    template <typename T, typename = void>
+    struct ContextOf {
+        using type = NetworkConnection;
+    };
+
+    template <typename T>
+    struct ContextOf<T, std::void_t<typename T::Context>> {
+        using type = typename T::Context;
+    };
+
+public:
+    /// The connection context type handed to the Handler
+    using Context = typename ContextOf<Handler>::type;
+    static_assert(std::is_base_of_v<NetworkConnection, Context>,
+                  "The Handler Context must derive from SRTNetCore::NetworkConnection");
+
+    SRTNetT() = default;
+
+    ~SRTNetT() override {
+        // Stop here, the receive loops and the handler must not run when this object is gone
+        stop();
+    }
+
+protected:
+    std::shared_ptr<NetworkConnection>
+    onClientConnected(struct sockaddr& sin, SRTSOCKET newSocket, std::shared_ptr<NetworkConnection>& ctx) override {
+        return Handler::clientConnected(*this, sin, newSocket, ctx);
+    }
+
+    void onClientDisconnected(std::shared_ptr<NetworkConnection>& ctx, SRTSOCKET socket) override {
+        if (mDispatching) {
+            closeDispatchQueue(socket);
+        } else {
+            dispatchDisconnected(ctx, socket);
+        }
+    }
+
+    bool isValidClientContext(const std::shared_ptr<NetworkConnection>& ctx) const override {
+        if constexpr (kTypedContext) {
+            return dynamic_cast<Context*>(ctx.get()) != nullptr;
+        } else {
+            return true;
+        }
+    }
+
+    void serverEventHandler() override {
+        SRT_EPOLL_EVENT ready[MAX_WORKERS];
+        while (mServerActive) {
+            reclaimSockets();
+            int ret = srt_epoll_uwait(mPollID, &ready[0], MAX_WORKERS, 1000);
+
+            if (ret > 0) {
+                for (int i = 0; i < ret; i++) {
+                    uint8_t msg[2048];
+                    SRT_MSGCTRL thisMSGCTRL = srt_msgctrl_default;
+                    SRTSOCKET thisSocket = ready[i].fd;
+                    int result = srt_recvmsg2(thisSocket, reinterpret_cast<char*>(msg), sizeof(msg), &thisMSGCTRL);
+
+                    std::lock_guard<std::mutex> lock(mClientListMtx);
+                    auto iterator = mClientList.find(thisSocket);
+                    if (result == SRT_ERROR) {
+                        logSrtError("srt_recvmsg2");
+                        if (iterator == mClientList.end()) {
+                            continue; // This client has already been removed by closeAllClientSockets()
+                        }
+                        auto ctx = iterator->second;
+                        mClientList.erase(iterator->first);
+                        publishServerTargets();
+                        releaseConnection(thisSocket);
+                        srt_epoll_remove_usock(mPollID, thisSocket);
+                        retireSocket(thisSocket);
+                        if (mDispatching) {
+                            closeDispatchQueue(thisSocket);
+                        } else {
+                            dispatchDisconnected(ctx, thisSocket);
+                        }
+                    } else if (result > 0 && iterator != mClientList.end()) {
+                        if (mRecording) {
+                            recordReceived(thisSocket, msg, result, thisMSGCTRL);
+                        }
+                        if (mAnalyzing) {
+                            analyzeReceived(thisSocket, msg, result, thisMSGCTRL);
+                        }
+                        if (mDispatching) {
+                            SRTNetDispatchQueue* queue = findDispatchQueue(thisSocket);
+                            if (queue) {
+                                queueForDispatch(*queue, msg, result, thisMSGCTRL);
+                            }
+                        } else {
+                            dispatchReceived(msg, result, thisMSGCTRL, iterator->second, thisSocket,
+                                             mMonitoring ? findConnectionLoad(thisSocket) : nullptr);
+                        }
+                    }
+                }
+                if (mClientList.empty()) {
+                    break;
+                }
+            } else if (ret == -1 && mServerActive) {
+                logSrtError("srt_epoll_uwait");
+            }
+        }
+    }
+
+    void clientWorker() override {
+        while (mClientActive) {
+            uint8_t msg[2048];
+            SRT_MSGCTRL thisMSGCTRL = srt_msgctrl_default;
+            int result = srt_recvmsg2(mContext, reinterpret_cast<char*>(msg), sizeof(msg), &thisMSGCTRL);
+            if (result == SRT_ERROR) {
+                if (mClientActive) {
+                    logSrtError("srt_recvmsg2");
+                }
+                if (mDispatching) {
+                    mClientDispatchQueue->close();
+                    mClientDispatchQueue->mWorker.wakeUp();
+                } else {
+                    dispatchDisconnected(mClientContext, mContext);
+                }
+                break;
+            } else if (result > 0) {
+                if (mClientRecording) {
+                    mClientRecording->write(msg, result, thisMSGCTRL);
+                }
+                if (mClientAnalyzer) {
+                    mClientAnalyzer->analyze(msg, result, sourceTime(thisMSGCTRL));
+                }
+                if (mDispatching) {
+                    queueForDispatch(*mClientDispatchQueue, msg, result, thisMSGCTRL);
+                } else {
+                    dispatchReceived(msg, result, thisMSGCTRL, mClientContext, mContext, mClientLoad.get());
+                }
+            }
+        }
+        mClientActive = false;
+    }
+
+    void dispatchWorker(SRTNetDispatchWorker& worker) override {
+        std::vector<std::shared_ptr<SRTNetDispatchQueue>> queues;
+        uint64_t version = 0;
+        do {
+            worker.getQueues(queues, version);
+            for (auto& queue : queues) {
+                // Read the closed flag first, everything queued before the queue was closed is then visible
+                bool closed = queue->isClosed();
+                // A bounded batch per queue, one busy connection must not starve the others of this worker
+                for (size_t i = 0; i < kDispatchBatch; ++i) {
+                    SRTNetDispatchQueue::Message* message = queue->front();
+                    if (!message) {
+                        break;
+                    }
+                    dispatchReceived(message->mData, message->mSize, message->mMsgCtrl, queue->mCtx,
+                                     queue->mSocket, queue->mLoad.get());
+                    queue->pop();
+                }
+                if (closed && queue->empty()) {
+                    dispatchDisconnected(queue->mCtx, queue->mSocket);
+                    worker.removeQueue(queue.get());
+                }
+            }
+        } while (worker.waitForWork(queues, version));
+    }
+
+private:
+    static constexpr bool kTypedContext = !std::is_same_v<Context, NetworkConnection>;
+    static constexpr size_t kDispatchBatch = 32;
+
+    inline void dispatchReceived(const uint8_t* data,
+                                 size_t size,
+                                 SRT_MSGCTRL& msgCtrl,
+                                 std::shared_ptr<NetworkConnection>& ctx,
+                                 SRTSOCKET socket,
+                                 SRTNetConnectionLoad* load) {
+        if (load) {
+            auto start = std::chrono::steady_clock::now();
+            callReceived(data, size, msgCtrl, ctx, socket);
+            load->addCallbackTime(std::chrono::steady_clock::now() - start);
+        } else {
+            callReceived(data, size, msgCtrl, ctx, socket);
+        }
+    }
+
+    inline void callReceived(const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             std::shared_ptr<NetworkConnection>& ctx,
+                             SRTSOCKET socket) {
+        if constexpr (kTypedContext) {
+            Handler::receivedData(*this, data, size, msgCtrl, static_cast<Context&>(*ctx), socket);
+        } else {
+            Handler::receivedData(*this, data, size, msgCtrl, ctx, socket);
+        }
+    }
+
+    inline void dispatchDisconnected(std::shared_ptr<NetworkConnection>& ctx, SRTSOCKET socket) {
+        if constexpr (kTypedContext) {
+            Handler::clientDisconnected(*this, static_cast<Context&>(*ctx), socket);
+        } else {
+            Handler::clientDisconnected(*this, ctx, socket);
+        }
+    }
+};
+
+class SRTNet;
+
+///
+/// @brief The Handler of SRTNet, forwards to the std::function callbacks of SRTNet
+struct SRTNetCallbackHandler {
+    static std::shared_ptr<SRTNetCore::NetworkConnection>
+    clientConnected(SRTNetT<SRTNetCallbackHandler>& net,
+                    struct sockaddr& sin,
+                    SRTSOCKET newSocket,
+                    std::shared_ptr<SRTNetCore::NetworkConnection>& ctx);
+
+    static void receivedData(SRTNetT<SRTNetCallbackHandler>& net,
+                             const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                             SRTSOCKET socket);
+
+    static void clientDisconnected(SRTNetT<SRTNetCallbackHandler>& net,
+                                   std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                                   SRTSOCKET socket);
+};
+
+extern template class SRTNetT<SRTNetCallbackHandler>;
+
+///
+/// @brief SRTNet with the callbacks set at runtime through std::function members
+class SRTNet : public SRTNetT<SRTNetCallbackHandler> {
+public:
+    SRTNet() = default;
+
+    ~SRTNet() override;
+
     /// Callback handling connecting clients (only server mode)
     std::function<std::shared_ptr<NetworkConnection>(struct sockaddr& sin,
                                                      SRTSOCKET newSocket,
                                                      std::shared_ptr<NetworkConnection>& ctx)>
         clientConnected = nullptr;
-    /// Callback receiving data type vector
+    /// Callback receiving data type vector. Move the vector out of data to keep it, a vector left in data is reused
+    /// for the next message. Taking it allocates a new vector for the next message
     std::function<void(std::unique_ptr<std::vector<uint8_t>>& data,
                        SRT_MSGCTRL& msgCtrl,
                        std::shared_ptr<NetworkConnection>& ctx,
                        SRTSOCKET socket)>
         receivedData = nullptr;
 
-    /// Callback receiving data no copy
+    /// Callback receiving data no copy, the receive path does not allocate
     std::function<void(const uint8_t* data,
                        size_t size,
                        SRT_MSGCTRL& msgCtrl,
@@ -241,38 +1313,7 @@ public:
     /// Callback handling disconnecting clients (server and client mode)
     std::function<void(std::shared_ptr<NetworkConnection>& ctx, SRTSOCKET lSocket)> clientDisconnected = nullptr;
 
-    // delete copy and move constructors and assign operators
-    SRTNet(SRTNet const&) = delete;            // Copy construct
-    SRTNet(SRTNet&&) = delete;                 // Move construct
-    SRTNet& operator=(SRTNet const&) = delete; // Copy assign
-    SRTNet& operator=(SRTNet&&) = delete;      // Move assign
-
-private:
-    // Internal variables and methods
-
-    void waitForSRTClient(bool singleSender);
-
-    void serverEventHandler();
-
-    void clientWorker();
-
-    void closeAllClientSockets();
-
-    // Server active? true == yes
-    std::atomic<bool> mServerActive = {false};
-    // Client active? true == yes
-    std::atomic<bool> mClientActive = {false};
-
-    std::thread mWorkerThread;
-    std::thread mEventThread;
-
-    SRTSOCKET mContext = 0;
-    int mPollID = 0;
-    mutable std::mutex mNetMtx;
-    Mode mCurrentMode = Mode::unknown;
-    std::map<SRTSOCKET, std::shared_ptr<NetworkConnection>> mClientList = {};
-    std::mutex mClientListMtx;
-    std::shared_ptr<NetworkConnection> mClientContext = nullptr;
-    std::shared_ptr<NetworkConnection> mConnectionContext = nullptr;
+protected:
+    bool canAcceptClients() const override;
 };
 
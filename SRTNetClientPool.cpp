@@ -0,0 +1,299 @@
+//
+// Many outgoing SRT connections received on a few epoll threads
+//
+
+#include "SRTNetClientPool.h"
+
+#include "SRTNetInternal.h"
+
+namespace {
+
+// Ready sockets taken from the epoll per wakeup
+constexpr int kMaxEvents = 64;
+
+} // namespace
+
+SRTNetClientPool::SRTNetClientPool() : SRTNetClientPool(Config()) {
+}
+
+SRTNetClientPool::SRTNetClientPool(const Config& config) : mConfig(config) {
+}
+
+SRTNetClientPool::~SRTNetClientPool() {
+    stop();
+}
+
+SRTSOCKET SRTNetClientPool::addClient(const std::string& host,
+                                      uint16_t port,
+                                      int reorder,
+                                      int32_t latency,
+                                      int overhead,
+                                      std::shared_ptr<SRTNetCore::NetworkConnection> ctx,
+                                      int mtu,
+                                      int32_t peerIdleTimeout,
+                                      const std::string& psk) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mActive) {
+            SRT_LOGGER(true, LOGG_ERROR, "The client pool is stopped");
+            return SRT_INVALID_SOCK;
+        }
+        if (mReactors.empty() && !startReactors()) {
+            return SRT_INVALID_SOCK;
+        }
+    }
+
+    std::optional<std::pair<sockaddr_storage, int>> address = SRTNetInternal::resolveAddress(host, port);
+    if (!address.has_value()) {
+        return SRT_INVALID_SOCK;
+    }
+
+    SRTSOCKET socket = srt_create_socket();
+    if (socket == SRT_INVALID_SOCK) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_socket: " << srt_getlasterror_str());
+        return SRT_INVALID_SOCK;
+    }
+    int32_t yes = 1;
+    if (srt_setsockflag(socket, SRTO_SENDER, &yes, sizeof(yes)) == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_setsockflag SRTO_SENDER: " << srt_getlasterror_str());
+        srt_close(socket);
+        return SRT_INVALID_SOCK;
+    }
+    if (!SRTNetInternal::applySocketOptions(socket, reorder, latency, overhead, mtu, peerIdleTimeout, psk, "")) {
+        srt_close(socket);
+        return SRT_INVALID_SOCK;
+    }
+    if (srt_connect(socket, reinterpret_cast<sockaddr*>(&address->first), address->second) == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_connect to " << host << ":" << port << " failed: " << srt_getlasterror_str());
+        srt_close(socket);
+        return SRT_INVALID_SOCK;
+    }
+    // The connect above blocks, the receives of the reactors must not
+    int32_t no = 0;
+    if (srt_setsockflag(socket, SRTO_RCVSYN, &no, sizeof(no)) == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_setsockflag SRTO_RCVSYN: " << srt_getlasterror_str());
+        srt_close(socket);
+        return SRT_INVALID_SOCK;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mActive) {
+        // Stopped while connecting
+        srt_close(socket);
+        return SRT_INVALID_SOCK;
+    }
+    Reactor* reactor = mReactors.front().get();
+    for (auto& candidate : mReactors) {
+        if (candidate->mConnections < reactor->mConnections) {
+            reactor = candidate.get();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> reactorLock(reactor->mMutex);
+        reactor->mClients[socket] = std::move(ctx);
+    }
+    const int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+    if (srt_epoll_add_usock(reactor->mPollId, socket, &events) == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_epoll_add_usock: " << srt_getlasterror_str());
+        std::lock_guard<std::mutex> reactorLock(reactor->mMutex);
+        reactor->mClients.erase(socket);
+        srt_close(socket);
+        return SRT_INVALID_SOCK;
+    }
+    reactor->mConnections++;
+    mSockets[socket] = reactor;
+    return socket;
+}
+
+bool SRTNetClientPool::removeClient(SRTSOCKET socket) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto iterator = mSockets.find(socket);
+        if (iterator == mSockets.end()) {
+            return false;
+        }
+        Reactor* reactor = iterator->second;
+        mSockets.erase(iterator);
+        reactor->mConnections--;
+        srt_epoll_remove_usock(reactor->mPollId, socket);
+        std::lock_guard<std::mutex> reactorLock(reactor->mMutex);
+        reactor->mClients.erase(socket);
+    }
+    if (srt_close(socket) == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_close failed: " << srt_getlasterror_str());
+    }
+    return true;
+}
+
+bool SRTNetClientPool::sendData(const uint8_t* data, size_t size, SRT_MSGCTRL* msgCtrl, SRTSOCKET socket) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mSockets.find(socket) == mSockets.end()) {
+            SRT_LOGGER(true, LOGG_WARN, "Can't send data, the socket is not a connection of the pool.");
+            return false;
+        }
+    }
+    // A connection closed meanwhile fails in srt_sendmsg2, SRT does not reuse socket ids
+    int result = srt_sendmsg2(socket, reinterpret_cast<const char*>(data), static_cast<int>(size), msgCtrl);
+    if (result == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_sendmsg2 failed: " << srt_getlasterror_str());
+        return false;
+    }
+    if (static_cast<size_t>(result) != size) {
+        SRT_LOGGER(true, LOGG_ERROR, "Failed sending all data");
+        return false;
+    }
+    return true;
+}
+
+bool SRTNetClientPool::getStatistics(SRT_TRACEBSTATS* currentStats, int clear, int instantaneous, SRTSOCKET socket) {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mSockets.find(socket) == mSockets.end()) {
+            SRT_LOGGER(true, LOGG_ERROR, "Statistics not available");
+            return false;
+        }
+    }
+    if (srt_bistats(socket, currentStats, clear, instantaneous) == SRT_ERROR) {
+        SRT_LOGGER(true, LOGG_ERROR, "srt_bistats failed: " << srt_getlasterror_str());
+        return false;
+    }
+    return true;
+}
+
+SRTNetClientPool::Statistics SRTNetClientPool::getPoolStatistics() const {
+    Statistics stats;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        stats.mConnections = mSockets.size();
+        stats.mThreads = mReactors.size();
+    }
+    stats.mMessages = mMessages.load(std::memory_order_relaxed);
+    stats.mWakeups = mWakeups.load(std::memory_order_relaxed);
+    stats.mDisconnects = mDisconnects.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SRTNetClientPool::stop() {
+    std::vector<std::unique_ptr<Reactor>> reactors;
+    std::map<SRTSOCKET, Reactor*> sockets;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = false;
+        reactors.swap(mReactors);
+        sockets.swap(mSockets);
+    }
+    // The reactors see mActive within the epoll timeout
+    for (auto& reactor : reactors) {
+        if (reactor->mThread.joinable()) {
+            reactor->mThread.join();
+        }
+    }
+    for (auto& socket : sockets) {
+        srt_close(socket.first);
+    }
+    for (auto& reactor : reactors) {
+        srt_epoll_release(reactor->mPollId);
+    }
+}
+
+bool SRTNetClientPool::startReactors() {
+    if (mConfig.mThreads == 0 || mConfig.mReceiveBatch == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The client pool needs at least one thread and a receive batch of 1");
+        return false;
+    }
+    for (size_t i = 0; i < mConfig.mThreads; ++i) {
+        auto reactor = std::make_unique<Reactor>();
+        reactor->mPollId = srt_epoll_create();
+        if (reactor->mPollId == SRT_ERROR) {
+            SRT_LOGGER(true, LOGG_ERROR, "srt_epoll_create: " << srt_getlasterror_str());
+            break;
+        }
+        // Reactors without connections wait for the timeout instead of failing
+        srt_epoll_set(reactor->mPollId, SRT_EPOLL_ENABLE_EMPTY);
+        mReactors.push_back(std::move(reactor));
+    }
+    if (mReactors.size() != mConfig.mThreads) {
+        for (auto& reactor : mReactors) {
+            srt_epoll_release(reactor->mPollId);
+        }
+        mReactors.clear();
+        return false;
+    }
+    for (auto& reactor : mReactors) {
+        Reactor* self = reactor.get();
+        reactor->mThread = std::thread([this, self]() { reactorWorker(*self); });
+    }
+    return true;
+}
+
+void SRTNetClientPool::reactorWorker(Reactor& reactor) {
+    SRT_EPOLL_EVENT ready[kMaxEvents];
+    uint8_t msg[2048];
+    while (mActive) {
+        int count = srt_epoll_uwait(reactor.mPollId, ready, kMaxEvents, 100);
+        if (count <= 0) {
+            if (count == SRT_ERROR && mActive && srt_getlasterror(nullptr) != SRT_ETIMEOUT) {
+                SRT_LOGGER(true, LOGG_ERROR, "srt_epoll_uwait error: " << srt_getlasterror_str());
+            }
+            continue;
+        }
+        mWakeups.fetch_add(1, std::memory_order_relaxed);
+        for (int i = 0; i < count; ++i) {
+            SRTSOCKET socket = ready[i].fd;
+            std::shared_ptr<SRTNetCore::NetworkConnection> ctx;
+            {
+                std::lock_guard<std::mutex> lock(reactor.mMutex);
+                auto iterator = reactor.mClients.find(socket);
+                if (iterator == reactor.mClients.end()) {
+                    continue; // Removed after the epoll reported it
+                }
+                ctx = iterator->second;
+            }
+            // Drain up to a batch so a busy connection does not starve the others of the reactor
+            for (size_t received = 0; received < mConfig.mReceiveBatch; ++received) {
+                SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+                int result = srt_recvmsg2(socket, reinterpret_cast<char*>(msg), sizeof(msg), &msgCtrl);
+                if (result == SRT_ERROR) {
+                    if (srt_getlasterror(nullptr) != SRT_EASYNCRCV) {
+                        disconnect(reactor, socket);
+                    }
+                    break;
+                }
+                if (result > 0) {
+                    mMessages.fetch_add(1, std::memory_order_relaxed);
+                    if (receivedDataNoCopy) {
+                        receivedDataNoCopy(msg, result, msgCtrl, ctx, socket);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SRTNetClientPool::disconnect(Reactor& reactor, SRTSOCKET socket) {
+    std::string error = srt_getlasterror_str();
+    std::shared_ptr<SRTNetCore::NetworkConnection> ctx;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto iterator = mSockets.find(socket);
+        if (iterator == mSockets.end()) {
+            return; // Removed by removeClient or stop
+        }
+        mSockets.erase(iterator);
+        reactor.mConnections--;
+        srt_epoll_remove_usock(reactor.mPollId, socket);
+        std::lock_guard<std::mutex> reactorLock(reactor.mMutex);
+        auto client = reactor.mClients.find(socket);
+        if (client != reactor.mClients.end()) {
+            ctx = std::move(client->second);
+            reactor.mClients.erase(client);
+        }
+    }
+    SRT_LOGGER(true, LOGG_NOTIFY, "Client pool connection " << socket << " lost: " << error);
+    srt_close(socket);
+    mDisconnects.fetch_add(1, std::memory_order_relaxed);
+    if (clientDisconnected) {
+        clientDisconnected(ctx, socket);
+    }
+}
@@ -0,0 +1,149 @@
+//
+// Many outgoing SRT connections received on a few epoll threads
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SRTNet.h"
+
+///
+/// @brief Owns any number of client connections and receives them on a small number of reactor threads. An SRTNet
+/// client has a receive thread of its own, a pool of hundreds of connections has Config::mThreads. Every connection
+/// keeps its own context, the callbacks get the context and the socket of the connection the message came on.
+///
+/// Connections are spread over the reactors by the number of connections each one has, a reactor drains up to
+/// mReceiveBatch messages from a ready socket before it moves on to the next.
+///
+/// The callbacks are called from the reactor threads, a slow callback holds up the other connections of its reactor.
+///
+/// SRTNetClientPool pool;
+/// pool.receivedDataNoCopy = [](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+///                              std::shared_ptr<SRTNetCore::NetworkConnection>& ctx, SRTSOCKET socket) { ... };
+/// SRTSOCKET socket = pool.addClient("127.0.0.1", 8000, 16, 1000, 100, myContext, SRT_LIVE_MAX_PLSIZE);
+/// pool.sendData(data, size, &msgCtrl, socket);
+class SRTNetClientPool {
+public:
+    struct Config {
+        size_t mThreads = 2;        // Reactor threads
+        size_t mReceiveBatch = 16;  // Messages read from one socket before the next ready socket is served
+    };
+
+    struct Statistics {
+        size_t mConnections = 0;    // Connections now
+        size_t mThreads = 0;        // Reactor threads
+        uint64_t mMessages = 0;     // Messages received
+        uint64_t mWakeups = 0;      // Returns from srt_epoll_uwait with at least one ready socket
+        uint64_t mDisconnects = 0;  // Connections lost, removeClient is not counted
+    };
+
+    SRTNetClientPool();
+
+    explicit SRTNetClientPool(const Config& config);
+
+    /// Closes all connections
+    ~SRTNetClientPool();
+
+    ///
+    /// @brief Connect to a server and receive the connection on the least loaded reactor. The connect blocks, the
+    /// callbacks must be set before the first client is added
+    /// @param host Host IP or name to connect to
+    /// @param port Port to connect to
+    /// @param reorder Number of packets in the reorder window
+    /// @param latency Max re-send window (ms) / also the delay of transmission
+    /// @param overhead % extra of the BW that will be allowed for re-transmission packets
+    /// @param ctx The context of the connection, passed to the callbacks
+    /// @param mtu Sets the MTU
+    /// @param peerIdleTimeout Optional Connection considered broken if no packet received before this timeout.
+    /// @param psk Optional Pre Shared Key (AES-128)
+    /// @return The socket of the connection, SRT_INVALID_SOCK if the connect failed
+    SRTSOCKET addClient(const std::string& host,
+                        uint16_t port,
+                        int reorder,
+                        int32_t latency,
+                        int overhead,
+                        std::shared_ptr<SRTNetCore::NetworkConnection> ctx,
+                        int mtu,
+                        int32_t peerIdleTimeout = 5000,
+                        const std::string& psk = "");
+
+    ///
+    /// @brief Close a connection, clientDisconnected is not called for it
+    /// @return false if the socket is not a connection of the pool
+    bool removeClient(SRTSOCKET socket);
+
+    ///
+    /// @brief Send data on a connection of the pool
+    /// @param data pointer to the data
+    /// @param size size of the data
+    /// @param msgCtrl pointer to a SRT_MSGCTRL struct
+    /// @param socket the connection to send on
+    /// @return true if the data was sent
+    bool sendData(const uint8_t* data, size_t size, SRT_MSGCTRL* msgCtrl, SRTSOCKET socket);
+
+    ///
+    /// @brief Get the SRT statistics of a connection of the pool
+    /// @return false if the socket is not a connection of the pool or srt_bistats failed
+    bool getStatistics(SRT_TRACEBSTATS* currentStats, int clear, int instantaneous, SRTSOCKET socket);
+
+    Statistics getPoolStatistics() const;
+
+    ///
+    /// @brief Close all connections and stop the reactor threads. The pool can not be used after stop
+    void stop();
+
+    /// Called from a reactor thread for every message received
+    std::function<void(const uint8_t* data,
+                       size_t size,
+                       SRT_MSGCTRL& msgCtrl,
+                       std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                       SRTSOCKET socket)>
+        receivedDataNoCopy = nullptr;
+
+    /// Called from a reactor thread when a connection is lost, the socket is closed and removed from the pool
+    std::function<void(std::shared_ptr<SRTNetCore::NetworkConnection>& ctx, SRTSOCKET socket)> clientDisconnected =
+        nullptr;
+
+    // delete copy and move constructors and assign operators
+    SRTNetClientPool(SRTNetClientPool const&) = delete;
+    SRTNetClientPool(SRTNetClientPool&&) = delete;
+    SRTNetClientPool& operator=(SRTNetClientPool const&) = delete;
+    SRTNetClientPool& operator=(SRTNetClientPool&&) = delete;
+
+private:
+    struct Reactor {
+        int mPollId = -1;
+        std::thread mThread;
+        std::mutex mMutex;
+        std::map<SRTSOCKET, std::shared_ptr<SRTNetCore::NetworkConnection>> mClients;
+        size_t mConnections = 0; // Guarded by the pool mutex, used to pick the least loaded reactor
+    };
+
+    /// Create the reactors, called with mMutex held
+    bool startReactors();
+
+    void reactorWorker(Reactor& reactor);
+
+    /// A connection of reactor failed, close it and tell the user
+    void disconnect(Reactor& reactor, SRTSOCKET socket);
+
+    Config mConfig;
+    std::atomic<bool> mActive = {true};
+
+    mutable std::mutex mMutex;
+    std::vector<std::unique_ptr<Reactor>> mReactors;
+    std::map<SRTSOCKET, Reactor*> mSockets;
+
+    std::atomic<uint64_t> mMessages = {0};
+    std::atomic<uint64_t> mWakeups = {0};
+    std::atomic<uint64_t> mDisconnects = {0};
+};
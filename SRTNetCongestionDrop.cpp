@@ -0,0 +1,226 @@
+//
+// Drops the MPEG-TS packets that matter least before they enter SRT when the send buffer fills up
+//
+
+#include "SRTNetCongestionDrop.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "SRTNetInternal.h"
+#include "SRTNetTS.h"
+
+namespace {
+
+/// @return The offset of the payload of a TS packet, kPacketSize if it has none
+size_t payloadOffset(const uint8_t* packet) {
+    if (!(packet[3] & 0x10)) {
+        return SRTNetTS::kPacketSize;
+    }
+    size_t offset = 4;
+    if (packet[3] & 0x20) {
+        offset += 1 + packet[4];
+    }
+    return std::min(offset, SRTNetTS::kPacketSize);
+}
+
+} // namespace
+
+bool SRTNetCongestionDrop::start(const Config& config) {
+    if (config.mInterval.count() <= 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The send buffer check interval must be positive");
+        return false;
+    }
+    if (config.mHighBufferMs <= 0 && config.mHighBufferPackets <= 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "Congestion drop needs at least one high threshold");
+        return false;
+    }
+    if ((config.mHighBufferMs > 0 && config.mLowBufferMs > config.mHighBufferMs) ||
+        (config.mHighBufferPackets > 0 && config.mLowBufferPackets > config.mHighBufferPackets)) {
+        SRT_LOGGER(true, LOGG_ERROR, "A congestion low threshold is above its high threshold");
+        return false;
+    }
+    for (uint16_t pid : config.mLowPriorityPids) {
+        if (pid >= mPids.size() || config.mVideoPids.count(pid)) {
+            SRT_LOGGER(true, LOGG_ERROR, "Invalid low priority PID " << pid);
+            return false;
+        }
+    }
+    for (const auto& video : config.mVideoPids) {
+        if (video.first >= mPids.size()) {
+            SRT_LOGGER(true, LOGG_ERROR, "Invalid video PID " << video.first);
+            return false;
+        }
+    }
+    mConfig = config;
+    mPids.fill(PidState());
+    mVideo.clear();
+    for (uint16_t pid : config.mLowPriorityPids) {
+        mPids[pid].mLowPriority = true;
+    }
+    for (const auto& video : config.mVideoPids) {
+        mPids[video.first].mVideo = true;
+        mPids[video.first].mCodec = video.second;
+        mVideo.push_back(video.first);
+    }
+    mCongested = false;
+    mPublishedCongested = false;
+    mLastCheck = 0;
+    return true;
+}
+
+bool SRTNetCongestionDrop::sendData(SRTNetCore& net,
+                                    const uint8_t* data,
+                                    size_t size,
+                                    SRT_MSGCTRL* msgCtrl,
+                                    SRTSOCKET targetSystem) {
+    checkCongestion(net, targetSystem);
+    if (size > SRT_LIVE_MAX_PLSIZE || !SRTNetTS::isTransportStream(data, size)) {
+        return net.sendData(data, size, msgCtrl, targetSystem);
+    }
+    if (!mCongested) {
+        mSentPackets.fetch_add(size / SRTNetTS::kPacketSize, std::memory_order_relaxed);
+        return net.sendData(data, size, msgCtrl, targetSystem);
+    }
+    uint8_t kept[SRT_LIVE_MAX_PLSIZE];
+    size_t keptSize = 0;
+    for (size_t offset = 0; offset < size; offset += SRTNetTS::kPacketSize) {
+        if (!dropPacket(data + offset)) {
+            std::memcpy(kept + keptSize, data + offset, SRTNetTS::kPacketSize);
+            keptSize += SRTNetTS::kPacketSize;
+        }
+    }
+    if (keptSize == 0) {
+        return true;
+    }
+    mSentPackets.fetch_add(keptSize / SRTNetTS::kPacketSize, std::memory_order_relaxed);
+    return net.sendData(kept, keptSize, msgCtrl, targetSystem);
+}
+
+SRTNetCongestionDrop::Statistics SRTNetCongestionDrop::getStatistics() const {
+    Statistics stats;
+    stats.mSentPackets = mSentPackets.load(std::memory_order_relaxed);
+    stats.mDroppedLowPriority = mDroppedLowPriority.load(std::memory_order_relaxed);
+    stats.mDroppedNonReference = mDroppedNonReference.load(std::memory_order_relaxed);
+    stats.mDroppedFrames = mDroppedFrames.load(std::memory_order_relaxed);
+    stats.mCongestionEvents = mCongestionEvents.load(std::memory_order_relaxed);
+    stats.mCongested = mPublishedCongested.load(std::memory_order_relaxed);
+    stats.mBufferMs = mBufferMs.load(std::memory_order_relaxed);
+    stats.mBufferPackets = mBufferPackets.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SRTNetCongestionDrop::checkCongestion(SRTNetCore& net, SRTSOCKET targetSystem) {
+    int64_t now = srt_time_now();
+    if (mLastCheck != 0 &&
+        now - mLastCheck < std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mInterval).count()) {
+        return;
+    }
+    mLastCheck = now;
+    SRT_TRACEBSTATS stats;
+    if (!net.getStatistics(&stats, SRTNetClearStats::no, SRTNetInstant::yes, targetSystem)) {
+        return;
+    }
+    mBufferMs.store(stats.msSndBuf, std::memory_order_relaxed);
+    mBufferPackets.store(stats.pktSndBuf, std::memory_order_relaxed);
+    bool high = (mConfig.mHighBufferMs > 0 && stats.msSndBuf > mConfig.mHighBufferMs) ||
+                (mConfig.mHighBufferPackets > 0 && stats.pktSndBuf > mConfig.mHighBufferPackets);
+    bool low = (mConfig.mHighBufferMs <= 0 || stats.msSndBuf <= mConfig.mLowBufferMs) &&
+               (mConfig.mHighBufferPackets <= 0 || stats.pktSndBuf <= mConfig.mLowBufferPackets);
+    if (!mCongested && high) {
+        mCongested = true;
+        mCongestionEvents.fetch_add(1, std::memory_order_relaxed);
+        SRT_LOGGER(true, LOGG_WARN, "Send buffer congested at " << stats.msSndBuf << " ms, dropping");
+    } else if (mCongested && low) {
+        mCongested = false;
+        // The frames are classified again when the next congestion starts
+        for (uint16_t pid : mVideo) {
+            mPids[pid].mSearching = false;
+            mPids[pid].mDropping = false;
+        }
+        SRT_LOGGER(true, LOGG_NOTIFY, "Send buffer recovered at " << stats.msSndBuf << " ms");
+    }
+    mPublishedCongested.store(mCongested, std::memory_order_relaxed);
+}
+
+bool SRTNetCongestionDrop::dropPacket(const uint8_t* packet) {
+    PidState& state = mPids[SRTNetTS::pid(packet)];
+    if (!state.mLowPriority && !state.mVideo) {
+        return false;
+    }
+    if (state.mVideo) {
+        const size_t payload = payloadOffset(packet);
+        const uint8_t* data = packet + payload;
+        const size_t size = SRTNetTS::kPacketSize - payload;
+        Frame frame = Frame::unknown;
+        if (packet[1] & 0x40) {
+            // A new PES packet, the picture follows the PES header
+            if (size >= 9 && data[0] == 0 && data[1] == 0 && data[2] == 1 && 9u + data[8] < size) {
+                frame = classify(state, data + 9 + data[8], size - 9 - data[8]);
+            }
+            state.mSearching = frame == Frame::unknown;
+            state.mDropping = false;
+        } else if (state.mSearching && size > 0) {
+            frame = classify(state, data, size);
+            state.mSearching = frame == Frame::unknown;
+        }
+        if (frame == Frame::nonReference) {
+            state.mDropping = true;
+            mDroppedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!state.mDropping) {
+            return false;
+        }
+    }
+    // The receiver needs every PCR
+    if (SRTNetTS::hasPcr(packet)) {
+        return false;
+    }
+    if (state.mLowPriority) {
+        mDroppedLowPriority.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mDroppedNonReference.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+SRTNetCongestionDrop::Frame SRTNetCongestionDrop::classify(const PidState& state,
+                                                           const uint8_t* data,
+                                                           size_t size) const {
+    // Start codes split over two packets are missed, the frame is then sent
+    for (size_t i = 0; i + 3 < size; ++i) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) {
+            continue;
+        }
+        const uint8_t header = data[i + 3];
+        switch (state.mCodec) {
+            case Codec::h264: {
+                // Slices of non-IDR and IDR pictures, nal_ref_idc 0 == not used for reference
+                const uint8_t type = header & 0x1f;
+                if (type == 1 || type == 5) {
+                    return (header & 0x60) ? Frame::reference : Frame::nonReference;
+                }
+                break;
+            }
+            case Codec::hevc: {
+                // VCL NAL units, the even types up to RSV_VCL_N14 are sub-layer non-reference pictures. That is
+                // exact for streams with one temporal sub-layer, the common case for live contribution
+                const uint8_t type = (header >> 1) & 0x3f;
+                if (type < 32) {
+                    return (type <= 14 && type % 2 == 0) ? Frame::nonReference : Frame::reference;
+                }
+                break;
+            }
+            case Codec::mpeg2:
+                // Picture start code, picture_coding_type 3 == B
+                if (header == 0x00) {
+                    if (i + 5 >= size) {
+                        return Frame::unknown;
+                    }
+                    return ((data[i + 5] >> 3) & 0x07) == 3 ? Frame::nonReference : Frame::reference;
+                }
+                break;
+        }
+    }
+    return Frame::unknown;
+}
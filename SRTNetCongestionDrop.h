@@ -0,0 +1,122 @@
+//
+// Drops the MPEG-TS packets that matter least before they enter SRT when the send buffer fills up
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "SRTNet.h"
+
+///
+/// @brief Sends MPEG-TS messages and reacts to a congested link. SRT drops the packets that are too late without
+/// knowing what they carry, a lost I-frame takes the whole GOP with it. Once the send buffer of the connection is above
+/// the high threshold the packets that matter least are dropped here instead, before they enter SRT:
+/// - Packets of mLowPriorityPids, as long as the link is congested
+/// - Whole non-reference frames (B-frames and other pictures no other picture is predicted from) of mVideoPids. A
+///   frame is classified at the start of its PES packet, a frame that started before the congestion is sent whole
+///
+/// Packets carrying a PCR are never dropped. The send buffer is read with getStatistics every mInterval, the link is
+/// no longer congested once all enabled values are at or below their low thresholds. Messages that are not a whole
+/// number of TS packets are sent as they are.
+///
+/// Call sendData from one thread at a time.
+///
+/// SRTNetCongestionDrop dropper;
+/// SRTNetCongestionDrop::Config config;
+/// config.mHighBufferMs = 300;
+/// config.mLowBufferMs = 100;
+/// config.mVideoPids[0x100] = SRTNetCongestionDrop::Codec::h264;
+/// config.mLowPriorityPids = {0x102};
+/// dropper.start(config);
+/// dropper.sendData(mySRTNetClient, data, size, &msgCtrl);
+class SRTNetCongestionDrop {
+public:
+    enum class Codec {
+        mpeg2,
+        h264,
+        hevc
+    };
+
+    struct Config {
+        int mHighBufferMs = 0;              // Send buffer occupancy in ms (msSndBuf), 0 turns the check off
+        int mLowBufferMs = 0;
+        int mHighBufferPackets = 0;         // Send buffer occupancy in packets (pktSndBuf), 0 turns the check off
+        int mLowBufferPackets = 0;
+        std::chrono::milliseconds mInterval{10}; // How often the send buffer is read
+        std::vector<uint16_t> mLowPriorityPids; // Dropped first
+        std::map<uint16_t, Codec> mVideoPids;   // Their non-reference frames are dropped
+    };
+
+    struct Statistics {
+        uint64_t mSentPackets = 0;          // TS packets handed to SRT
+        uint64_t mDroppedLowPriority = 0;   // Packets of the low priority PIDs dropped
+        uint64_t mDroppedNonReference = 0;  // Packets of non-reference frames dropped
+        uint64_t mDroppedFrames = 0;        // Non-reference frames dropped
+        uint64_t mCongestionEvents = 0;     // Times the high threshold was exceeded
+        bool mCongested = false;            // Dropping now
+        int mBufferMs = 0;                  // The last msSndBuf read
+        int mBufferPackets = 0;             // The last pktSndBuf read
+    };
+
+    ///
+    /// @brief Set the config, resets the frame state and the congestion state
+    /// @return false if the config is not valid
+    bool start(const Config& config);
+
+    ///
+    /// @brief Send a message, without the packets dropped for congestion
+    /// @param net the SRTNet to send with
+    /// @param data the message
+    /// @param size the message size
+    /// @param msgCtrl pointer to a SRT_MSGCTRL struct
+    /// @param targetSystem the target sending the data to (used in server mode only)
+    /// @return false if sendData failed, a message dropped whole is not a failure
+    bool sendData(SRTNetCore& net, const uint8_t* data, size_t size, SRT_MSGCTRL* msgCtrl, SRTSOCKET targetSystem = 0);
+
+    Statistics getStatistics() const;
+
+private:
+    enum class Frame : uint8_t {
+        unknown,
+        reference,
+        nonReference
+    };
+
+    struct PidState {
+        bool mLowPriority = false;
+        bool mVideo = false;
+        Codec mCodec = Codec::h264;
+        bool mSearching = false;            // The frame type was not in the packets of the frame so far
+        bool mDropping = false;             // The current frame is dropped
+    };
+
+    /// Read the send buffer every mInterval and update the congestion state
+    void checkCongestion(SRTNetCore& net, SRTSOCKET targetSystem);
+
+    /// @return true if the packet is to be dropped
+    bool dropPacket(const uint8_t* packet);
+
+    /// @return The frame type of the first picture in the payload of a packet of a video PID
+    Frame classify(const PidState& state, const uint8_t* data, size_t size) const;
+
+    Config mConfig;
+    std::array<PidState, 0x2000> mPids = {};
+    std::vector<uint16_t> mVideo;           // The video PIDs, to reset their frame state
+    bool mCongested = false;
+    int64_t mLastCheck = 0;
+
+    std::atomic<uint64_t> mSentPackets = {0};
+    std::atomic<uint64_t> mDroppedLowPriority = {0};
+    std::atomic<uint64_t> mDroppedNonReference = {0};
+    std::atomic<uint64_t> mDroppedFrames = {0};
+    std::atomic<uint64_t> mCongestionEvents = {0};
+    std::atomic<bool> mPublishedCongested = {false};
+    std::atomic<int> mBufferMs = {0};
+    std::atomic<int> mBufferPackets = {0};
+};
@@ -0,0 +1,468 @@
+//
+// C++20 coroutine front-end for SRTNet
+//
+// Coroutines are resumed directly on SRTNet's own threads, a co_await conn.receive() that suspends is resumed by the
+// epoll (server) or client worker thread that read the message, a co_await server.accept() by the accept thread.
+// There is no extra thread hop and no allocation per operation, the awaitables live in the coroutine frame and
+// messages that arrive while the coroutine is not waiting are kept in a fixed size per connection backlog.
+//
+
+#pragma once
+
+#if __cplusplus < 202002L && !(defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#error "SRTNetCoroutine.h requires C++20"
+#endif
+
+#include <algorithm>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <exception>
+
+#include "SRTNet.h"
+
+namespace SRTNetCoroutine {
+
+///
+/// @brief Fire and forget coroutine type. The coroutine starts running when called and its frame is released
+/// when it returns.
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {
+        }
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+///
+/// @brief A received message. The data is only valid until the coroutine suspends again or calls receive() again,
+/// copy it if it is needed after the next co_await. A message without data (false in boolean context) means the connection is closed.
+struct Message {
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+    SRT_MSGCTRL mMsgCtrl = srt_msgctrl_default;
+
+    explicit operator bool() const {
+        return mData != nullptr;
+    }
+};
+
+///
+/// @brief One SRT connection seen from a coroutine
+class Connection {
+public:
+    // Messages received while no coroutine is waiting are kept, when the backlog is full the oldest is dropped
+    static constexpr size_t kBacklogSize = 64;
+    static constexpr size_t kMaxMessageSize = 2048;
+
+    class ReceiveAwaitable {
+    public:
+        explicit ReceiveAwaitable(Connection& connection)
+            : mConnection(connection) {
+        }
+
+        bool await_ready() {
+            std::lock_guard<std::mutex> lock(mConnection.mMutex);
+            return mConnection.takeBacklogged(mMessage);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard<std::mutex> lock(mConnection.mMutex);
+            // A message might have arrived after await_ready, then continue without suspending
+            if (mConnection.takeBacklogged(mMessage)) {
+                return false;
+            }
+            mConnection.mWaitingReceiver = handle;
+            mConnection.mReceiveTarget = &mMessage;
+            return true;
+        }
+
+        Message await_resume() {
+            return mMessage;
+        }
+
+    private:
+        Connection& mConnection;
+        Message mMessage;
+    };
+
+    class SendAwaitable {
+    public:
+        SendAwaitable(Connection& connection, const uint8_t* data, size_t size, SRT_MSGCTRL* msgCtrl)
+            : mConnection(connection)
+            , mData(data)
+            , mSize(size)
+            , mMsgCtrl(msgCtrl) {
+        }
+
+        // srt_sendmsg2 in live mode only hands the message to the SRT send buffer, so the send completes
+        // immediately and the coroutine is never suspended
+        bool await_ready() const noexcept {
+            return true;
+        }
+
+        void await_suspend(std::coroutine_handle<>) const noexcept {
+        }
+
+        bool await_resume() {
+            SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+            return mConnection.mNet.sendData(mData, mSize, mMsgCtrl ? mMsgCtrl : &msgCtrl,
+                                             mConnection.mTargetSocket);
+        }
+
+    private:
+        Connection& mConnection;
+        const uint8_t* mData;
+        size_t mSize;
+        SRT_MSGCTRL* mMsgCtrl;
+    };
+
+    ///
+    /// @param net The SRTNet instance the connection belongs to
+    /// @param socket The SRT socket of the connection
+    /// @param targetSocket The socket to pass to SRTNet::sendData, the socket in server mode, 0 in client mode
+    Connection(SRTNet& net, SRTSOCKET socket, SRTSOCKET targetSocket)
+        : mNet(net)
+        , mSocket(socket)
+        , mTargetSocket(targetSocket) {
+    }
+
+    ///
+    /// @brief Wait for the next message
+    ReceiveAwaitable receive() {
+        return ReceiveAwaitable(*this);
+    }
+
+    ///
+    /// @brief Send a message on this connection, co_await returns true if the message was sent
+    SendAwaitable send(const uint8_t* data, size_t size, SRT_MSGCTRL* msgCtrl = nullptr) {
+        return SendAwaitable(*this, data, size, msgCtrl);
+    }
+
+    SRTSOCKET getSocket() const {
+        return mSocket;
+    }
+
+    bool isConnected() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mConnected;
+    }
+
+    ///
+    /// @return Number of messages dropped because the backlog was full
+    uint64_t getDroppedMessages() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDroppedMessages;
+    }
+
+    ///
+    /// @brief Hand a received message to the connection, called on the SRTNet receive thread. A waiting coroutine is
+    /// resumed on the calling thread.
+    void deliver(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mWaitingReceiver) {
+            backlog(data, size, msgCtrl);
+            return;
+        }
+        Message* target = mReceiveTarget;
+        std::coroutine_handle<> receiver = std::exchange(mWaitingReceiver, nullptr);
+        lock.unlock();
+        target->mData = data;
+        target->mSize = size;
+        target->mMsgCtrl = msgCtrl;
+        receiver.resume();
+    }
+
+    ///
+    /// @brief Mark the connection as closed, a waiting coroutine is resumed with an empty message
+    void disconnected() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mConnected = false;
+        std::coroutine_handle<> receiver = std::exchange(mWaitingReceiver, nullptr);
+        lock.unlock();
+        if (receiver) {
+            receiver.resume();
+        }
+    }
+
+private:
+    friend class Client;
+
+    struct BacklogSlot {
+        uint8_t mData[kMaxMessageSize];
+        size_t mSize = 0;
+        SRT_MSGCTRL mMsgCtrl = srt_msgctrl_default;
+    };
+
+    // Called with mMutex held
+    void backlog(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+        if (mBacklogCount == kBacklogSize) {
+            mBacklogRead = (mBacklogRead + 1) % kBacklogSize;
+            mBacklogCount--;
+            mDroppedMessages++;
+        }
+        BacklogSlot& slot = mBacklog[(mBacklogRead + mBacklogCount) % kBacklogSize];
+        slot.mSize = std::min(size, kMaxMessageSize);
+        std::memcpy(slot.mData, data, slot.mSize);
+        slot.mMsgCtrl = msgCtrl;
+        mBacklogCount++;
+    }
+
+    // Called with mMutex held. The message is copied out of the backlog, the receive thread may refill the slot as
+    // soon as mMutex is released. The copy is only written here, on the coroutine, and stays valid until its next
+    // receive()
+    bool takeBacklogged(Message& message) {
+        if (mBacklogCount == 0) {
+            if (!mConnected) {
+                message = Message();
+                return true;
+            }
+            return false;
+        }
+        const BacklogSlot& slot = mBacklog[mBacklogRead];
+        std::memcpy(mTaken.mData, slot.mData, slot.mSize);
+        mTaken.mSize = slot.mSize;
+        mTaken.mMsgCtrl = slot.mMsgCtrl;
+        mBacklogRead = (mBacklogRead + 1) % kBacklogSize;
+        mBacklogCount--;
+        message.mData = mTaken.mData;
+        message.mSize = mTaken.mSize;
+        message.mMsgCtrl = mTaken.mMsgCtrl;
+        return true;
+    }
+
+    SRTNet& mNet;
+    std::atomic<SRTSOCKET> mSocket;
+    SRTSOCKET mTargetSocket;
+    mutable std::mutex mMutex;
+    bool mConnected = true;
+    std::coroutine_handle<> mWaitingReceiver = nullptr;
+    Message* mReceiveTarget = nullptr;
+    std::unique_ptr<BacklogSlot[]> mBacklog = std::make_unique<BacklogSlot[]>(kBacklogSize);
+    BacklogSlot mTaken;                 // The last message taken from the backlog, see takeBacklogged
+    size_t mBacklogRead = 0;
+    size_t mBacklogCount = 0;
+    uint64_t mDroppedMessages = 0;
+};
+
+///
+/// @brief Coroutine front-end for an SRTNet server. Registers the SRTNet callbacks, set clientConnected to filter
+/// callers before start().
+class Server {
+public:
+    class AcceptAwaitable {
+    public:
+        explicit AcceptAwaitable(Server& server)
+            : mServer(server) {
+        }
+
+        bool await_ready() {
+            std::lock_guard<std::mutex> lock(mServer.mMutex);
+            return mServer.takePending(mConnection);
+        }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            std::lock_guard<std::mutex> lock(mServer.mMutex);
+            if (mServer.takePending(mConnection)) {
+                return false;
+            }
+            mServer.mWaitingAcceptor = handle;
+            mServer.mAcceptTarget = &mConnection;
+            return true;
+        }
+
+        ///
+        /// @return The new connection, nullptr when the server is stopped
+        std::shared_ptr<Connection> await_resume() {
+            return std::move(mConnection);
+        }
+
+    private:
+        Server& mServer;
+        std::shared_ptr<Connection> mConnection;
+    };
+
+    Server() {
+        mNet.clientConnected = [this](struct sockaddr& sin, SRTSOCKET newSocket,
+                                      std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+            return onConnected(sin, newSocket, ctx);
+        };
+        // The ctx of every connection is the ServerContext created in onConnected
+        mNet.receivedDataNoCopy = [](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                     std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+            static_cast<ServerContext&>(*ctx).mConnection->deliver(data, size, msgCtrl);
+        };
+        mNet.clientDisconnected = [](std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+            static_cast<ServerContext&>(*ctx).mConnection->disconnected();
+        };
+    }
+
+    ~Server() {
+        stop();
+    }
+
+    ///
+    /// @brief Start the server, see SRTNet::startServer for the parameters
+    bool start(const std::string& localIP,
+               uint16_t localPort,
+               int reorder,
+               int32_t latency,
+               int overhead,
+               int mtu,
+               int32_t peerIdleTimeout = 5000,
+               const std::string& psk = "") {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopped = false;
+        }
+        return mNet.startServer(localIP, localPort, reorder, latency, overhead, mtu, peerIdleTimeout, psk);
+    }
+
+    ///
+    /// @brief Stop the server, a coroutine waiting in accept() is resumed with nullptr
+    bool stop() {
+        bool result = mNet.stop();
+        std::unique_lock<std::mutex> lock(mMutex);
+        mStopped = true;
+        mPending.clear();
+        std::coroutine_handle<> acceptor = std::exchange(mWaitingAcceptor, nullptr);
+        lock.unlock();
+        if (acceptor) {
+            acceptor.resume();
+        }
+        return result;
+    }
+
+    ///
+    /// @brief Wait for the next caller
+    AcceptAwaitable accept() {
+        return AcceptAwaitable(*this);
+    }
+
+    ///
+    /// @return The SRTNet instance, use it for statistics and settings
+    SRTNet& getNet() {
+        return mNet;
+    }
+
+    /// Optional filter for connecting callers, return false to reject the caller
+    std::function<bool(struct sockaddr& sin, SRTSOCKET newSocket)> clientConnected = nullptr;
+
+private:
+    // The connection is resolved once when the caller is accepted and not on every received message
+    class ServerContext : public SRTNet::NetworkConnection {
+    public:
+        std::shared_ptr<Connection> mConnection;
+    };
+
+    std::shared_ptr<SRTNet::NetworkConnection>
+    onConnected(struct sockaddr& sin, SRTSOCKET newSocket, std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        if (clientConnected && !clientConnected(sin, newSocket)) {
+            return nullptr;
+        }
+        auto connection = std::make_shared<Connection>(mNet, newSocket, newSocket);
+        auto networkConnection = std::make_shared<ServerContext>();
+        networkConnection->mConnection = connection;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mWaitingAcceptor) {
+            mPending.push_back(connection);
+            return networkConnection;
+        }
+        std::shared_ptr<Connection>* target = mAcceptTarget;
+        std::coroutine_handle<> acceptor = std::exchange(mWaitingAcceptor, nullptr);
+        lock.unlock();
+        *target = connection;
+        // Resumed on the accept thread, the connection is registered for receiving when the coroutine suspends
+        acceptor.resume();
+        return networkConnection;
+    }
+
+    // Called with mMutex held
+    bool takePending(std::shared_ptr<Connection>& connection) {
+        if (!mPending.empty()) {
+            connection = std::move(mPending.front());
+            mPending.pop_front();
+            return true;
+        }
+        if (mStopped) {
+            connection = nullptr;
+            return true;
+        }
+        return false;
+    }
+
+    SRTNet mNet;
+    std::mutex mMutex;
+    bool mStopped = false;
+    std::deque<std::shared_ptr<Connection>> mPending;
+    std::coroutine_handle<> mWaitingAcceptor = nullptr;
+    std::shared_ptr<Connection>* mAcceptTarget = nullptr;
+};
+
+///
+/// @brief Coroutine front-end for an SRTNet client
+class Client {
+public:
+    Client() {
+        mNet.receivedDataNoCopy = [this](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                         std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+            mConnection->deliver(data, size, msgCtrl);
+        };
+        mNet.clientDisconnected = [this](std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+            mConnection->disconnected();
+        };
+    }
+
+    ~Client() {
+        stop();
+    }
+
+    ///
+    /// @brief Connect to a server, see SRTNet::startClient for the parameters
+    /// @return The connection, nullptr if the client failed to connect
+    std::shared_ptr<Connection> connect(const std::string& host,
+                                        uint16_t port,
+                                        int reorder,
+                                        int32_t latency,
+                                        int overhead,
+                                        int mtu,
+                                        int32_t peerIdleTimeout = 5000,
+                                        const std::string& psk = "") {
+        // Replaced before the client worker thread is started, the worker only ever sees this connection
+        mConnection = std::make_shared<Connection>(mNet, 0, 0);
+        auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+        if (!mNet.startClient(host, port, reorder, latency, overhead, ctx, mtu, peerIdleTimeout, psk)) {
+            return nullptr;
+        }
+        mConnection->mSocket = mNet.getConnectedServer().first;
+        return mConnection;
+    }
+
+    bool stop() {
+        return mNet.stop();
+    }
+
+    ///
+    /// @return The SRTNet instance, use it for statistics and settings
+    SRTNet& getNet() {
+        return mNet;
+    }
+
+private:
+    SRTNet mNet;
+    std::shared_ptr<Connection> mConnection;
+};
+
+} // namespace SRTNetCoroutine
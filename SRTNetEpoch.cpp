@@ -0,0 +1,89 @@
+//
+// Epoch based deferred reclamation for the lock free send path
+//
+
+#include "SRTNetEpoch.h"
+
+#include <limits>
+#include <thread>
+
+SRTNetEpoch::~SRTNetEpoch() {
+    for (auto& retired : mRetired) {
+        retired.second();
+    }
+}
+
+size_t SRTNetEpoch::enter() {
+    // Start at a slot of its own so threads sending at the same time do not share a cache line
+    size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % kSlots;
+    for (size_t tries = 1;; ++tries) {
+        // Sequentially consistent, a writer that unlinked an object before it advanced the epoch either sees this
+        // reader or the reader does not see the object
+        uint64_t expected = 0;
+        if (mSlots[slot].mEpoch.compare_exchange_strong(expected, mGlobalEpoch.load())) {
+            return slot;
+        }
+        slot = (slot + 1) % kSlots;
+        if (tries % kSlots == 0) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SRTNetEpoch::leave(size_t slot) {
+    mSlots[slot].mEpoch.store(0);
+}
+
+uint64_t SRTNetEpoch::oldestReader() const {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (const Slot& slot : mSlots) {
+        uint64_t epoch = slot.mEpoch.load();
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+void SRTNetEpoch::retire(std::function<void()> reclaim) {
+    // Readers that enter from now on have a later epoch and can not see the object
+    uint64_t epoch = mGlobalEpoch.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRetired.emplace_back(epoch, std::move(reclaim));
+        mPending++;
+    }
+    SRTNetEpoch::reclaim();
+}
+
+void SRTNetEpoch::reclaim() {
+    if (mPending.load() == 0) {
+        return;
+    }
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        uint64_t oldest = oldestReader();
+        for (auto iterator = mRetired.begin(); iterator != mRetired.end();) {
+            // A reader in the retire epoch may have seen the object
+            if (iterator->first < oldest) {
+                ready.push_back(std::move(iterator->second));
+                iterator = mRetired.erase(iterator);
+            } else {
+                ++iterator;
+            }
+        }
+        mPending = mRetired.size();
+    }
+    for (auto& function : ready) {
+        function();
+    }
+}
+
+void SRTNetEpoch::synchronize() {
+    uint64_t epoch = mGlobalEpoch.fetch_add(1);
+    while (oldestReader() <= epoch) {
+        std::this_thread::yield();
+    }
+    reclaim();
+}
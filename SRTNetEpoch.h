@@ -0,0 +1,79 @@
+//
+// Epoch based deferred reclamation for the lock free send path
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+///
+/// @brief Defers the release of something readers may still use until every reader that could have seen it is gone.
+/// A reader holds a Guard while it uses a shared object, entering and leaving is one compare and swap and one store on
+/// a slot of its own. A writer first unlinks the object so new readers can not find it and then retires it, the
+/// reclaim function runs once no Guard entered before the retire is alive.
+///
+/// Writers are expected to be rare (connects, disconnects and stop), they serialize on a mutex.
+class SRTNetEpoch {
+public:
+    /// Readers in a Guard at the same time before enter spins, more senders than this wait for a free slot
+    static constexpr size_t kSlots = 64;
+
+    class Guard {
+    public:
+        explicit Guard(SRTNetEpoch& epoch) : mEpoch(epoch), mSlot(epoch.enter()) {
+        }
+
+        ~Guard() {
+            mEpoch.leave(mSlot);
+        }
+
+        Guard(Guard const&) = delete;
+        Guard& operator=(Guard const&) = delete;
+
+    private:
+        SRTNetEpoch& mEpoch;
+        size_t mSlot;
+    };
+
+    /// Runs everything retired, the owner makes sure no reader is left
+    ~SRTNetEpoch();
+
+    ///
+    /// @brief Run reclaim once no reader can use what it releases. The object must already be unlinked
+    /// @param reclaim releases the object, it runs on the thread of this or of a later retire, reclaim or synchronize
+    void retire(std::function<void()> reclaim);
+
+    ///
+    /// @brief Run the reclaim functions whose readers are gone, never blocks on readers
+    void reclaim();
+
+    ///
+    /// @brief Wait until every reader that entered before the call has left, then run the reclaim functions retired
+    /// before the call
+    void synchronize();
+
+private:
+    /// @return The slot of the reader
+    size_t enter();
+
+    void leave(size_t slot);
+
+    /// @return The oldest epoch a reader entered in, UINT64_MAX if there is no reader
+    uint64_t oldestReader() const;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> mEpoch = {0}; // 0 == free
+    };
+
+    Slot mSlots[kSlots];
+    alignas(64) std::atomic<uint64_t> mGlobalEpoch = {1};
+
+    std::mutex mMutex;
+    std::vector<std::pair<uint64_t, std::function<void()>>> mRetired;
+    std::atomic<size_t> mPending = {0};
+};
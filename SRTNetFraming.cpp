@@ -0,0 +1,243 @@
+//
+// Application frames larger than one SRT message, split on send and reassembled on receive
+//
+
+#include "SRTNetFraming.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "SRTNetInternal.h"
+
+namespace {
+
+void writeUint16(uint8_t* data, uint16_t value) {
+    data[0] = static_cast<uint8_t>(value >> 8);
+    data[1] = static_cast<uint8_t>(value);
+}
+
+void writeUint32(uint8_t* data, uint32_t value) {
+    data[0] = static_cast<uint8_t>(value >> 24);
+    data[1] = static_cast<uint8_t>(value >> 16);
+    data[2] = static_cast<uint8_t>(value >> 8);
+    data[3] = static_cast<uint8_t>(value);
+}
+
+uint16_t readUint16(const uint8_t* data) {
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t readUint32(const uint8_t* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+} // namespace
+
+SRTNetFrameSender::SRTNetFrameSender() : SRTNetFrameSender(Config()) {
+}
+
+SRTNetFrameSender::SRTNetFrameSender(const Config& config) : mConfig(config) {
+}
+
+size_t SRTNetFrameSender::getMaxFrameSize() const {
+    if (mConfig.mMessageSize <= SRTNetFraming::kHeaderSize) {
+        return 0;
+    }
+    return (mConfig.mMessageSize - SRTNetFraming::kHeaderSize) * SRTNetFraming::kMaxFragments;
+}
+
+bool SRTNetFrameSender::sendFrame(SRTNetCore& net,
+                                  const uint8_t* data,
+                                  size_t size,
+                                  const SRT_MSGCTRL* msgCtrl,
+                                  SRTSOCKET targetSystem) {
+    if (size == 0 || size > getMaxFrameSize() || size > UINT32_MAX ||
+        mConfig.mMessageSize > SRT_LIVE_MAX_PLSIZE) {
+        SRT_LOGGER(true, LOGG_ERROR, "Frame of " << size << " bytes can not be sent with messages of "
+                                                 << mConfig.mMessageSize << " bytes");
+        return false;
+    }
+    const size_t fragmentSize = mConfig.mMessageSize - SRTNetFraming::kHeaderSize;
+    const auto count = static_cast<uint16_t>((size + fragmentSize - 1) / fragmentSize);
+    const uint32_t frameId = mNextFrameId.fetch_add(1, std::memory_order_relaxed);
+
+    uint8_t message[SRT_LIVE_MAX_PLSIZE];
+    message[0] = SRTNetFraming::kMagic;
+    message[1] = SRTNetFraming::kVersion;
+    writeUint16(message + 4, count);
+    writeUint32(message + 6, frameId);
+    writeUint32(message + 10, static_cast<uint32_t>(size));
+    for (uint16_t index = 0; index < count; ++index) {
+        size_t offset = static_cast<size_t>(index) * fragmentSize;
+        size_t length = std::min(fragmentSize, size - offset);
+        writeUint16(message + 2, index);
+        std::memcpy(message + SRTNetFraming::kHeaderSize, data + offset, length);
+        SRT_MSGCTRL fragmentCtrl = msgCtrl ? *msgCtrl : srt_msgctrl_default;
+        if (!net.sendData(message, SRTNetFraming::kHeaderSize + length, &fragmentCtrl, targetSystem)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SRTNetFrameReassembler::start(const Config& config, Callback callback) {
+    if (!callback || config.mMaxPendingFrames == 0 || config.mTtl.count() <= 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The frame reassembler needs a callback, a TTL and room for a pending frame");
+        return false;
+    }
+    mConfig = config;
+    mCallback = std::move(callback);
+    while (!mPending.empty()) {
+        releaseFrame(mPending.size() - 1);
+    }
+    mPending.reserve(config.mMaxPendingFrames);
+    mPool.reserve(config.mMaxPendingFrames);
+    return true;
+}
+
+bool SRTNetFrameReassembler::receive(const uint8_t* data, size_t size, SRTSOCKET socket) {
+    if (!SRTNetFraming::isFragment(data, size) || !mCallback) {
+        return false;
+    }
+    mFragments.fetch_add(1, std::memory_order_relaxed);
+    const uint16_t index = readUint16(data + 2);
+    const uint16_t count = readUint16(data + 4);
+    const uint32_t id = readUint32(data + 6);
+    const size_t frameSize = readUint32(data + 10);
+    const uint8_t* payload = data + SRTNetFraming::kHeaderSize;
+    const size_t payloadSize = size - SRTNetFraming::kHeaderSize;
+
+    int64_t now = srt_time_now();
+    if (now - mLastExpire >= std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mTtl).count() / 4) {
+        expire();
+    }
+
+    if (count == 0 || index >= count) {
+        mInvalid.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    // Every fragment but the last carries the same payload size, it places any fragment in the frame
+    size_t fragmentSize = payloadSize;
+    if (index == count - 1 && count > 1) {
+        if (frameSize <= payloadSize || (frameSize - payloadSize) % (count - 1) != 0) {
+            mInvalid.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        fragmentSize = (frameSize - payloadSize) / (count - 1);
+    }
+    const size_t offset = static_cast<size_t>(index) * fragmentSize;
+    if (offset + payloadSize > frameSize || (index == count - 1 && offset + payloadSize != frameSize)) {
+        mInvalid.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t position = 0;
+    while (position < mPending.size() && (mPending[position]->mSocket != socket || mPending[position]->mId != id)) {
+        position++;
+    }
+    if (position == mPending.size()) {
+        if (frameSize > mConfig.mMaxFrameSize) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (mPending.size() == mConfig.mMaxPendingFrames) {
+            // The oldest frame is first, frames are appended as they start
+            releaseFrame(0);
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            position--;
+        }
+        std::unique_ptr<Frame> frame = takeFrame(frameSize, count);
+        frame->mSocket = socket;
+        frame->mId = id;
+        frame->mSize = frameSize;
+        frame->mFragmentSize = fragmentSize;
+        frame->mCount = count;
+        frame->mFirstArrival = now;
+        mPending.push_back(std::move(frame));
+        mPendingCount.store(mPending.size(), std::memory_order_relaxed);
+    }
+
+    Frame& frame = *mPending[position];
+    if (frame.mSize != frameSize || frame.mCount != count || frame.mFragmentSize != fragmentSize) {
+        mInvalid.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    if (frame.mHave[index]) {
+        return true; // Duplicate
+    }
+    std::memcpy(frame.mData.get() + offset, payload, payloadSize);
+    frame.mHave[index] = true;
+    frame.mReceived++;
+    if (frame.mReceived == frame.mCount) {
+        mFrames.fetch_add(1, std::memory_order_relaxed);
+        mCallback(frame.mData.get(), frame.mSize, socket);
+        releaseFrame(position);
+    }
+    return true;
+}
+
+void SRTNetFrameReassembler::expire() {
+    int64_t now = srt_time_now();
+    mLastExpire = now;
+    const int64_t ttl = std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mTtl).count();
+    for (size_t i = 0; i < mPending.size();) {
+        if (now - mPending[i]->mFirstArrival >= ttl) {
+            releaseFrame(i);
+            mExpired.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ++i;
+        }
+    }
+}
+
+SRTNetFrameReassembler::Statistics SRTNetFrameReassembler::getStatistics() const {
+    Statistics stats;
+    stats.mFrames = mFrames.load(std::memory_order_relaxed);
+    stats.mFragments = mFragments.load(std::memory_order_relaxed);
+    stats.mExpired = mExpired.load(std::memory_order_relaxed);
+    stats.mDropped = mDropped.load(std::memory_order_relaxed);
+    stats.mInvalid = mInvalid.load(std::memory_order_relaxed);
+    stats.mPending = mPendingCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::unique_ptr<SRTNetFrameReassembler::Frame> SRTNetFrameReassembler::takeFrame(size_t size, uint16_t count) {
+    std::unique_ptr<Frame> frame;
+    // The smallest pooled buffer the frame fits in, else the largest to grow
+    size_t best = mPool.size();
+    for (size_t i = 0; i < mPool.size(); ++i) {
+        bool fits = mPool[i]->mCapacity >= size;
+        if (best == mPool.size()) {
+            best = i;
+        } else if (fits && (mPool[best]->mCapacity < size || mPool[i]->mCapacity < mPool[best]->mCapacity)) {
+            best = i;
+        } else if (!fits && mPool[best]->mCapacity < size && mPool[i]->mCapacity > mPool[best]->mCapacity) {
+            best = i;
+        }
+    }
+    if (best < mPool.size()) {
+        frame = std::move(mPool[best]);
+        mPool[best] = std::move(mPool.back());
+        mPool.pop_back();
+    } else {
+        frame = std::make_unique<Frame>();
+    }
+    if (frame->mCapacity < size) {
+        frame->mData = std::make_unique<uint8_t[]>(size);
+        frame->mCapacity = size;
+    }
+    frame->mHave.assign(count, false);
+    frame->mReceived = 0;
+    return frame;
+}
+
+void SRTNetFrameReassembler::releaseFrame(size_t index) {
+    std::unique_ptr<Frame> frame = std::move(mPending[index]);
+    // Keep the start order, the oldest frame stays first
+    mPending.erase(mPending.begin() + static_cast<std::ptrdiff_t>(index));
+    mPendingCount.store(mPending.size(), std::memory_order_relaxed);
+    if (mPool.size() < mConfig.mMaxPendingFrames) {
+        mPool.push_back(std::move(frame));
+    }
+}
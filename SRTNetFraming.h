@@ -0,0 +1,164 @@
+//
+// Application frames larger than one SRT message, split on send and reassembled on receive
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "SRTNet.h"
+
+namespace SRTNetFraming {
+
+/// Every fragment starts with this header, all fields big endian
+///  0: magic 0xfa
+///  1: version 1
+///  2: fragment index (16 bit)
+///  4: fragment count (16 bit)
+///  6: frame id (32 bit)
+/// 10: frame size in bytes (32 bit)
+constexpr size_t kHeaderSize = 14;
+constexpr uint8_t kMagic = 0xfa;
+constexpr uint8_t kVersion = 1;
+constexpr size_t kMaxFragments = 0xffff;
+
+/// @return true if the message is a fragment of a frame
+inline bool isFragment(const uint8_t* data, size_t size) {
+    return size > kHeaderSize && data[0] == kMagic && data[1] == kVersion;
+}
+
+} // namespace SRTNetFraming
+
+///
+/// @brief Sends frames of any size up to the fragment limit, every frame is split into messages of at most
+/// mMessageSize bytes with a fragment header. The fragments of one frame are sent back to back, frames sent from
+/// different threads may interleave.
+///
+/// SRTNetFrameSender sender;
+/// sender.sendFrame(mySRTNetClient, thumbnail.data(), thumbnail.size());
+class SRTNetFrameSender {
+public:
+    struct Config {
+        size_t mMessageSize = SRT_LIVE_MAX_PLSIZE; // Bytes per message including the header, at most the SRT payload size
+    };
+
+    SRTNetFrameSender();
+
+    explicit SRTNetFrameSender(const Config& config);
+
+    ///
+    /// @brief Split a frame and send the fragments
+    /// @param net the SRTNet to send with
+    /// @param data the frame
+    /// @param size the frame size, at most getMaxFrameSize
+    /// @param msgCtrl copied to every fragment, nullptr == srt_msgctrl_default
+    /// @param targetSystem the target sending the data to (used in server mode only)
+    /// @return false if the frame is too large or a fragment could not be sent
+    bool sendFrame(SRTNetCore& net,
+                   const uint8_t* data,
+                   size_t size,
+                   const SRT_MSGCTRL* msgCtrl = nullptr,
+                   SRTSOCKET targetSystem = 0);
+
+    /// @return The largest frame that fits the fragment limit
+    size_t getMaxFrameSize() const;
+
+private:
+    Config mConfig;
+    std::atomic<uint32_t> mNextFrameId = {0};
+};
+
+///
+/// @brief Reassembles the frames of SRTNetFrameSender. Every fragment is copied from the receive buffer straight to its
+/// place in one contiguous frame buffer, complete frames are delivered from that buffer. Frame buffers come from a pool
+/// and keep their capacity, a steady stream of frames is reassembled without allocations.
+///
+/// A frame that is not complete mTtl after its first fragment arrived is dropped, SRT live mode drops late packets
+/// and the missing fragment never comes.
+///
+/// Call receive and expire from one thread at a time, the receive thread of the SRTNet.
+///
+/// SRTNetFrameReassembler reassembler;
+/// reassembler.start(config, [](const uint8_t* frame, size_t size, SRTSOCKET socket) { ... });
+/// mySRTNetServer.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, ...) {
+///     if (!reassembler.receive(data, size, socket)) {
+///         //Not a fragment, a plain message
+///     }
+/// };
+class SRTNetFrameReassembler {
+public:
+    /// Called for every complete frame, the data is valid until the callback returns
+    using Callback = std::function<void(const uint8_t* data, size_t size, SRTSOCKET socket)>;
+
+    struct Config {
+        std::chrono::milliseconds mTtl{500}; // Drop frames not complete this long after their first fragment
+        size_t mMaxFrameSize = 16 * 1024 * 1024; // Larger frames are dropped
+        size_t mMaxPendingFrames = 16; // Frames reassembled at the same time, the oldest is dropped to make room
+    };
+
+    struct Statistics {
+        uint64_t mFrames = 0;         // Complete frames delivered
+        uint64_t mFragments = 0;      // Fragments received
+        uint64_t mExpired = 0;        // Frames dropped since they were not complete within mTtl
+        uint64_t mDropped = 0;        // Frames dropped to make room or since they were too large
+        uint64_t mInvalid = 0;        // Fragments with a header that does not match their frame
+        size_t mPending = 0;          // Frames being reassembled now
+    };
+
+    ///
+    /// @brief Set the config and the frame callback, drops all pending frames
+    /// @return false if the config is not valid or the callback is empty
+    bool start(const Config& config, Callback callback);
+
+    ///
+    /// @brief Add a received message
+    /// @param data the message
+    /// @param size the message size
+    /// @param socket the connection of the message, frames of different connections are kept apart
+    /// @return false if the message is not a fragment, nothing is done with it
+    bool receive(const uint8_t* data, size_t size, SRTSOCKET socket);
+
+    ///
+    /// @brief Drop the frames older than mTtl. receive does it too, call it when the connections are idle
+    void expire();
+
+    Statistics getStatistics() const;
+
+private:
+    struct Frame {
+        SRTSOCKET mSocket = 0;
+        uint32_t mId = 0;
+        size_t mSize = 0;
+        size_t mFragmentSize = 0;     // Payload of every fragment but the last
+        uint16_t mCount = 0;
+        uint16_t mReceived = 0;
+        int64_t mFirstArrival = 0;    // SRT clock, microseconds
+        std::unique_ptr<uint8_t[]> mData;
+        size_t mCapacity = 0;
+        std::vector<bool> mHave;      // Keeps its capacity when the frame buffer is reused
+    };
+
+    /// @return A frame buffer of at least size bytes from the pool
+    std::unique_ptr<Frame> takeFrame(size_t size, uint16_t count);
+
+    /// Put a pending frame back in the pool
+    void releaseFrame(size_t index);
+
+    Config mConfig;
+    Callback mCallback;
+    std::vector<std::unique_ptr<Frame>> mPending;
+    std::vector<std::unique_ptr<Frame>> mPool;
+    int64_t mLastExpire = 0;
+
+    std::atomic<uint64_t> mFrames = {0};
+    std::atomic<uint64_t> mFragments = {0};
+    std::atomic<uint64_t> mExpired = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::atomic<uint64_t> mInvalid = {0};
+    std::atomic<size_t> mPendingCount = {0};
+};
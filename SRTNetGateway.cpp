@@ -0,0 +1,406 @@
+//
+// UDP unicast / multicast to SRT and back
+//
+
+#include "SRTNetGateway.h"
+
+#ifndef WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "SRTNetInternal.h"
+#include "SRTNetTS.h"
+
+namespace {
+
+// Larger than any MPEG-TS or RTP datagram on an Ethernet network, larger datagrams are truncated and dropped
+constexpr size_t kReceiveSize = 2048;
+
+bool parseAddress(const std::string& address, in_addr& result) {
+    if (inet_pton(AF_INET, address.c_str(), &result) != 1) {
+        SRT_LOGGER(true, LOGG_ERROR, "Not an IPv4 address: " << address);
+        return false;
+    }
+    return true;
+}
+
+bool isMulticast(const in_addr& address) {
+    return IN_MULTICAST(ntohl(address.s_addr));
+}
+
+void closeSocket(int& socket) {
+    if (socket >= 0) {
+        ::close(socket);
+        socket = -1;
+    }
+}
+
+} // namespace
+
+SRTNetUdpInput::~SRTNetUdpInput() {
+    stop();
+}
+
+bool SRTNetUdpInput::start(SRTNetCore& net, const Config& config) {
+    if (mThread.joinable()) {
+        SRT_LOGGER(true, LOGG_ERROR, "The UDP input is already started");
+        return false;
+    }
+    if (config.mBatchSize == 0 || config.mTsPacketsPerMessage == 0 ||
+        config.mTsPacketsPerMessage * SRTNetTS::kPacketSize > SRT_LIVE_MAX_PLSIZE) {
+        SRT_LOGGER(true, LOGG_ERROR, "The batch size must be at least 1 and a TS message 1 to 7 packets");
+        return false;
+    }
+    in_addr address{};
+    in_addr interface{};
+    interface.s_addr = htonl(INADDR_ANY);
+    if (!parseAddress(config.mAddress, address) ||
+        (!config.mInterface.empty() && !parseAddress(config.mInterface, interface))) {
+        return false;
+    }
+
+    mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (mSocket < 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "socket failed: " << std::strerror(errno));
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(mSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (setsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, &config.mReceiveBufferSize, sizeof(config.mReceiveBufferSize))) {
+        SRT_LOGGER(true, LOGG_WARN, "SO_RCVBUF failed: " << std::strerror(errno));
+    }
+    // Bound to the group address a multicast socket only gets the datagrams of that group
+    sockaddr_in bindAddress{};
+    bindAddress.sin_family = AF_INET;
+    bindAddress.sin_port = htons(config.mPort);
+    bindAddress.sin_addr = address;
+    if (bind(mSocket, reinterpret_cast<sockaddr*>(&bindAddress), sizeof(bindAddress))) {
+        SRT_LOGGER(true, LOGG_ERROR, "bind failed: " << std::strerror(errno));
+        closeSocket(mSocket);
+        return false;
+    }
+    if (isMulticast(address)) {
+        ip_mreq membership{};
+        membership.imr_multiaddr = address;
+        membership.imr_interface = interface;
+        if (setsockopt(mSocket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership))) {
+            SRT_LOGGER(true, LOGG_ERROR, "IP_ADD_MEMBERSHIP failed: " << std::strerror(errno));
+            closeSocket(mSocket);
+            return false;
+        }
+    }
+
+    mNet = &net;
+    mConfig = config;
+    mPending = std::make_unique<uint8_t[]>(config.mTsPacketsPerMessage * SRTNetTS::kPacketSize);
+    mPendingSize = 0;
+    mActive = true;
+    mThread = std::thread(&SRTNetUdpInput::receiveWorker, this);
+    return true;
+}
+
+void SRTNetUdpInput::stop() {
+    mActive = false;
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    closeSocket(mSocket);
+}
+
+SRTNetUdpInput::Statistics SRTNetUdpInput::getStatistics() const {
+    Statistics stats;
+    stats.mDatagrams = mDatagrams.load(std::memory_order_relaxed);
+    stats.mBytes = mBytes.load(std::memory_order_relaxed);
+    stats.mBatches = mBatches.load(std::memory_order_relaxed);
+    stats.mMessages = mMessages.load(std::memory_order_relaxed);
+    stats.mSendFailures = mSendFailures.load(std::memory_order_relaxed);
+    stats.mTooLarge = mTooLarge.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SRTNetUdpInput::receiveWorker() {
+    const size_t batchSize = mConfig.mBatchSize;
+    std::vector<uint8_t> buffers(batchSize * kReceiveSize);
+#if defined(__linux__)
+    std::vector<iovec> vectors(batchSize);
+    std::vector<mmsghdr> messages(batchSize);
+#endif
+    while (mActive) {
+        // Wake up for the aggregation deadline, and at least every 100 ms to see stop
+        auto timeout = std::chrono::milliseconds(100);
+        if (mPendingSize > 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                mPendingSince + mConfig.mMaxAggregationDelay - std::chrono::steady_clock::now());
+            timeout = std::clamp(remaining, std::chrono::milliseconds(0), timeout);
+        }
+        pollfd pollSocket{mSocket, POLLIN, 0};
+        int ready = poll(&pollSocket, 1, static_cast<int>(timeout.count()));
+        if (ready < 0 && errno != EINTR) {
+            SRT_LOGGER(true, LOGG_ERROR, "poll failed: " << std::strerror(errno));
+            break;
+        }
+
+        if (ready > 0) {
+#if defined(__linux__)
+            for (size_t i = 0; i < batchSize; ++i) {
+                vectors[i].iov_base = &buffers[i * kReceiveSize];
+                vectors[i].iov_len = kReceiveSize;
+                messages[i] = {};
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int received = recvmmsg(mSocket, messages.data(), static_cast<unsigned int>(batchSize), MSG_DONTWAIT,
+                                    nullptr);
+            if (received > 0) {
+                mBatches.fetch_add(1, std::memory_order_relaxed);
+                for (int i = 0; i < received; ++i) {
+                    if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                        mTooLarge.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    forward(&buffers[i * kReceiveSize], messages[i].msg_len);
+                }
+            }
+#else
+            for (size_t i = 0; i < batchSize; ++i) {
+                ssize_t received = recv(mSocket, buffers.data(), kReceiveSize, MSG_DONTWAIT);
+                if (received <= 0) {
+                    break;
+                }
+                mBatches.fetch_add(1, std::memory_order_relaxed);
+                forward(buffers.data(), static_cast<size_t>(received));
+            }
+#endif
+        }
+
+        if (mPendingSize > 0 &&
+            std::chrono::steady_clock::now() - mPendingSince >= mConfig.mMaxAggregationDelay) {
+            flush();
+        }
+    }
+    flush();
+}
+
+void SRTNetUdpInput::forward(const uint8_t* data, size_t size) {
+    mDatagrams.fetch_add(1, std::memory_order_relaxed);
+    mBytes.fetch_add(size, std::memory_order_relaxed);
+    if (SRTNetTS::isTransportStream(data, size)) {
+        const size_t messageSize = mConfig.mTsPacketsPerMessage * SRTNetTS::kPacketSize;
+        for (size_t offset = 0; offset < size; offset += SRTNetTS::kPacketSize) {
+            if (mPendingSize == 0) {
+                mPendingSince = std::chrono::steady_clock::now();
+            }
+            std::memcpy(mPending.get() + mPendingSize, data + offset, SRTNetTS::kPacketSize);
+            mPendingSize += SRTNetTS::kPacketSize;
+            if (mPendingSize == messageSize) {
+                flush();
+            }
+        }
+        return;
+    }
+    // Not TS, keep the order and send it as it is
+    flush();
+    if (size > SRT_LIVE_MAX_PLSIZE) {
+        mTooLarge.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    sendMessage(data, size);
+}
+
+void SRTNetUdpInput::flush() {
+    if (mPendingSize == 0) {
+        return;
+    }
+    sendMessage(mPending.get(), mPendingSize);
+    mPendingSize = 0;
+}
+
+void SRTNetUdpInput::sendMessage(const uint8_t* data, size_t size) {
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    if (mNet->sendData(data, size, &msgCtrl, mConfig.mTarget)) {
+        mMessages.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mSendFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+SRTNetUdpOutput::~SRTNetUdpOutput() {
+    stop();
+}
+
+bool SRTNetUdpOutput::start(const Config& config) {
+    if (mThread.joinable()) {
+        SRT_LOGGER(true, LOGG_ERROR, "The UDP output is already started");
+        return false;
+    }
+    if (config.mBatchSize == 0 || config.mQueueSize == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The batch size and the queue size must be at least 1");
+        return false;
+    }
+    in_addr address{};
+    in_addr interface{};
+    if (!parseAddress(config.mAddress, address) ||
+        (!config.mInterface.empty() && !parseAddress(config.mInterface, interface))) {
+        return false;
+    }
+
+    mSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (mSocket < 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "socket failed: " << std::strerror(errno));
+        return false;
+    }
+    if (setsockopt(mSocket, SOL_SOCKET, SO_SNDBUF, &config.mSendBufferSize, sizeof(config.mSendBufferSize))) {
+        SRT_LOGGER(true, LOGG_WARN, "SO_SNDBUF failed: " << std::strerror(errno));
+    }
+    if (isMulticast(address)) {
+        unsigned char ttl = static_cast<unsigned char>(config.mTtl);
+        unsigned char loop = config.mLoop ? 1 : 0;
+        bool failed = setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) ||
+                      setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        if (!config.mInterface.empty()) {
+            failed = failed || setsockopt(mSocket, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface));
+        }
+        if (failed) {
+            SRT_LOGGER(true, LOGG_ERROR, "Setting the multicast options failed: " << std::strerror(errno));
+            closeSocket(mSocket);
+            return false;
+        }
+    }
+    // Connected, the datagrams of a batch need no address of their own
+    sockaddr_in destination{};
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(config.mPort);
+    destination.sin_addr = address;
+    if (connect(mSocket, reinterpret_cast<sockaddr*>(&destination), sizeof(destination))) {
+        SRT_LOGGER(true, LOGG_ERROR, "connect failed: " << std::strerror(errno));
+        closeSocket(mSocket);
+        return false;
+    }
+
+    mConfig = config;
+    mCapacity = 1;
+    while (mCapacity < config.mQueueSize) {
+        mCapacity <<= 1;
+    }
+    mSlots = std::make_unique<Slot[]>(mCapacity);
+    mWrite = 0;
+    mRead = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = true;
+    }
+    mThread = std::thread(&SRTNetUdpOutput::sendWorker, this);
+    return true;
+}
+
+void SRTNetUdpOutput::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = false;
+        mCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    closeSocket(mSocket);
+}
+
+bool SRTNetUdpOutput::send(const uint8_t* data, size_t size) {
+    size_t write = mWrite.load(std::memory_order_relaxed);
+    if (!mSlots || size > kMaxDatagramSize || write - mRead.load(std::memory_order_acquire) == mCapacity) {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Slot& slot = mSlots[write & (mCapacity - 1)];
+    std::memcpy(slot.mData, data, size);
+    slot.mSize = size;
+    // Sequentially consistent, pairs with the sender announcing that it goes to sleep
+    mWrite.store(write + 1);
+    mQueued.fetch_add(1, std::memory_order_relaxed);
+    if (mSleeping) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCondition.notify_one();
+    }
+    return true;
+}
+
+SRTNetUdpOutput::Statistics SRTNetUdpOutput::getStatistics() const {
+    Statistics stats;
+    stats.mQueued = mQueued.load(std::memory_order_relaxed);
+    stats.mDropped = mDropped.load(std::memory_order_relaxed);
+    stats.mDatagrams = mDatagrams.load(std::memory_order_relaxed);
+    stats.mBatches = mBatches.load(std::memory_order_relaxed);
+    stats.mSendErrors = mSendErrors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SRTNetUdpOutput::sendWorker() {
+    const size_t batchSize = mConfig.mBatchSize;
+#if defined(__linux__)
+    std::vector<iovec> vectors(batchSize);
+    std::vector<mmsghdr> messages(batchSize);
+#endif
+    while (true) {
+        size_t read = mRead.load(std::memory_order_relaxed);
+        size_t count = std::min(mWrite.load(std::memory_order_acquire) - read, batchSize);
+        if (count > 0) {
+#if defined(__linux__)
+            for (size_t i = 0; i < count; ++i) {
+                Slot& slot = mSlots[(read + i) & (mCapacity - 1)];
+                vectors[i].iov_base = slot.mData;
+                vectors[i].iov_len = slot.mSize;
+                messages[i] = {};
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            size_t sent = 0;
+            while (sent < count) {
+                int result = sendmmsg(mSocket, messages.data() + sent, static_cast<unsigned int>(count - sent), 0);
+                mBatches.fetch_add(1, std::memory_order_relaxed);
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    // The first datagram of the call failed, skip it and send the rest
+                    mSendErrors.fetch_add(1, std::memory_order_relaxed);
+                    sent++;
+                    continue;
+                }
+                sent += static_cast<size_t>(result);
+                mDatagrams.fetch_add(static_cast<uint64_t>(result), std::memory_order_relaxed);
+            }
+#else
+            for (size_t i = 0; i < count; ++i) {
+                Slot& slot = mSlots[(read + i) & (mCapacity - 1)];
+                mBatches.fetch_add(1, std::memory_order_relaxed);
+                if (::send(mSocket, slot.mData, slot.mSize, 0) < 0) {
+                    mSendErrors.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    mDatagrams.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+#endif
+            mRead.store(read + count, std::memory_order_release);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mActive) {
+            break;
+        }
+        mSleeping = true;
+        if (mRead.load() == mWrite.load()) {
+            // The timeout only guards the shutdown, new datagrams always wake the sender
+            mCondition.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        mSleeping = false;
+    }
+}
+
+#endif
@@ -0,0 +1,181 @@
+//
+// UDP unicast / multicast to SRT and back
+//
+
+#pragma once
+
+#ifndef WIN32
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "SRTNet.h"
+
+///
+/// @brief Receives UDP, unicast or multicast, and sends it with SRTNet. The datagrams are read in batches with one
+/// recvmmsg call on Linux (one recvfrom per datagram on other platforms). MPEG-TS is repacked into SRT messages of
+/// mTsPacketsPerMessage packets, other datagrams are sent as they are.
+///
+/// SRTNetUdpInput input;
+/// SRTNetUdpInput::Config config;
+/// config.mAddress = "239.1.1.1"; // A multicast group is joined, a unicast address is bound
+/// config.mPort = 5000;
+/// input.start(mySRTNetClient, config);
+class SRTNetUdpInput {
+public:
+    struct Config {
+        std::string mAddress;                              // IPv4 address to bind or multicast group to join
+        uint16_t mPort = 0;
+        std::string mInterface;                            // Local address of the interface to join on, empty == any
+        size_t mBatchSize = 32;                            // Datagrams per recvmmsg
+        size_t mTsPacketsPerMessage = 7;                   // 7 * 188 = 1316 bytes fits SRT_LIVE_DEF_PLSIZE
+        std::chrono::milliseconds mMaxAggregationDelay{5}; // Send a partly filled TS message when it gets this old
+        int mReceiveBufferSize = 4 * 1024 * 1024;          // SO_RCVBUF
+        SRTSOCKET mTarget = 0;                             // The client to send to when net is a server, see sendData
+    };
+
+    struct Statistics {
+        uint64_t mDatagrams = 0;    // Datagrams received
+        uint64_t mBytes = 0;        // Bytes received
+        uint64_t mBatches = 0;      // Receive system calls that returned data
+        uint64_t mMessages = 0;     // SRT messages sent
+        uint64_t mSendFailures = 0; // SRT messages sendData failed for
+        uint64_t mTooLarge = 0;     // Datagrams dropped since they do not fit an SRT message
+    };
+
+    ~SRTNetUdpInput();
+
+    ///
+    /// @brief Open the UDP socket and start forwarding
+    /// @param net the SRTNet to send with, it must be kept alive until the input is stopped
+    /// @param config the UDP source
+    /// @return false if the socket could not be set up or the input is already started
+    bool start(SRTNetCore& net, const Config& config);
+
+    ///
+    /// @brief Stop forwarding and close the socket, a partly filled TS message is sent first
+    void stop();
+
+    Statistics getStatistics() const;
+
+private:
+    void receiveWorker();
+
+    /// Handle one datagram
+    void forward(const uint8_t* data, size_t size);
+
+    /// Send the aggregated TS packets
+    void flush();
+
+    void sendMessage(const uint8_t* data, size_t size);
+
+    SRTNetCore* mNet = nullptr;
+    Config mConfig;
+    int mSocket = -1;
+    std::atomic<bool> mActive = {false};
+    std::thread mThread;
+
+    // Receive thread state
+    std::unique_ptr<uint8_t[]> mPending;
+    size_t mPendingSize = 0;
+    std::chrono::steady_clock::time_point mPendingSince;
+
+    std::atomic<uint64_t> mDatagrams = {0};
+    std::atomic<uint64_t> mBytes = {0};
+    std::atomic<uint64_t> mBatches = {0};
+    std::atomic<uint64_t> mMessages = {0};
+    std::atomic<uint64_t> mSendFailures = {0};
+    std::atomic<uint64_t> mTooLarge = {0};
+};
+
+///
+/// @brief Sends received SRT messages as UDP datagrams, unicast or multicast. send copies the message into a queue
+/// and returns, a sender thread writes everything queued with one sendmmsg call on Linux (one sendto per datagram on
+/// other platforms). The messages SRT delivers together after a wakeup leave in one system call.
+///
+/// SRTNetUdpOutput output;
+/// SRTNetUdpOutput::Config config;
+/// config.mAddress = "239.1.1.2";
+/// config.mPort = 5000;
+/// output.start(config);
+/// mySRTNetServer.receivedDataNoCopy = [&](const uint8_t* data, size_t size, ...) { output.send(data, size); };
+class SRTNetUdpOutput {
+public:
+    static constexpr size_t kMaxDatagramSize = 2048;
+
+    struct Config {
+        std::string mAddress;                  // IPv4 destination, unicast or multicast
+        uint16_t mPort = 0;
+        std::string mInterface;                // Local address of the interface to send multicast on, empty == default
+        int mTtl = 16;                         // Multicast TTL
+        bool mLoop = true;                     // Deliver multicast to listeners on this host as well
+        size_t mBatchSize = 32;                // Datagrams per sendmmsg
+        size_t mQueueSize = 1024;              // Datagrams queued, rounded up to a power of two
+        int mSendBufferSize = 4 * 1024 * 1024; // SO_SNDBUF
+    };
+
+    struct Statistics {
+        uint64_t mQueued = 0;     // Datagrams queued by send
+        uint64_t mDropped = 0;    // Datagrams dropped since the queue was full or they were too large
+        uint64_t mDatagrams = 0;  // Datagrams sent
+        uint64_t mBatches = 0;    // Send system calls
+        uint64_t mSendErrors = 0; // Datagrams the socket refused
+    };
+
+    ~SRTNetUdpOutput();
+
+    ///
+    /// @brief Open the UDP socket and start the sender thread
+    /// @param config the UDP destination
+    /// @return false if the socket could not be set up or the output is already started
+    bool start(const Config& config);
+
+    ///
+    /// @brief Stop the sender thread and close the socket, what is queued is sent first
+    void stop();
+
+    ///
+    /// @brief Queue a datagram, never blocks. Call it from one thread at a time, normally the receivedDataNoCopy
+    /// callback of the SRT connection
+    /// @return false if the datagram was dropped
+    bool send(const uint8_t* data, size_t size);
+
+    Statistics getStatistics() const;
+
+private:
+    struct Slot {
+        size_t mSize = 0;
+        uint8_t mData[kMaxDatagramSize];
+    };
+
+    void sendWorker();
+
+    Config mConfig;
+    int mSocket = -1;
+    std::thread mThread;
+
+    // Single producer single consumer queue, send is the producer and the sender thread the consumer
+    size_t mCapacity = 0;
+    std::unique_ptr<Slot[]> mSlots;
+    alignas(64) std::atomic<size_t> mWrite = {0};
+    alignas(64) std::atomic<size_t> mRead = {0};
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mActive = false;
+    std::atomic<bool> mSleeping = {false};
+
+    std::atomic<uint64_t> mQueued = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::atomic<uint64_t> mDatagrams = {0};
+    std::atomic<uint64_t> mBatches = {0};
+    std::atomic<uint64_t> mSendErrors = {0};
+};
+
+#endif
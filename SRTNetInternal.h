@@ -5,31 +5,47 @@
 #pragma once
 
 #include <iostream>
+#include <optional>
 #include <sstream>
+#include <string>
+#include <utility>
 
-// Global Logger -- Start
-#define LOGG_NOTIFY 1
-#define LOGG_WARN 2
-#define LOGG_ERROR 4
-#define LOGG_FATAL 8
-#define LOGG_MASK  LOGG_NOTIFY | LOGG_WARN | LOGG_ERROR | LOGG_FATAL //What to logg?
+#include "srt/srtcore/srt.h"
+
+#include "SRTNetLogger.h"
 
-#ifdef DEBUG
+// Global Logger -- Start
+// The level is checked before the record is formatted, the record is written by the SRTNetLogger thread
 #define SRT_LOGGER(l,g,f) \
 { \
+if (SRTNetLogger::get().isEnabled(g)) { \
 std::ostringstream a; \
-if (g == (LOGG_NOTIFY & (LOGG_MASK))) {a << "Notification: ";} \
-else if (g == (LOGG_WARN & (LOGG_MASK))) {a << "Warning: ";} \
-else if (g == (LOGG_ERROR & (LOGG_MASK))) {a << "Error: ";} \
-else if (g == (LOGG_FATAL & (LOGG_MASK))) {a << "Fatal: ";} \
-if (a.str().length()) { \
 if (l) {a << __FILE__ << " " << __LINE__ << " ";} \
-a << f << std::endl; \
-std::cout << a.str(); \
+a << f; \
+SRTNetLogger::get().log(g, a.str()); \
 } \
 }
-#else
-#define SRT_LOGGER(l,g,f)
-#endif
 // GLobal Logger -- End
 
+namespace SRTNetInternal {
+
+///
+/// @brief Resolve a host name or IP address, the first address found is used
+/// @param host The host name or IP address
+/// @param port The port
+/// @return The address and its length, nullopt if the host could not be resolved
+std::optional<std::pair<sockaddr_storage, int>> resolveAddress(const std::string& host, uint16_t port);
+
+///
+/// @brief Apply the SRT options shared by listener, caller and group sockets
+/// @return true if all options were set
+bool applySocketOptions(SRTSOCKET socket,
+                        int reorder,
+                        int32_t latency,
+                        int overhead,
+                        int mtu,
+                        int32_t peerIdleTimeout,
+                        const std::string& psk,
+                        const std::string& packetFilter);
+
+} // namespace SRTNetInternal
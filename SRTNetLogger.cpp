@@ -0,0 +1,238 @@
+//
+// Asynchronous logging for SRTNet and libsrt
+//
+
+#include "SRTNetLogger.h"
+
+#include <cstdio>
+#include <iostream>
+
+#include "srt/srtcore/srt.h"
+
+namespace {
+
+constexpr size_t kRingMask = SRTNetLogger::kRingSize - 1;
+static_assert((SRTNetLogger::kRingSize & kRingMask) == 0, "The ring size must be a power of two");
+
+/// @return The SRTNet level of a libsrt (syslog) level
+int fromSrtLevel(int srtLevel) {
+    if (srtLevel <= LOG_CRIT) {
+        return LOGG_FATAL;
+    } else if (srtLevel == LOG_ERR) {
+        return LOGG_ERROR;
+    } else if (srtLevel == LOG_WARNING) {
+        return LOGG_WARN;
+    }
+    return LOGG_NOTIFY;
+}
+
+/// @return The libsrt (syslog) level matching an SRTNet level
+int toSrtLevel(int level) {
+    if (level >= LOGG_FATAL) {
+        return LOG_CRIT;
+    } else if (level >= LOGG_ERROR) {
+        return LOG_ERR;
+    } else if (level >= LOGG_WARN) {
+        return LOG_WARNING;
+    }
+    return LOG_NOTICE;
+}
+
+const char* levelName(int level) {
+    switch (level) {
+    case LOGG_NOTIFY:
+        return "Notification: ";
+    case LOGG_WARN:
+        return "Warning: ";
+    case LOGG_ERROR:
+        return "Error: ";
+    case LOGG_FATAL:
+        return "Fatal: ";
+    }
+    return "";
+}
+
+} // namespace
+
+SRTNetLogger& SRTNetLogger::get() {
+    static SRTNetLogger logger;
+    return logger;
+}
+
+SRTNetLogger::SRTNetLogger()
+#ifdef DEBUG
+    : mLevel(LOGG_NOTIFY)
+#else
+    // Release builds stay silent unless the application asks for the logs
+    : mLevel(LOGG_OFF)
+#endif
+{
+    mSlots = std::make_unique<Slot[]>(kRingSize);
+    for (size_t i = 0; i < kRingSize; ++i) {
+        mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+    }
+    mThread = std::thread(&SRTNetLogger::drainWorker, this);
+}
+
+SRTNetLogger::~SRTNetLogger() {
+    routeSrtLogs(false);
+    {
+        std::lock_guard<std::mutex> lock(mWakeMtx);
+        mActive = false;
+        mWakeCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void SRTNetLogger::setLevel(int level) {
+    mLevelSet = true;
+    mLevel.store(level, std::memory_order_relaxed);
+    if (mRouteSrt) {
+        applySrtLevel();
+    }
+}
+
+void SRTNetLogger::setSink(Sink sink) {
+    bool enable = sink && !mLevelSet && getLevel() == LOGG_OFF;
+    {
+        std::lock_guard<std::mutex> lock(mSinkMtx);
+        mSink = std::move(sink);
+    }
+    if (enable) {
+        setLevel(LOGG_ERROR);
+    }
+}
+
+void SRTNetLogger::routeSrtLogs(bool route) {
+    mRouteSrt = route;
+    if (route) {
+        // The record carries the time and the level, libsrt only has to provide the thread name and the text
+        srt_setlogflags(SRT_LOGF_DISABLE_TIME | SRT_LOGF_DISABLE_SEVERITY | SRT_LOGF_DISABLE_EOL);
+        srt_setloghandler(this, &SRTNetLogger::srtLogHandler);
+        applySrtLevel();
+    } else {
+        srt_setloghandler(nullptr, nullptr);
+        srt_setlogflags(0);
+    }
+}
+
+void SRTNetLogger::applySrtLevel() const {
+    srt_setloglevel(toSrtLevel(getLevel()));
+}
+
+void SRTNetLogger::srtLogHandler(void* opaque, int level, const char* file, int line, const char* area,
+                                 const char* message) {
+    auto logger = static_cast<SRTNetLogger*>(opaque);
+    logger->log(fromSrtLevel(level), message ? message : "", true);
+}
+
+bool SRTNetLogger::log(int level, std::string_view message, bool fromSrt) {
+    if (!isEnabled(level)) {
+        return true;
+    }
+    while (!message.empty() && (message.back() == '\n' || message.back() == '\r')) {
+        message.remove_suffix(1);
+    }
+
+    // Claim a slot, a slot is free for position p when its sequence is p
+    uint64_t position = mWrite.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    while (true) {
+        slot = &mSlots[position & kRingMask];
+        uint64_t sequence = slot->mSequence.load(std::memory_order_acquire);
+        auto difference = static_cast<int64_t>(sequence - position);
+        if (difference == 0) {
+            if (mWrite.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (difference < 0) {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = mWrite.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->mLevel = level;
+    slot->mFromSrt = fromSrt;
+    slot->mTime = std::chrono::system_clock::now();
+    slot->mSize = message.size() < kMaxMessageSize ? message.size() : kMaxMessageSize;
+    message.copy(slot->mMessage, slot->mSize);
+    // Sequentially consistent, pairs with the logger thread announcing that it goes to sleep
+    slot->mSequence.store(position + 1);
+
+    if (mSleeping) {
+        std::lock_guard<std::mutex> lock(mWakeMtx);
+        mWakeCondition.notify_one();
+    }
+    return true;
+}
+
+size_t SRTNetLogger::drain() {
+    size_t drained = 0;
+    std::lock_guard<std::mutex> lock(mSinkMtx);
+    while (true) {
+        Slot& slot = mSlots[mRead & kRingMask];
+        if (slot.mSequence.load(std::memory_order_acquire) != mRead + 1) {
+            break;
+        }
+        Record record;
+        record.mLevel = slot.mLevel;
+        record.mFromSrt = slot.mFromSrt;
+        record.mTime = slot.mTime;
+        record.mMessage = std::string_view(slot.mMessage, slot.mSize);
+        if (mSink) {
+            mSink(record);
+        } else {
+            defaultSink(record);
+        }
+        // Free the slot for the producers one lap ahead
+        slot.mSequence.store(mRead + kRingSize, std::memory_order_release);
+        mRead++;
+        drained++;
+        mDrained.fetch_add(1, std::memory_order_release);
+    }
+    return drained;
+}
+
+void SRTNetLogger::drainWorker() {
+    while (true) {
+        size_t drained = drain();
+        std::unique_lock<std::mutex> lock(mWakeMtx);
+        if (!mActive) {
+            break;
+        }
+        if (drained == 0) {
+            mSleeping = true;
+            if (mSlots[mRead & kRingMask].mSequence.load() != mRead + 1) {
+                // The timeout only guards the shutdown, new records always wake the thread
+                mWakeCondition.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            mSleeping = false;
+        }
+    }
+    drain();
+}
+
+bool SRTNetLogger::flush(std::chrono::milliseconds timeout) {
+    uint64_t target = mWrite.load();
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (mDrained.load(std::memory_order_acquire) < target) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void SRTNetLogger::defaultSink(const Record& record) {
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(record.mTime.time_since_epoch()).count();
+    char timestamp[32];
+    std::snprintf(timestamp, sizeof(timestamp), "%lld.%03lld ", static_cast<long long>(time / 1000),
+                  static_cast<long long>(time % 1000));
+    std::cout << timestamp << levelName(record.mLevel) << (record.mFromSrt ? "[srt] " : "") << record.mMessage
+              << std::endl;
+}
@@ -0,0 +1,143 @@
+//
+// Asynchronous logging for SRTNet and libsrt
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Log levels, a level logs itself and all levels above it
+#define LOGG_NOTIFY 1
+#define LOGG_WARN 2
+#define LOGG_ERROR 4
+#define LOGG_FATAL 8
+#define LOGG_OFF 16 // setLevel only, nothing is logged
+#define LOGG_MASK  LOGG_NOTIFY | LOGG_WARN | LOGG_ERROR | LOGG_FATAL //What to logg?
+
+///
+/// @brief The log backend of SRTNet. Log calls copy the record into a lock-free ring buffer and return, a background
+/// thread drains the ring and hands the records to the sink. The logging threads never wait for console or file I/O.
+/// When the ring is full new records are dropped and counted, see getDroppedRecords.
+///
+/// There is one logger per process since libsrt logging is process wide as well.
+class SRTNetLogger {
+public:
+    static constexpr size_t kMaxMessageSize = 512;
+    static constexpr size_t kRingSize = 1024;
+
+    // One log record as handed to the sink
+    struct Record {
+        int mLevel = LOGG_NOTIFY;                     // LOGG_NOTIFY, LOGG_WARN, LOGG_ERROR or LOGG_FATAL
+        bool mFromSrt = false;                        // The record is from libsrt
+        std::chrono::system_clock::time_point mTime;  // When the record was logged
+        std::string_view mMessage;                    // Valid during the sink call only
+    };
+
+    /// Receives the records on the logger thread, one call at a time
+    using Sink = std::function<void(const Record& record)>;
+
+    /// @return The process wide logger, the logger thread is started on first use
+    static SRTNetLogger& get();
+
+    ///
+    /// @brief Set the lowest level to log, applies to SRTNet and to libsrt when routed, see routeSrtLogs
+    /// @param level LOGG_NOTIFY, LOGG_WARN, LOGG_ERROR, LOGG_FATAL or LOGG_OFF. The default is LOGG_NOTIFY in DEBUG
+    /// builds and LOGG_OFF otherwise, see setSink
+    void setLevel(int level);
+
+    int getLevel() const {
+        return mLevel.load(std::memory_order_relaxed);
+    }
+
+    ///
+    /// @return true if records of the level are logged. Checked before a record is formatted
+    bool isEnabled(int level) const {
+        return (level & (LOGG_MASK)) && level >= mLevel.load(std::memory_order_relaxed);
+    }
+
+    ///
+    /// @brief Set the sink receiving the records, nullptr restores the default sink writing to std::cout. Setting a sink
+    /// when the level was never set turns logging on at LOGG_ERROR
+    void setSink(Sink sink);
+
+    ///
+    /// @brief Route the libsrt logs through this logger (srt_setloghandler) with the same level filtering
+    /// @param route true to route, false to give libsrt its default stderr logging back
+    void routeSrtLogs(bool route);
+
+    ///
+    /// @brief Queue a record, never blocks
+    /// @return false if the ring is full and the record was dropped
+    bool log(int level, std::string_view message, bool fromSrt = false);
+
+    ///
+    /// @brief Wait until the records logged so far are handed to the sink
+    /// @param timeout the longest time to wait
+    /// @return true if all records were handed to the sink
+    bool flush(std::chrono::milliseconds timeout = std::chrono::milliseconds(1000));
+
+    /// @return The number of records dropped since the ring was full
+    uint64_t getDroppedRecords() const {
+        return mDropped.load(std::memory_order_relaxed);
+    }
+
+    ~SRTNetLogger();
+
+    SRTNetLogger(SRTNetLogger const&) = delete;
+    SRTNetLogger(SRTNetLogger&&) = delete;
+    SRTNetLogger& operator=(SRTNetLogger const&) = delete;
+    SRTNetLogger& operator=(SRTNetLogger&&) = delete;
+
+private:
+    SRTNetLogger();
+
+    // A ring slot, mSequence tells producers and the consumer whose turn it is (bounded MPSC queue)
+    struct Slot {
+        std::atomic<uint64_t> mSequence = {0};
+        int mLevel = 0;
+        bool mFromSrt = false;
+        std::chrono::system_clock::time_point mTime;
+        size_t mSize = 0;
+        char mMessage[kMaxMessageSize];
+    };
+
+    static void srtLogHandler(void* opaque, int level, const char* file, int line, const char* area,
+                              const char* message);
+
+    static void defaultSink(const Record& record);
+
+    void applySrtLevel() const;
+
+    void drainWorker();
+
+    /// Hand the queued records to the sink
+    /// @return the number of records drained
+    size_t drain();
+
+    std::unique_ptr<Slot[]> mSlots;
+    alignas(64) std::atomic<uint64_t> mWrite = {0};
+    alignas(64) uint64_t mRead = 0;
+    std::atomic<uint64_t> mDrained = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::atomic<int> mLevel;
+    std::atomic<bool> mLevelSet = {false};
+    std::atomic<bool> mRouteSrt = {false};
+
+    std::mutex mSinkMtx;
+    Sink mSink = nullptr;
+
+    std::mutex mWakeMtx;
+    std::condition_variable mWakeCondition;
+    std::atomic<bool> mSleeping = {false};
+    bool mActive = true;
+    std::thread mThread;
+};
@@ -0,0 +1,310 @@
+//
+// Logical streams with priorities multiplexed on one SRT connection
+//
+
+#include "SRTNetMux.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "SRTNetInternal.h"
+
+namespace {
+
+/// Bytes a rate allows over a time
+double bytesFor(int64_t bitrate, int64_t microseconds) {
+    return static_cast<double>(bitrate) * static_cast<double>(microseconds) / 8000000.0;
+}
+
+/// Microseconds until a token bucket at a rate holds bytes
+int64_t microsecondsFor(int64_t bitrate, double bytes) {
+    return static_cast<int64_t>(bytes * 8000000.0 / static_cast<double>(bitrate)) + 1;
+}
+
+} // namespace
+
+SRTNetMux::~SRTNetMux() {
+    stop();
+}
+
+int SRTNetMux::openStream(const StreamConfig& config) {
+    if (mThread.joinable()) {
+        SRT_LOGGER(true, LOGG_ERROR, "Streams are opened before the mux is started");
+        return -1;
+    }
+    if (config.mQueueSize == 0 || config.mWeight == 0 || config.mMaxBitrate < 0 ||
+        mStreams.size() > std::numeric_limits<uint16_t>::max()) {
+        SRT_LOGGER(true, LOGG_ERROR, "The stream needs a queue size and a weight of at least 1");
+        return -1;
+    }
+    auto stream = std::make_unique<Stream>();
+    stream->mConfig = config;
+    stream->mId = static_cast<uint16_t>(mStreams.size());
+    stream->mCapacity = 1;
+    while (stream->mCapacity < config.mQueueSize) {
+        stream->mCapacity <<= 1;
+    }
+    stream->mMessages = std::make_unique<Message[]>(stream->mCapacity);
+    mStreams.push_back(std::move(stream));
+    return static_cast<int>(mStreams.size() - 1);
+}
+
+bool SRTNetMux::start(SRTNetCore& net, const Config& config) {
+    if (mThread.joinable()) {
+        SRT_LOGGER(true, LOGG_ERROR, "The mux is already started");
+        return false;
+    }
+    if (mStreams.empty() || config.mBitrate < 0 || config.mBurst.count() <= 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The mux needs a stream and a burst window");
+        return false;
+    }
+    mNet = &net;
+    mConfig = config;
+
+    // Group the streams by priority, every level keeps its own virtual time
+    mOrder.clear();
+    for (auto& stream : mStreams) {
+        mOrder.push_back(stream.get());
+    }
+    std::stable_sort(mOrder.begin(), mOrder.end(),
+                     [](const Stream* a, const Stream* b) { return a->mConfig.mPriority > b->mConfig.mPriority; });
+    mLevelClocks.clear();
+    for (size_t i = 0; i < mOrder.size(); ++i) {
+        if (i == 0 || mOrder[i]->mConfig.mPriority != mOrder[i - 1]->mConfig.mPriority) {
+            mLevelClocks.push_back(0.0);
+        }
+        mOrder[i]->mLevel = mLevelClocks.size() - 1;
+    }
+
+    int64_t now = srt_time_now();
+    mTokens = 0.0;
+    mLastRefill = now;
+    for (auto& stream : mStreams) {
+        stream->mVirtualTime = 0.0;
+        stream->mTokens = 0.0;
+        stream->mLastRefill = now;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = true;
+    }
+    mThread = std::thread(&SRTNetMux::schedulerWorker, this);
+    return true;
+}
+
+void SRTNetMux::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = false;
+        mCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    for (auto& stream : mStreams) {
+        size_t write = stream->mWrite.load();
+        stream->mDropped.fetch_add(write - stream->mRead.load(), std::memory_order_relaxed);
+        stream->mRead.store(write);
+    }
+}
+
+bool SRTNetMux::send(int stream, const uint8_t* data, size_t size, const SRT_MSGCTRL* msgCtrl) {
+    if (stream < 0 || static_cast<size_t>(stream) >= mStreams.size()) {
+        return false;
+    }
+    Stream& target = *mStreams[stream];
+    size_t write = target.mWrite.load(std::memory_order_relaxed);
+    if (size > kMaxPayloadSize || write - target.mRead.load(std::memory_order_acquire) == target.mCapacity) {
+        target.mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Message& message = target.mMessages[write & (target.mCapacity - 1)];
+    message.mQueued = srt_time_now();
+    message.mMsgCtrl = msgCtrl ? *msgCtrl : srt_msgctrl_default;
+    message.mSize = kHeaderSize + size;
+    message.mData[0] = kMagic;
+    message.mData[1] = kVersion;
+    message.mData[2] = static_cast<uint8_t>(target.mId >> 8);
+    message.mData[3] = static_cast<uint8_t>(target.mId);
+    std::memcpy(message.mData + kHeaderSize, data, size);
+    // Sequentially consistent, pairs with the scheduler announcing that it goes to sleep
+    target.mWrite.store(write + 1);
+    if (mSleeping) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCondition.notify_one();
+    }
+    return true;
+}
+
+bool SRTNetMux::getStreamStatistics(int stream, StreamStatistics& stats) const {
+    if (stream < 0 || static_cast<size_t>(stream) >= mStreams.size()) {
+        return false;
+    }
+    const Stream& source = *mStreams[stream];
+    stats.mSent = source.mSent.load(std::memory_order_relaxed);
+    stats.mBytes = source.mBytes.load(std::memory_order_relaxed);
+    stats.mDropped = source.mDropped.load(std::memory_order_relaxed);
+    stats.mExpired = source.mExpired.load(std::memory_order_relaxed);
+    stats.mSendFailures = source.mSendFailures.load(std::memory_order_relaxed);
+    stats.mQueueDepth = source.mWrite.load() - source.mRead.load();
+    return true;
+}
+
+void SRTNetMux::schedulerWorker() {
+    const double burst = std::max(bytesFor(mConfig.mBitrate, std::chrono::duration_cast<std::chrono::microseconds>(
+                                                                   mConfig.mBurst).count()),
+                                  static_cast<double>(SRT_LIVE_MAX_PLSIZE));
+    while (true) {
+        int64_t now = srt_time_now();
+        int64_t wait = std::numeric_limits<int64_t>::max();
+        Stream* stream = selectStream(now, wait);
+        if (stream == nullptr) {
+            // The timeout only guards the shutdown when nothing is held back by a bitrate, sends always wake the
+            // scheduler
+            auto timeout = std::chrono::microseconds(std::min<int64_t>(wait, 100000));
+            if (!waitForSend(timeout, wait == std::numeric_limits<int64_t>::max())) {
+                break;
+            }
+            continue;
+        }
+
+        if (mConfig.mBitrate > 0) {
+            mTokens = std::min(burst, mTokens + bytesFor(mConfig.mBitrate, now - mLastRefill));
+            mLastRefill = now;
+            const Message& head = stream->mMessages[stream->mRead.load(std::memory_order_relaxed) &
+                                                    (stream->mCapacity - 1)];
+            auto size = static_cast<double>(head.mSize);
+            if (mTokens < size) {
+                // Select again after the wait, a message of a higher priority may have come meanwhile
+                auto timeout = std::chrono::microseconds(microsecondsFor(mConfig.mBitrate, size - mTokens));
+                if (!waitForSend(timeout, false)) {
+                    break;
+                }
+                continue;
+            }
+            mTokens -= size;
+        }
+        sendHead(*stream, now);
+    }
+}
+
+SRTNetMux::Stream* SRTNetMux::selectStream(int64_t now, int64_t& wait) {
+    Stream* best = nullptr;
+    double bestStart = 0.0;
+    for (size_t i = 0; i < mOrder.size(); ++i) {
+        Stream& stream = *mOrder[i];
+        if (best && stream.mLevel != best->mLevel) {
+            break; // A stream of a higher priority sends
+        }
+        dropExpired(stream, now);
+        size_t read = stream.mRead.load(std::memory_order_relaxed);
+        if (read == stream.mWrite.load(std::memory_order_acquire)) {
+            continue;
+        }
+        const Message& head = stream.mMessages[read & (stream.mCapacity - 1)];
+        if (stream.mConfig.mMaxBitrate > 0) {
+            auto size = static_cast<double>(head.mSize);
+            // A full message may always be banked, so a stream at its limit still sends its largest messages
+            stream.mTokens = std::min(std::max(size, bytesFor(stream.mConfig.mMaxBitrate, 10000)),
+                                      stream.mTokens + bytesFor(stream.mConfig.mMaxBitrate, now - stream.mLastRefill));
+            stream.mLastRefill = now;
+            if (stream.mTokens < size) {
+                wait = std::min(wait, microsecondsFor(stream.mConfig.mMaxBitrate, size - stream.mTokens));
+                continue;
+            }
+        }
+        // Start time fair queueing, a stream that was idle starts at the virtual time of its level
+        double start = std::max(stream.mVirtualTime, mLevelClocks[stream.mLevel]);
+        if (best == nullptr || start < bestStart) {
+            best = &stream;
+            bestStart = start;
+        }
+    }
+    return best;
+}
+
+void SRTNetMux::dropExpired(Stream& stream, int64_t now) {
+    if (stream.mConfig.mTtl.count() <= 0) {
+        return;
+    }
+    const int64_t ttl = std::chrono::duration_cast<std::chrono::microseconds>(stream.mConfig.mTtl).count();
+    size_t read = stream.mRead.load(std::memory_order_relaxed);
+    size_t write = stream.mWrite.load(std::memory_order_acquire);
+    size_t expired = 0;
+    while (read != write && now - stream.mMessages[read & (stream.mCapacity - 1)].mQueued >= ttl) {
+        read++;
+        expired++;
+    }
+    if (expired) {
+        stream.mExpired.fetch_add(expired, std::memory_order_relaxed);
+        stream.mRead.store(read, std::memory_order_release);
+    }
+}
+
+void SRTNetMux::sendHead(Stream& stream, int64_t now) {
+    size_t read = stream.mRead.load(std::memory_order_relaxed);
+    Message& message = stream.mMessages[read & (stream.mCapacity - 1)];
+    if (stream.mConfig.mTtl.count() > 0) {
+        // What is left of the TTL, SRT drops the message when it can not send it within that
+        int64_t left = std::chrono::duration_cast<std::chrono::milliseconds>(stream.mConfig.mTtl).count() -
+                       (now - message.mQueued) / 1000;
+        message.mMsgCtrl.msgttl = static_cast<int>(std::max<int64_t>(left, 1));
+    }
+    if (mNet->sendData(message.mData, message.mSize, &message.mMsgCtrl, mConfig.mTarget)) {
+        stream.mSent.fetch_add(1, std::memory_order_relaxed);
+        stream.mBytes.fetch_add(message.mSize - kHeaderSize, std::memory_order_relaxed);
+    } else {
+        stream.mSendFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    auto size = static_cast<double>(message.mSize);
+    if (stream.mConfig.mMaxBitrate > 0) {
+        stream.mTokens -= size;
+    }
+    double start = std::max(stream.mVirtualTime, mLevelClocks[stream.mLevel]);
+    stream.mVirtualTime = start + size / static_cast<double>(stream.mConfig.mWeight);
+    mLevelClocks[stream.mLevel] = start;
+    stream.mRead.store(read + 1, std::memory_order_release);
+}
+
+bool SRTNetMux::waitForSend(std::chrono::microseconds timeout, bool idle) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mActive) {
+        return false;
+    }
+    mSleeping = true;
+    bool queued = false;
+    if (idle) {
+        // Sends always wake the scheduler, also the ones between the select and the announcement above
+        for (auto& stream : mStreams) {
+            queued = queued || stream->mWrite.load() != stream->mRead.load();
+        }
+    }
+    if (!queued) {
+        mCondition.wait_for(lock, timeout);
+    }
+    mSleeping = false;
+    return true;
+}
+
+void SRTNetDemux::setStreamCallback(int stream, Callback callback) {
+    mCallbacks[stream] = std::move(callback);
+}
+
+bool SRTNetDemux::receive(const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, SRTSOCKET socket) {
+    if (size < SRTNetMux::kHeaderSize || data[0] != SRTNetMux::kMagic || data[1] != SRTNetMux::kVersion) {
+        return false;
+    }
+    int stream = (data[2] << 8) | data[3];
+    auto iterator = mCallbacks.find(stream);
+    if (iterator == mCallbacks.end() || !iterator->second) {
+        mUnknown.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    iterator->second(data + SRTNetMux::kHeaderSize, size - SRTNetMux::kHeaderSize, msgCtrl, socket);
+    return true;
+}
+
+uint64_t SRTNetDemux::getUnknownStreamMessages() const {
+    return mUnknown.load(std::memory_order_relaxed);
+}
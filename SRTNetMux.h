@@ -0,0 +1,190 @@
+//
+// Logical streams with priorities multiplexed on one SRT connection
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SRTNet.h"
+
+///
+/// @brief Sends several logical streams over one connection in priority order instead of in the order they were
+/// handed over. Every message carries a 4 byte stream header, SRTNetDemux takes it off on the receive side.
+///
+/// Every stream queues its messages, the scheduler thread hands them to SRT:
+/// - A stream of a higher priority always goes first
+/// - Streams of the same priority share what is left by their mWeight
+/// - A stream never sends more than its mMaxBitrate
+/// - Messages older than mTtl are dropped in the queue, the time left is sent as SRT_MSGCTRL::msgttl so SRT drops them
+///   too when they can not be sent in time
+///
+/// Priorities only matter when the messages queue up in the mux and not in SRT, set mBitrate a little below what the
+/// link carries.
+///
+/// SRTNetMux mux;
+/// SRTNetMux::StreamConfig audio;
+/// audio.mPriority = 10;
+/// audio.mTtl = std::chrono::milliseconds(200);
+/// int audioStream = mux.openStream(audio);
+/// mux.start(mySRTNetClient, config);
+/// mux.send(audioStream, data, size);
+class SRTNetMux {
+public:
+    static constexpr size_t kHeaderSize = 4;
+    static constexpr uint8_t kMagic = 0xfb;
+    static constexpr uint8_t kVersion = 1;
+    static constexpr size_t kMaxPayloadSize = SRT_LIVE_MAX_PLSIZE - kHeaderSize;
+
+    struct Config {
+        int64_t mBitrate = 0;                   // Bits per second handed to SRT, 0 == as fast as SRT takes them
+        std::chrono::milliseconds mBurst{5};    // Bytes of this long at mBitrate may go out back to back
+        SRTSOCKET mTarget = 0;                  // The client to send to when net is a server, see sendData
+    };
+
+    struct StreamConfig {
+        int mPriority = 0;                      // Higher goes first
+        uint32_t mWeight = 1;                   // Share among the streams of the same priority
+        int64_t mMaxBitrate = 0;                // Bits per second, 0 == no limit
+        std::chrono::milliseconds mTtl{0};      // Drop messages not sent this long after send, 0 == never
+        size_t mQueueSize = 1024;               // Messages queued, rounded up to a power of two
+    };
+
+    struct StreamStatistics {
+        uint64_t mSent = 0;                     // Messages handed to SRT
+        uint64_t mBytes = 0;                    // Payload bytes handed to SRT
+        uint64_t mDropped = 0;                  // Messages dropped since the queue was full or they were too large
+        uint64_t mExpired = 0;                  // Messages dropped in the queue since their TTL expired
+        uint64_t mSendFailures = 0;             // Messages sendData failed for
+        size_t mQueueDepth = 0;                 // Messages queued now
+    };
+
+    ~SRTNetMux();
+
+    ///
+    /// @brief Add a stream, streams are opened before start
+    /// @return The stream id, -1 if the mux is started, the config is not valid or there are 65536 streams
+    int openStream(const StreamConfig& config);
+
+    ///
+    /// @brief Start the scheduler thread
+    /// @param net the SRTNet to send with, it must be kept alive until the mux is stopped
+    /// @return false if the mux is already started, has no streams or the config is not valid
+    bool start(SRTNetCore& net, const Config& config);
+
+    ///
+    /// @brief Stop the scheduler thread, queued messages are dropped. Streams stay open
+    void stop();
+
+    ///
+    /// @brief Queue a message on a stream, never blocks. Call it for one stream from one thread at a time
+    /// @param stream the stream id from openStream
+    /// @param data the message, at most kMaxPayloadSize bytes
+    /// @param size the message size
+    /// @param msgCtrl copied to the message, msgttl is set by the stream TTL. nullptr == srt_msgctrl_default
+    /// @return false if the message was dropped
+    bool send(int stream, const uint8_t* data, size_t size, const SRT_MSGCTRL* msgCtrl = nullptr);
+
+    ///
+    /// @return false if there is no such stream
+    bool getStreamStatistics(int stream, StreamStatistics& stats) const;
+
+private:
+    struct Message {
+        int64_t mQueued = 0;                    // SRT clock, microseconds
+        size_t mSize = 0;                       // Including the header
+        SRT_MSGCTRL mMsgCtrl;
+        uint8_t mData[SRT_LIVE_MAX_PLSIZE];
+    };
+
+    struct Stream {
+        StreamConfig mConfig;
+        uint16_t mId = 0;
+        size_t mLevel = 0;                      // Index of the priority level in mLevelClocks
+
+        // Single producer single consumer queue, send is the producer and the scheduler the consumer
+        size_t mCapacity = 0;
+        std::unique_ptr<Message[]> mMessages;
+        alignas(64) std::atomic<size_t> mWrite = {0};
+        alignas(64) std::atomic<size_t> mRead = {0};
+
+        // Scheduler state
+        double mVirtualTime = 0.0;              // Bytes sent over the weight, the stream furthest behind goes next
+        double mTokens = 0.0;                   // Bytes mMaxBitrate allows now
+        int64_t mLastRefill = 0;
+
+        std::atomic<uint64_t> mSent = {0};
+        std::atomic<uint64_t> mBytes = {0};
+        std::atomic<uint64_t> mDropped = {0};
+        std::atomic<uint64_t> mExpired = {0};
+        std::atomic<uint64_t> mSendFailures = {0};
+    };
+
+    void schedulerWorker();
+
+    /// @return The stream to send from next, nullptr if none may send now. wait is set to the microseconds until a
+    /// stream held back by its bitrate may send
+    Stream* selectStream(int64_t now, int64_t& wait);
+
+    /// Drop the expired messages at the head of the queue of a stream
+    void dropExpired(Stream& stream, int64_t now);
+
+    void sendHead(Stream& stream, int64_t now);
+
+    /// Wait for a send, at most timeout
+    /// @param idle true if no stream has a message queued, a message queued meanwhile ends the wait
+    /// @return false if the mux was stopped
+    bool waitForSend(std::chrono::microseconds timeout, bool idle);
+
+    SRTNetCore* mNet = nullptr;
+    Config mConfig;
+    std::vector<std::unique_ptr<Stream>> mStreams;
+    std::vector<Stream*> mOrder;                // Highest priority first
+    std::vector<double> mLevelClocks;           // The virtual time of every priority level
+    double mTokens = 0.0;                       // Bytes mBitrate allows now
+    int64_t mLastRefill = 0;
+    std::thread mThread;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mActive = false;
+    std::atomic<bool> mSleeping = {false};
+};
+
+///
+/// @brief Takes the stream header of SRTNetMux off received messages and calls the callback of the stream.
+/// Set the callbacks before the first message is received.
+///
+/// SRTNetDemux demux;
+/// demux.setStreamCallback(audioStream, [](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, SRTSOCKET socket) {
+/// });
+/// mySRTNetServer.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, ...) {
+///     demux.receive(data, size, msgCtrl, socket);
+/// };
+class SRTNetDemux {
+public:
+    using Callback = std::function<void(const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, SRTSOCKET socket)>;
+
+    void setStreamCallback(int stream, Callback callback);
+
+    ///
+    /// @brief Hand a received message to the callback of its stream
+    /// @return false if the message has no stream header, nothing is done with it
+    bool receive(const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, SRTSOCKET socket);
+
+    /// @return Messages of streams without a callback
+    uint64_t getUnknownStreamMessages() const;
+
+private:
+    std::map<int, Callback> mCallbacks;
+    std::atomic<uint64_t> mUnknown = {0};
+};
@@ -0,0 +1,177 @@
+//
+// Receive side playout pacing on the SRT source time
+//
+
+#include "SRTNetPlayout.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "SRTNetInternal.h"
+
+namespace {
+
+// The RFC 3550 jitter estimator moves 1/16 of the way to every new sample
+constexpr double kJitterGain = 1.0 / 16.0;
+
+} // namespace
+
+SRTNetPlayoutPacer::~SRTNetPlayoutPacer() {
+    stop();
+}
+
+bool SRTNetPlayoutPacer::start(const Config& config, Callback callback) {
+    if (mThread.joinable()) {
+        SRT_LOGGER(true, LOGG_ERROR, "The playout pacer is already started");
+        return false;
+    }
+    if (config.mQueueSize == 0 || !callback) {
+        SRT_LOGGER(true, LOGG_ERROR, "The playout pacer needs a callback and a queue size of at least 1");
+        return false;
+    }
+    mConfig = config;
+    mCallback = std::move(callback);
+    mCapacity = 1;
+    while (mCapacity < config.mQueueSize) {
+        mCapacity <<= 1;
+    }
+    mMessages = std::make_unique<Message[]>(mCapacity);
+    mWrite = 0;
+    mRead = 0;
+    mLastDue = 0;
+    mLastRelease = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = true;
+    }
+    mThread = std::thread(&SRTNetPlayoutPacer::pacerWorker, this);
+    return true;
+}
+
+void SRTNetPlayoutPacer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = false;
+        mCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    size_t write = mWrite.load();
+    mDropped.fetch_add(write - mRead.load(), std::memory_order_relaxed);
+    mRead.store(write);
+}
+
+bool SRTNetPlayoutPacer::push(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+    size_t write = mWrite.load(std::memory_order_relaxed);
+    size_t read = mRead.load(std::memory_order_acquire);
+    if (!mMessages || size > kMaxMessageSize || write - read == mCapacity) {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    int64_t now = srt_time_now();
+    Message& message = mMessages[write & (mCapacity - 1)];
+    message.mDue = (msgCtrl.srctime ? msgCtrl.srctime : now) + mConfig.mOffset.count();
+    message.mLate = message.mDue < now;
+    message.mMsgCtrl = msgCtrl;
+    message.mSize = size;
+    std::memcpy(message.mData, data, size);
+    // Sequentially consistent, pairs with the pacer announcing that it goes to sleep
+    mWrite.store(write + 1);
+    size_t depth = write + 1 - read;
+    if (depth > mMaxDepth.load(std::memory_order_relaxed)) {
+        mMaxDepth.store(depth, std::memory_order_relaxed);
+    }
+    if (mSleeping) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCondition.notify_one();
+    }
+    return true;
+}
+
+SRTNetPlayoutPacer::Statistics SRTNetPlayoutPacer::getStatistics() const {
+    Statistics stats;
+    stats.mReleased = mReleased.load(std::memory_order_relaxed);
+    stats.mLate = mLate.load(std::memory_order_relaxed);
+    stats.mDropped = mDropped.load(std::memory_order_relaxed);
+    stats.mQueueDepth = mWrite.load() - mRead.load();
+    stats.mMaxQueueDepth = mMaxDepth.load(std::memory_order_relaxed);
+    uint64_t onTime = mOnTime.load(std::memory_order_relaxed);
+    stats.mMeanError =
+        onTime ? static_cast<double>(mErrorSum.load(std::memory_order_relaxed)) / static_cast<double>(onTime) : 0.0;
+    stats.mMaxError = mMaxError.load(std::memory_order_relaxed);
+    stats.mJitter = mJitter.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SRTNetPlayoutPacer::pacerWorker() {
+    while (true) {
+        size_t read = mRead.load(std::memory_order_relaxed);
+        if (read != mWrite.load(std::memory_order_acquire)) {
+            Message& message = mMessages[read & (mCapacity - 1)];
+            if (!waitUntil(message.mDue)) {
+                break;
+            }
+            int64_t now = srt_time_now();
+            mCallback(message.mData, message.mSize, message.mMsgCtrl);
+            addRelease(message, now);
+            mRead.store(read + 1, std::memory_order_release);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        if (!mActive) {
+            break;
+        }
+        mSleeping = true;
+        if (mRead.load() == mWrite.load()) {
+            // The timeout only guards the shutdown, new messages always wake the pacer
+            mCondition.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        mSleeping = false;
+    }
+}
+
+bool SRTNetPlayoutPacer::waitUntil(int64_t due) {
+    const int64_t spin = mConfig.mSpin.count();
+    while (true) {
+        int64_t remaining = due - srt_time_now();
+        if (remaining <= 0) {
+            return true;
+        }
+        if (remaining > spin) {
+            // Sleep until the spin window, stop wakes the pacer
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (!mActive) {
+                return false;
+            }
+            mCondition.wait_for(lock, std::chrono::microseconds(remaining - spin));
+        } else {
+            // At most mSpin, stop is seen at the next sleep
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SRTNetPlayoutPacer::addRelease(const Message& message, int64_t now) {
+    mReleased.fetch_add(1, std::memory_order_relaxed);
+    if (message.mLate) {
+        mLate.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        int64_t error = now - message.mDue;
+        mOnTime.fetch_add(1, std::memory_order_relaxed);
+        mErrorSum.fetch_add(error, std::memory_order_relaxed);
+        if (error > mMaxError.load(std::memory_order_relaxed)) {
+            mMaxError.store(error, std::memory_order_relaxed);
+        }
+    }
+    if (mLastRelease != 0) {
+        // How much the release spacing differs from the source spacing
+        int64_t difference = (now - mLastRelease) - (message.mDue - mLastDue);
+        double jitter = mJitter.load(std::memory_order_relaxed);
+        jitter += (static_cast<double>(std::llabs(difference)) - jitter) * kJitterGain;
+        mJitter.store(jitter, std::memory_order_relaxed);
+    }
+    mLastDue = message.mDue;
+    mLastRelease = now;
+}
@@ -0,0 +1,120 @@
+//
+// Receive side playout pacing on the SRT source time
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "srt/srtcore/srt.h"
+
+///
+/// @brief Releases received messages at their source time plus a fixed offset. SRT hands the messages over at their
+/// TSBPD time, but several of them can come out of one wakeup of the receive thread. The pacer copies the messages
+/// into a queue and a timer thread releases each at srctime + mOffset, so the output has the spacing of the source.
+///
+/// SRTNetPlayoutPacer pacer;
+/// SRTNetPlayoutPacer::Config config;
+/// config.mOffset = std::chrono::milliseconds(10);
+/// pacer.start(config, [&](const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) { output(data, size); });
+/// mySRTNetServer.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, ...) {
+///     pacer.push(data, size, msgCtrl);
+/// };
+class SRTNetPlayoutPacer {
+public:
+    static constexpr size_t kMaxMessageSize = 2048;
+
+    struct Config {
+        std::chrono::microseconds mOffset{10000}; // Added to srctime, covers the spread of the receive wakeups
+        size_t mQueueSize = 4096;                 // Messages queued, rounded up to a power of two
+        std::chrono::microseconds mSpin{200};     // Spin instead of sleep this close to a release, 0 == always sleep
+    };
+
+    /// Gets the messages on the pacer thread at their release time
+    using Callback = std::function<void(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl)>;
+
+    struct Statistics {
+        uint64_t mReleased = 0;     // Messages handed to the callback
+        uint64_t mLate = 0;         // Messages that were already due when pushed, released at once
+        uint64_t mDropped = 0;      // Messages dropped since the queue was full or they were too large
+        size_t mQueueDepth = 0;     // Messages queued now
+        size_t mMaxQueueDepth = 0;  // The deepest the queue has been
+        double mMeanError = 0.0;    // Microseconds, mean of release time - due time, late messages excluded
+        int64_t mMaxError = 0;      // Microseconds, largest release time - due time, late messages excluded
+        double mJitter = 0.0;       // Microseconds, interarrival jitter of the released messages (RFC 3550)
+    };
+
+    ~SRTNetPlayoutPacer();
+
+    ///
+    /// @brief Start the pacer thread
+    /// @param config the offset and queue size
+    /// @param callback gets the messages at their release time
+    /// @return false if the pacer is already started or the config is not valid
+    bool start(const Config& config, Callback callback);
+
+    ///
+    /// @brief Stop the pacer thread, queued messages are dropped
+    void stop();
+
+    ///
+    /// @brief Queue a received message, never blocks. Call it from one thread at a time, normally the
+    /// receivedDataNoCopy callback. A message without srctime is timed from when it is pushed
+    /// @return false if the message was dropped
+    bool push(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl);
+
+    Statistics getStatistics() const;
+
+private:
+    struct Message {
+        int64_t mDue = 0;   // SRT clock, microseconds
+        bool mLate = false; // Already due when pushed
+        SRT_MSGCTRL mMsgCtrl;
+        size_t mSize = 0;
+        uint8_t mData[kMaxMessageSize];
+    };
+
+    void pacerWorker();
+
+    /// Wait until the SRT clock reaches due
+    /// @return false if the pacer was stopped meanwhile
+    bool waitUntil(int64_t due);
+
+    void addRelease(const Message& message, int64_t now);
+
+    Config mConfig;
+    Callback mCallback = nullptr;
+    std::thread mThread;
+
+    // Single producer single consumer queue, push is the producer and the pacer thread the consumer. SRT delivers in
+    // source time order, so the oldest message is always the next one due
+    size_t mCapacity = 0;
+    std::unique_ptr<Message[]> mMessages;
+    alignas(64) std::atomic<size_t> mWrite = {0};
+    alignas(64) std::atomic<size_t> mRead = {0};
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mActive = false;
+    std::atomic<bool> mSleeping = {false};
+
+    // Pacer thread state
+    int64_t mLastDue = 0;
+    int64_t mLastRelease = 0;
+
+    std::atomic<uint64_t> mReleased = {0};
+    std::atomic<uint64_t> mLate = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::atomic<size_t> mMaxDepth = {0};
+    std::atomic<uint64_t> mOnTime = {0};
+    std::atomic<int64_t> mErrorSum = {0};
+    std::atomic<int64_t> mMaxError = {0};
+    std::atomic<double> mJitter = {0.0};
+};
@@ -0,0 +1,542 @@
+//
+// Records received messages to disk, see SRTNetCore::setRecorder
+//
+
+#include "SRTNetRecorder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(SRTNET_IO_URING)
+#include <liburing.h>
+#endif
+
+#include "SRTNetInternal.h"
+
+namespace {
+
+int64_t microsecondsSinceEpoch() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+int openFile(const std::string& path) {
+#ifdef WIN32
+    return _open(path.c_str(), _O_BINARY | _O_WRONLY | _O_CREAT | _O_TRUNC, _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+}
+
+void closeFile(int& file) {
+    if (file < 0) {
+        return;
+    }
+#ifdef WIN32
+    _close(file);
+#else
+    ::close(file);
+#endif
+    file = -1;
+}
+
+/// @brief Write all of data at offset
+/// @return true if everything was written
+bool writeAt(int file, const uint8_t* data, size_t size, uint64_t offset) {
+#ifdef WIN32
+    if (_lseeki64(file, static_cast<__int64>(offset), SEEK_SET) < 0) {
+        return false;
+    }
+#endif
+    while (size > 0) {
+#ifdef WIN32
+        int written = _write(file, data, static_cast<unsigned int>(size));
+#else
+        ssize_t written = ::pwrite(file, data, size, static_cast<off_t>(offset));
+#endif
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+/// @brief Append data at the current position of a file
+bool append(int file, const void* data, size_t size) {
+#ifdef WIN32
+    return _write(file, data, static_cast<unsigned int>(size)) == static_cast<int>(size);
+#else
+    return ::write(file, data, size) == static_cast<ssize_t>(size);
+#endif
+}
+
+} // namespace
+
+///
+/// @brief Collects the writes of one round of the writer thread and submits them together. With io_uring all writes
+/// of the round go to the kernel with one system call, writes io_uring did not complete are retried with pwrite.
+class SRTNetRecorder::Writer {
+public:
+    struct Request {
+        size_t mWrite = 0; // Index into the pending writes
+        int mFile = -1;
+        const uint8_t* mData = nullptr;
+        size_t mSize = 0;
+        uint64_t mOffset = 0;
+        bool mDone = false;
+    };
+
+    Writer() {
+#if defined(SRTNET_IO_URING)
+        mUseRing = io_uring_queue_init(kRingEntries, &mRing, 0) == 0;
+        if (!mUseRing) {
+            SRT_LOGGER(true, LOGG_WARN, "io_uring is not available, the recorder uses pwrite");
+        }
+#endif
+    }
+
+    ~Writer() {
+#if defined(SRTNET_IO_URING)
+        if (mUseRing) {
+            io_uring_queue_exit(&mRing);
+        }
+#endif
+    }
+
+    void add(size_t write, int file, const uint8_t* data, size_t size, uint64_t offset) {
+        Request request;
+        request.mWrite = write;
+        request.mFile = file;
+        request.mData = data;
+        request.mSize = size;
+        request.mOffset = offset;
+        mRequests.push_back(request);
+    }
+
+    void submit() {
+#if defined(SRTNET_IO_URING)
+        if (mUseRing) {
+            submitToRing();
+        }
+#endif
+        for (auto& request : mRequests) {
+            if (!request.mDone) {
+                request.mDone = writeAt(request.mFile, request.mData, request.mSize, request.mOffset);
+            }
+        }
+    }
+
+    std::vector<Request>& getRequests() {
+        return mRequests;
+    }
+
+private:
+#if defined(SRTNET_IO_URING)
+    static constexpr unsigned kRingEntries = 64;
+
+    void submitToRing() {
+        for (size_t begin = 0; begin < mRequests.size(); begin += kRingEntries) {
+            size_t end = std::min(mRequests.size(), begin + kRingEntries);
+            unsigned submitted = 0;
+            for (size_t i = begin; i < end; ++i) {
+                io_uring_sqe* sqe = io_uring_get_sqe(&mRing);
+                if (!sqe) {
+                    break;
+                }
+                Request& request = mRequests[i];
+                io_uring_prep_write(sqe, request.mFile, request.mData, static_cast<unsigned>(request.mSize),
+                                    request.mOffset);
+                io_uring_sqe_set_data(sqe, &request);
+                submitted++;
+            }
+            if (io_uring_submit_and_wait(&mRing, submitted) < 0) {
+                // Nothing reached the kernel, pwrite takes over
+                io_uring_queue_exit(&mRing);
+                mUseRing = false;
+                SRT_LOGGER(true, LOGG_ERROR, "io_uring_submit failed, the recorder uses pwrite");
+                return;
+            }
+            for (unsigned i = 0; i < submitted; ++i) {
+                io_uring_cqe* cqe = nullptr;
+                if (io_uring_wait_cqe(&mRing, &cqe) < 0) {
+                    break;
+                }
+                auto request = static_cast<Request*>(io_uring_cqe_get_data(cqe));
+                request->mDone = cqe->res == static_cast<int>(request->mSize);
+                io_uring_cqe_seen(&mRing, cqe);
+            }
+        }
+    }
+
+    io_uring mRing{};
+    bool mUseRing = false;
+#endif
+    std::vector<Request> mRequests;
+};
+
+SRTNetRecorder::SRTNetRecorder(const Config& config)
+    : mConfig(config) {
+    mConfig.mBufferSize = (mConfig.mBufferSize + kAlignment - 1) / kAlignment * kAlignment;
+    if (mConfig.mBufferSize == 0) {
+        mConfig.mBufferSize = kAlignment;
+    }
+    if (mConfig.mBuffersPerConnection < 2) {
+        mConfig.mBuffersPerConnection = 2;
+    }
+    mThread = std::thread(&SRTNetRecorder::writerWorker, this);
+}
+
+SRTNetRecorder::~SRTNetRecorder() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = false;
+        mCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+std::shared_ptr<SRTNetRecording> SRTNetRecorder::open(const std::string& name) {
+    return std::make_shared<SRTNetRecording>(*this, name);
+}
+
+SRTNetRecorder::Statistics SRTNetRecorder::getStatistics() const {
+    Statistics recorderStats;
+    recorderStats.mRecords = mRecords.load(std::memory_order_relaxed);
+    recorderStats.mRecordsDropped = mRecordsDropped.load(std::memory_order_relaxed);
+    recorderStats.mBytesWritten = mBytesWritten.load(std::memory_order_relaxed);
+    recorderStats.mFiles = mFiles.load(std::memory_order_relaxed);
+    recorderStats.mWriteErrors = mWriteErrors.load(std::memory_order_relaxed);
+    return recorderStats;
+}
+
+SRTNetRecorder::Buffer* SRTNetRecorder::takeFreeBuffer(SRTNetRecording& recording) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (recording.mFreeBuffers.empty()) {
+        return nullptr;
+    }
+    Buffer* buffer = recording.mFreeBuffers.back();
+    recording.mFreeBuffers.pop_back();
+    return buffer;
+}
+
+void SRTNetRecorder::releaseBuffer(SRTNetRecording& recording, Buffer* buffer) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    recording.mFreeBuffers.push_back(buffer);
+}
+
+void SRTNetRecorder::queueWrite(const std::shared_ptr<SRTNetRecording>& recording, Buffer* buffer) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.push_back({recording, buffer});
+    mCondition.notify_one();
+}
+
+void SRTNetRecorder::writerWorker() {
+    Writer writer;
+    std::vector<PendingWrite> writes;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return !mPending.empty() || !mActive; });
+            if (mPending.empty()) {
+                break;
+            }
+            writes.assign(mPending.begin(), mPending.end());
+            mPending.clear();
+        }
+        writeBuffers(writer, writes);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto& write : writes) {
+                write.mRecording->mFreeBuffers.push_back(write.mBuffer);
+            }
+        }
+        writes.clear();
+    }
+}
+
+void SRTNetRecorder::writeBuffers(Writer& writer, std::vector<PendingWrite>& writes) {
+    size_t begin = 0;
+    for (size_t i = 0; i < writes.size(); ++i) {
+        SRTNetRecording& recording = *writes[i].mRecording;
+        Buffer& buffer = *writes[i].mBuffer;
+        if (recording.mFile >= 0 && recording.mOpenFileNumber != buffer.mFileNumber) {
+            // The recording moves on to its next file, the writes to the current one must complete first
+            completeWrites(writer, writes, begin, i);
+            begin = i;
+        }
+        if (prepareFile(recording, buffer)) {
+            writer.add(i, recording.mFile, buffer.mData.get(), buffer.mFill, buffer.mFileOffset);
+        }
+    }
+    completeWrites(writer, writes, begin, writes.size());
+}
+
+void SRTNetRecorder::completeWrites(Writer& writer, std::vector<PendingWrite>& writes, size_t begin, size_t end) {
+    writer.submit();
+    std::vector<bool> written(end - begin, false);
+    for (auto& request : writer.getRequests()) {
+        written[request.mWrite - begin] = request.mDone;
+    }
+    writer.getRequests().clear();
+    for (size_t i = begin; i < end; ++i) {
+        finishBuffer(*writes[i].mRecording, *writes[i].mBuffer, written[i - begin]);
+    }
+}
+
+bool SRTNetRecorder::prepareFile(SRTNetRecording& recording, const Buffer& buffer) {
+    if (recording.mOpenFileNumber == buffer.mFileNumber) {
+        // Open, or the open failed and the rest of the file is dropped
+        return recording.mFile >= 0;
+    }
+    closeFile(recording.mFile);
+    closeFile(recording.mIndexFile);
+    recording.mOpenFileNumber = buffer.mFileNumber;
+
+    std::string path = mConfig.mDirectory + "/" + mConfig.mPrefix + "-" + recording.mName + "-" +
+                       recording.mStartTime + "-" + std::to_string(buffer.mFileNumber) + ".srtcap";
+    recording.mFile = openFile(path);
+    if (recording.mFile < 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "Failed to open " << path << ": " << std::strerror(errno));
+        mWriteErrors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    recording.mIndexFile = openFile(path + ".idx");
+    if (recording.mIndexFile < 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "Failed to open " << path << ".idx: " << std::strerror(errno));
+        mWriteErrors.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        SRTNetCaptureFileHeader header;
+        std::memcpy(header.mMagic, kSRTNetIndexMagic, sizeof(header.mMagic));
+        append(recording.mIndexFile, &header, sizeof(header));
+    }
+    mFiles.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SRTNetRecorder::finishBuffer(SRTNetRecording& recording, Buffer& buffer, bool written) {
+    if (written) {
+        mBytesWritten.fetch_add(buffer.mFill, std::memory_order_relaxed);
+        if (recording.mIndexFile >= 0 && !buffer.mIndex.empty()) {
+            append(recording.mIndexFile, buffer.mIndex.data(), buffer.mIndex.size() * sizeof(SRTNetCaptureIndexEntry));
+        }
+    } else if (recording.mFile >= 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "Failed to write recording " << recording.mName);
+        mWriteErrors.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (buffer.mLastOfFile) {
+        closeFile(recording.mFile);
+        closeFile(recording.mIndexFile);
+    }
+}
+
+SRTNetRecording::SRTNetRecording(SRTNetRecorder& recorder, std::string name)
+    : mRecorder(recorder)
+    , mName(std::move(name))
+    , mStartTime(std::to_string(microsecondsSinceEpoch() / 1000000)) {
+    const SRTNetRecorder::Config& config = mRecorder.mConfig;
+    mBuffers.resize(config.mBuffersPerConnection);
+    for (auto& buffer : mBuffers) {
+        buffer.mData.reset(new (std::align_val_t(SRTNetRecorder::kAlignment)) uint8_t[config.mBufferSize]);
+        buffer.mIndex.reserve(16);
+        mFreeBuffers.push_back(&buffer);
+    }
+}
+
+SRTNetRecording::~SRTNetRecording() {
+    // Only reached when the writer is done with the recording
+    closeFile(mFile);
+    closeFile(mIndexFile);
+}
+
+bool SRTNetRecording::drop() {
+    mRecorder.mRecordsDropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool SRTNetRecording::write(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+    if (mClosed) {
+        return false;
+    }
+    const SRTNetRecorder::Config& config = mRecorder.mConfig;
+    SRTNetCaptureRecordHeader header;
+    header.mArrivalTime = microsecondsSinceEpoch();
+    header.mSrcTime = msgCtrl.srctime;
+    header.mMsgNo = msgCtrl.msgno;
+    header.mSize = static_cast<uint32_t>(size);
+    size_t recordSize = sizeof(header) + size;
+    if (recordSize > config.mBufferSize) {
+        return drop();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    bool rotate = mActive && ((config.mMaxFileSize && mFileOffset + recordSize > config.mMaxFileSize &&
+                               mFileOffset > sizeof(SRTNetCaptureFileHeader)) ||
+                              (config.mMaxFileDuration.count() && now - mFileStarted >= config.mMaxFileDuration));
+    if (!mActive || rotate) {
+        SRTNetRecorder::Buffer* buffer = mSpare ? mSpare : mRecorder.takeFreeBuffer(*this);
+        if (!buffer) {
+            return drop();
+        }
+        mSpare = nullptr;
+        if (mActive) {
+            submitBuffer(true);
+        }
+        mFileNumber++;
+        mFileOffset = 0;
+        mFileStarted = now;
+        mLastIndexTime = 0;
+        startBuffer(buffer, now);
+        SRTNetCaptureFileHeader fileHeader;
+        std::memcpy(fileHeader.mMagic, kSRTNetCaptureMagic, sizeof(fileHeader.mMagic));
+        append(reinterpret_cast<const uint8_t*>(&fileHeader), sizeof(fileHeader));
+    } else if (mActive->mFill > 0 && now - mActive->mStarted >= config.mFlushInterval) {
+        // Do not keep a slow stream in memory for long, write what there is
+        SRTNetRecorder::Buffer* buffer = mSpare ? mSpare : mRecorder.takeFreeBuffer(*this);
+        if (buffer) {
+            mSpare = nullptr;
+            submitBuffer(false);
+            startBuffer(buffer, now);
+        }
+    }
+
+    // Get the buffer for the part that does not fit before anything is copied, a record is never split by a drop
+    if (recordSize >= config.mBufferSize - mActive->mFill && !mSpare) {
+        mSpare = mRecorder.takeFreeBuffer(*this);
+        if (!mSpare) {
+            return drop();
+        }
+    }
+
+    if (header.mArrivalTime - mLastIndexTime >=
+        std::chrono::duration_cast<std::chrono::microseconds>(config.mIndexInterval).count()) {
+        mActive->mIndex.push_back({header.mArrivalTime, mFileOffset});
+        mLastIndexTime = header.mArrivalTime;
+    }
+    append(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    append(data, size);
+    mRecorder.mRecords.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void SRTNetRecording::append(const uint8_t* data, size_t size) {
+    const size_t bufferSize = mRecorder.mConfig.mBufferSize;
+    while (size > 0) {
+        size_t room = bufferSize - mActive->mFill;
+        size_t part = size < room ? size : room;
+        std::memcpy(mActive->mData.get() + mActive->mFill, data, part);
+        mActive->mFill += part;
+        mFileOffset += part;
+        data += part;
+        size -= part;
+        if (mActive->mFill == bufferSize) {
+            // A full buffer, the spare was taken before the record was started
+            submitBuffer(false);
+            startBuffer(mSpare, std::chrono::steady_clock::now());
+            mSpare = nullptr;
+        }
+    }
+}
+
+void SRTNetRecording::startBuffer(SRTNetRecorder::Buffer* buffer, std::chrono::steady_clock::time_point now) {
+    buffer->mFill = 0;
+    buffer->mFileNumber = mFileNumber;
+    buffer->mFileOffset = mFileOffset;
+    buffer->mLastOfFile = false;
+    buffer->mStarted = now;
+    buffer->mIndex.clear();
+    mActive = buffer;
+}
+
+void SRTNetRecording::submitBuffer(bool lastOfFile) {
+    mActive->mLastOfFile = lastOfFile;
+    mRecorder.queueWrite(shared_from_this(), mActive);
+    mActive = nullptr;
+}
+
+void SRTNetRecording::close() {
+    if (mClosed) {
+        return;
+    }
+    mClosed = true;
+    if (mActive) {
+        submitBuffer(true);
+    }
+    if (mSpare) {
+        mRecorder.releaseBuffer(*this, mSpare);
+        mSpare = nullptr;
+    }
+}
+
+bool SRTNetCaptureReader::open(const std::string& path) {
+    mIndex.clear();
+    mFile.close();
+    mFile.clear();
+    mFile.open(path, std::ios::binary);
+    SRTNetCaptureFileHeader header;
+    if (!mFile.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.mMagic, kSRTNetCaptureMagic, sizeof(header.mMagic)) != 0) {
+        mFile.close();
+        return false;
+    }
+
+    std::ifstream index(path + ".idx", std::ios::binary);
+    SRTNetCaptureFileHeader indexHeader;
+    if (index.read(reinterpret_cast<char*>(&indexHeader), sizeof(indexHeader)) &&
+        std::memcmp(indexHeader.mMagic, kSRTNetIndexMagic, sizeof(indexHeader.mMagic)) == 0) {
+        SRTNetCaptureIndexEntry entry;
+        while (index.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+            mIndex.push_back(entry);
+        }
+    }
+    return true;
+}
+
+bool SRTNetCaptureReader::next(SRTNetCaptureRecordHeader& header, std::vector<uint8_t>& payload) {
+    if (!mFile.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    payload.resize(header.mSize);
+    return static_cast<bool>(mFile.read(reinterpret_cast<char*>(payload.data()), header.mSize));
+}
+
+bool SRTNetCaptureReader::seek(int64_t arrivalTime) {
+    // The last index entry at or before the time, the records in between are skipped by reading their headers
+    uint64_t offset = sizeof(SRTNetCaptureFileHeader);
+    auto entry = std::upper_bound(mIndex.begin(), mIndex.end(), arrivalTime,
+                                  [](int64_t time, const SRTNetCaptureIndexEntry& indexEntry) {
+                                      return time < indexEntry.mArrivalTime;
+                                  });
+    if (entry != mIndex.begin()) {
+        offset = std::prev(entry)->mOffset;
+    }
+    mFile.clear();
+    mFile.seekg(static_cast<std::streamoff>(offset));
+    SRTNetCaptureRecordHeader header;
+    while (mFile.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        if (header.mArrivalTime >= arrivalTime) {
+            mFile.seekg(-static_cast<std::streamoff>(sizeof(header)), std::ios::cur);
+            return true;
+        }
+        mFile.seekg(header.mSize, std::ios::cur);
+    }
+    return false;
+}
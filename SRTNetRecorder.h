@@ -0,0 +1,258 @@
+//
+// Records received messages to disk, see SRTNetCore::setRecorder
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "srt/srtcore/srt.h"
+
+// Capture file layout, all numbers in host byte order:
+//
+// SRTNetCaptureFileHeader
+// SRTNetCaptureRecordHeader, payload (mSize bytes), SRTNetCaptureRecordHeader, payload ...
+//
+// Every capture file has an index file (same name + ".idx") to seek by time:
+//
+// SRTNetCaptureFileHeader (mMagic kSRTNetIndexMagic)
+// SRTNetCaptureIndexEntry, SRTNetCaptureIndexEntry ...
+
+constexpr char kSRTNetCaptureMagic[8] = {'S', 'R', 'T', 'N', 'C', 'A', 'P', '1'};
+constexpr char kSRTNetIndexMagic[8] = {'S', 'R', 'T', 'N', 'I', 'D', 'X', '1'};
+
+struct SRTNetCaptureFileHeader {
+    char mMagic[8];
+    uint32_t mVersion = 1;
+    uint32_t mReserved = 0;
+};
+
+struct SRTNetCaptureRecordHeader {
+    int64_t mArrivalTime = 0; // Microseconds since the epoch (system clock) when the message was received
+    int64_t mSrcTime = 0;     // SRT_MSGCTRL srctime of the message
+    int32_t mMsgNo = 0;       // SRT_MSGCTRL msgno of the message
+    uint32_t mSize = 0;       // Payload bytes following the header
+};
+
+struct SRTNetCaptureIndexEntry {
+    int64_t mArrivalTime = 0; // Arrival time of the record at mOffset
+    uint64_t mOffset = 0;     // File offset of the record header
+};
+
+static_assert(sizeof(SRTNetCaptureFileHeader) == 16, "Unexpected capture file header size");
+static_assert(sizeof(SRTNetCaptureRecordHeader) == 24, "Unexpected capture record header size");
+static_assert(sizeof(SRTNetCaptureIndexEntry) == 16, "Unexpected capture index entry size");
+
+class SRTNetRecording;
+
+///
+/// @brief Writes received messages to capture files. The receive thread copies every message into a large buffer of
+/// its connection, full buffers are written by a background thread. The receive thread never waits for the disk, when
+/// all buffers of a connection are waiting to be written new messages are dropped and counted.
+/// The writes use io_uring when SRTNet is built with SRTNET_IO_URING and the kernel supports it, pwrite otherwise.
+class SRTNetRecorder {
+public:
+    struct Config {
+        std::string mDirectory = ".";                   // Where to put the capture files
+        std::string mPrefix = "srtnet";                 // File names are <prefix>-<name>-<start time>-<number>.srtcap
+        uint64_t mMaxFileSize = 1024 * 1024 * 1024;     // Start a new file before this size, 0 == no limit
+        std::chrono::seconds mMaxFileDuration{0};       // Start a new file after this time, 0 == no limit
+        size_t mBufferSize = 1024 * 1024;               // Bytes per write, rounded up to a multiple of 4096
+        size_t mBuffersPerConnection = 4;               // Buffers a connection can fill while the disk is busy
+        std::chrono::milliseconds mFlushInterval{1000}; // Write a partly filled buffer when it gets this old
+        std::chrono::milliseconds mIndexInterval{1000}; // Time between index entries
+    };
+
+    struct Statistics {
+        uint64_t mRecords = 0;        // Messages recorded
+        uint64_t mRecordsDropped = 0; // Messages dropped since the writer could not keep up
+        uint64_t mBytesWritten = 0;   // Bytes written to the capture files
+        uint64_t mFiles = 0;          // Capture files created
+        uint64_t mWriteErrors = 0;    // Failed writes and file opens
+    };
+
+    ///
+    /// @brief A buffer of a connection, filled by the receive thread and written by the writer thread
+    struct Buffer {
+        struct AlignedDelete {
+            void operator()(uint8_t* data) const {
+                ::operator delete[](data, std::align_val_t(kAlignment));
+            }
+        };
+        std::unique_ptr<uint8_t[], AlignedDelete> mData;
+        size_t mFill = 0;
+        uint64_t mFileNumber = 0;   // The file the buffer belongs to
+        uint64_t mFileOffset = 0;   // File offset of the first byte
+        bool mLastOfFile = false;   // Close the file when the buffer is written
+        std::chrono::steady_clock::time_point mStarted;
+        std::vector<SRTNetCaptureIndexEntry> mIndex; // Index entries of the records starting in this buffer
+    };
+
+    static constexpr size_t kAlignment = 4096;
+
+    explicit SRTNetRecorder(const Config& config);
+
+    ~SRTNetRecorder();
+
+    ///
+    /// @brief Start recording a connection
+    /// @param name part of the file names, the socket id or peer for example
+    /// @return The recording, write to it from one thread at a time and close it when the connection is gone
+    std::shared_ptr<SRTNetRecording> open(const std::string& name);
+
+    Statistics getStatistics() const;
+
+    const Config& getConfig() const {
+        return mConfig;
+    }
+
+    SRTNetRecorder(SRTNetRecorder const&) = delete;
+    SRTNetRecorder(SRTNetRecorder&&) = delete;
+    SRTNetRecorder& operator=(SRTNetRecorder const&) = delete;
+    SRTNetRecorder& operator=(SRTNetRecorder&&) = delete;
+
+private:
+    friend class SRTNetRecording;
+
+    // Submits the writes of the writer thread, io_uring or pwrite
+    class Writer;
+
+    struct PendingWrite {
+        std::shared_ptr<SRTNetRecording> mRecording;
+        Buffer* mBuffer;
+    };
+
+    /// @return A free buffer of the recording, nullptr if all are waiting to be written
+    Buffer* takeFreeBuffer(SRTNetRecording& recording);
+
+    void releaseBuffer(SRTNetRecording& recording, Buffer* buffer);
+
+    /// Queue a buffer for the writer thread
+    void queueWrite(const std::shared_ptr<SRTNetRecording>& recording, Buffer* buffer);
+
+    void writerWorker();
+
+    /// Write the buffers, the files are opened and closed as the buffers require
+    void writeBuffers(Writer& writer, std::vector<PendingWrite>& writes);
+
+    /// Submit the writes added to the writer and finish the buffers [begin, end)
+    void completeWrites(Writer& writer, std::vector<PendingWrite>& writes, size_t begin, size_t end);
+
+    /// Make sure the file of the buffer is open
+    /// @return false if the file could not be opened
+    bool prepareFile(SRTNetRecording& recording, const Buffer& buffer);
+
+    /// Write the index entries of a written buffer and close the files if it was the last buffer of the file
+    void finishBuffer(SRTNetRecording& recording, Buffer& buffer, bool written);
+
+    Config mConfig;
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<PendingWrite> mPending;
+    bool mActive = true;
+    std::thread mThread;
+
+    std::atomic<uint64_t> mRecords = {0};
+    std::atomic<uint64_t> mRecordsDropped = {0};
+    std::atomic<uint64_t> mBytesWritten = {0};
+    std::atomic<uint64_t> mFiles = {0};
+    std::atomic<uint64_t> mWriteErrors = {0};
+};
+
+///
+/// @brief The recording of one connection, see SRTNetRecorder::open
+class SRTNetRecording : public std::enable_shared_from_this<SRTNetRecording> {
+public:
+    SRTNetRecording(SRTNetRecorder& recorder, std::string name);
+
+    ~SRTNetRecording();
+
+    ///
+    /// @brief Record a received message, never blocks
+    /// @return false if the message was dropped
+    bool write(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl);
+
+    ///
+    /// @brief Write what is buffered and close the files, no more messages are recorded
+    void close();
+
+private:
+    friend class SRTNetRecorder;
+
+    /// Make buffer the active buffer, continuing at the current file offset
+    void startBuffer(SRTNetRecorder::Buffer* buffer, std::chrono::steady_clock::time_point now);
+
+    /// Hand the active buffer to the writer
+    void submitBuffer(bool lastOfFile);
+
+    /// Drop a message and count it
+    bool drop();
+
+    void append(const uint8_t* data, size_t size);
+
+    SRTNetRecorder& mRecorder;
+    const std::string mName;
+    const std::string mStartTime;
+
+    // Receive thread state
+    SRTNetRecorder::Buffer* mActive = nullptr;
+    SRTNetRecorder::Buffer* mSpare = nullptr;
+    uint64_t mFileNumber = 0;
+    uint64_t mFileOffset = 0;
+    std::chrono::steady_clock::time_point mFileStarted;
+    int64_t mLastIndexTime = 0;
+    bool mClosed = false;
+
+    // Buffers, the free list is guarded by the recorder mutex
+    std::vector<SRTNetRecorder::Buffer> mBuffers;
+    std::vector<SRTNetRecorder::Buffer*> mFreeBuffers;
+
+    // Writer thread state
+    uint64_t mOpenFileNumber = 0;
+    int mFile = -1;
+    int mIndexFile = -1;
+};
+
+///
+/// @brief Reads a capture file written by SRTNetRecorder
+class SRTNetCaptureReader {
+public:
+    ///
+    /// @brief Open a capture file and its index file if there is one
+    /// @return false if the file can not be read or is not a capture file
+    bool open(const std::string& path);
+
+    ///
+    /// @brief Read the next record
+    /// @param header the record header
+    /// @param payload the record payload
+    /// @return false at the end of the file or if the file is truncated
+    bool next(SRTNetCaptureRecordHeader& header, std::vector<uint8_t>& payload);
+
+    ///
+    /// @brief Position the reader at the first record that arrived at or after arrivalTime, uses the index to skip
+    /// most of the file
+    /// @param arrivalTime microseconds since the epoch, see SRTNetCaptureRecordHeader
+    /// @return false if there is no such record
+    bool seek(int64_t arrivalTime);
+
+    /// @return The index entries, empty if the file has no index
+    const std::vector<SRTNetCaptureIndexEntry>& getIndex() const {
+        return mIndex;
+    }
+
+private:
+    std::ifstream mFile;
+    std::vector<SRTNetCaptureIndexEntry> mIndex;
+};
@@ -0,0 +1,349 @@
+//
+// Forwards the messages of one connection to many SRTNet outputs
+//
+
+#include "SRTNetRelay.h"
+
+#include <condition_variable>
+#include <ctime>
+#include <thread>
+
+#include "SRTNetInternal.h"
+
+namespace {
+
+/// @return The CPU time used by the calling thread
+std::chrono::nanoseconds threadCpuTime() {
+#ifdef WIN32
+    FILETIME creation;
+    FILETIME exit;
+    FILETIME kernel;
+    FILETIME user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return std::chrono::nanoseconds(0);
+    }
+    auto ticks = [](const FILETIME& time) {
+        return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+    // FILETIME counts 100 ns ticks
+    return std::chrono::nanoseconds((ticks(kernel) + ticks(user)) * 100);
+#else
+    timespec time{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif
+}
+
+} // namespace
+
+struct SRTNetRelay::Buffer {
+    std::atomic<uint32_t> mReferences = {0};
+    Buffer* mNext = nullptr; // Next free buffer, only used while the buffer is in the pool
+    size_t mSize = 0;
+    SRT_MSGCTRL mMsgCtrl = srt_msgctrl_default;
+    std::chrono::steady_clock::time_point mIngested;
+    uint8_t mData[kMaxMessageSize];
+};
+
+///
+/// @brief The queue and the sender thread of one output. The ingest thread is the only producer and the sender thread
+/// the only consumer. Dropping the oldest message makes the producer consume as well, so both sides claim messages by
+/// moving mRead with a compare exchange.
+class SRTNetRelay::Output {
+public:
+    Output(SRTNetRelay& relay, int id, SendFunction send, const OutputConfig& config)
+        : mId(id)
+        , mRelay(relay)
+        , mSend(std::move(send))
+        , mConfig(config) {
+        mCapacity = 1;
+        while (mCapacity < config.mQueueSize) {
+            mCapacity <<= 1;
+        }
+        mSlots = std::make_unique<std::atomic<Buffer*>[]>(mCapacity);
+        mThread = std::thread(&Output::sendWorker, this);
+    }
+
+    ~Output() {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mActive = false;
+            mCondition.notify_one();
+        }
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        while (Buffer* buffer = pop()) {
+            mRelay.releaseBuffer(buffer);
+        }
+    }
+
+    ///
+    /// @brief Producer side, queue a reference to the buffer
+    /// @return false if the buffer was not queued, the reference is still the caller's
+    bool push(Buffer* buffer) {
+        size_t write = mWrite.load(std::memory_order_relaxed);
+        size_t read = mRead.load(std::memory_order_acquire);
+        if (write - read == mCapacity) {
+            if (mConfig.mDropPolicy == DropPolicy::newest) {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            Buffer* oldest = mSlots[read & (mCapacity - 1)].load(std::memory_order_acquire);
+            if (mRead.compare_exchange_strong(read, read + 1, std::memory_order_acq_rel)) {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                mRelay.releaseBuffer(oldest);
+            }
+            // Either way there is room now, otherwise the sender took the oldest message first
+        }
+        mSlots[write & (mCapacity - 1)].store(buffer, std::memory_order_release);
+        // Sequentially consistent, pairs with the sender announcing that it goes to sleep
+        mWrite.store(write + 1);
+        size_t depth = write + 1 - mRead.load(std::memory_order_relaxed);
+        if (depth > mMaxDepth.load(std::memory_order_relaxed)) {
+            mMaxDepth.store(depth, std::memory_order_relaxed);
+        }
+        if (mSleeping) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCondition.notify_one();
+        }
+        return true;
+    }
+
+    void getStatistics(OutputStatistics& outputStats) const {
+        outputStats.mForwarded = mForwarded.load(std::memory_order_relaxed);
+        outputStats.mDropped = mDropped.load(std::memory_order_relaxed);
+        outputStats.mSendFailures = mSendFailures.load(std::memory_order_relaxed);
+        outputStats.mQueueDepth = mWrite.load() - mRead.load();
+        outputStats.mMaxQueueDepth = mMaxDepth.load(std::memory_order_relaxed);
+        uint64_t sent = outputStats.mForwarded + outputStats.mSendFailures;
+        outputStats.mMeanLatency =
+            sent ? static_cast<double>(mLatencySum.load(std::memory_order_relaxed)) / static_cast<double>(sent) : 0.0;
+        outputStats.mMaxLatency = mMaxLatency.load(std::memory_order_relaxed);
+        outputStats.mCpuTime = std::chrono::nanoseconds(mCpuTime.load(std::memory_order_relaxed));
+    }
+
+    const int mId;
+
+private:
+    // Read the CPU time of the thread every this many messages, and whenever the queue runs empty
+    static constexpr uint64_t kCpuTimeInterval = 64;
+
+    ///
+    /// @brief Consumer side, take the oldest message
+    /// @return The buffer, the reference is now the caller's, nullptr if the queue is empty
+    Buffer* pop() {
+        size_t read = mRead.load(std::memory_order_acquire);
+        while (read != mWrite.load(std::memory_order_acquire)) {
+            Buffer* buffer = mSlots[read & (mCapacity - 1)].load(std::memory_order_acquire);
+            // Fails if the producer dropped this message, read is reloaded and the next one is tried
+            if (mRead.compare_exchange_weak(read, read + 1, std::memory_order_acq_rel)) {
+                return buffer;
+            }
+        }
+        return nullptr;
+    }
+
+    void sendWorker() {
+        std::chrono::nanoseconds cpuStart = threadCpuTime();
+        uint64_t sinceCpuTime = 0;
+        while (true) {
+            Buffer* buffer = pop();
+            if (buffer) {
+                SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+                if (mConfig.mKeepSourceTime) {
+                    msgCtrl.srctime = buffer->mMsgCtrl.srctime;
+                }
+                if (mSend(buffer->mData, buffer->mSize, msgCtrl)) {
+                    mForwarded.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    mSendFailures.fetch_add(1, std::memory_order_relaxed);
+                }
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - buffer->mIngested)
+                                   .count();
+                mRelay.releaseBuffer(buffer);
+                mLatencySum.fetch_add(static_cast<uint64_t>(latency), std::memory_order_relaxed);
+                if (latency > mMaxLatency.load(std::memory_order_relaxed)) {
+                    mMaxLatency.store(latency, std::memory_order_relaxed);
+                }
+                if (++sinceCpuTime < kCpuTimeInterval) {
+                    continue;
+                }
+            }
+            sinceCpuTime = 0;
+            mCpuTime.store(static_cast<uint64_t>((threadCpuTime() - cpuStart).count()), std::memory_order_relaxed);
+            if (buffer) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (!mActive) {
+                break;
+            }
+            mSleeping = true;
+            if (mRead.load() == mWrite.load()) {
+                // The timeout only guards the shutdown, new messages always wake the sender
+                mCondition.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            mSleeping = false;
+        }
+    }
+
+    SRTNetRelay& mRelay;
+    const SendFunction mSend;
+    const OutputConfig mConfig;
+
+    size_t mCapacity;
+    std::unique_ptr<std::atomic<Buffer*>[]> mSlots;
+    alignas(64) std::atomic<size_t> mWrite = {0};
+    alignas(64) std::atomic<size_t> mRead = {0};
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mActive = true;
+    std::atomic<bool> mSleeping = {false};
+    std::thread mThread;
+
+    std::atomic<uint64_t> mForwarded = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::atomic<uint64_t> mSendFailures = {0};
+    std::atomic<size_t> mMaxDepth = {0};
+    std::atomic<uint64_t> mLatencySum = {0};
+    std::atomic<int64_t> mMaxLatency = {0};
+    std::atomic<uint64_t> mCpuTime = {0};
+};
+
+SRTNetRelay::SRTNetRelay()
+    : SRTNetRelay(Config()) {
+}
+
+SRTNetRelay::SRTNetRelay(const Config& config)
+    : mConfig(config) {
+    mBuffers = std::make_unique<Buffer[]>(mConfig.mPoolSize);
+    for (size_t i = 0; i < mConfig.mPoolSize; ++i) {
+        mBuffers[i].mNext = i + 1 < mConfig.mPoolSize ? &mBuffers[i + 1] : nullptr;
+    }
+    mFree.store(mConfig.mPoolSize ? &mBuffers[0] : nullptr);
+}
+
+SRTNetRelay::~SRTNetRelay() {
+    std::lock_guard<std::mutex> lock(mOutputsMtx);
+    // The outputs join their threads and release what they still have queued
+    mOutputs.clear();
+}
+
+int SRTNetRelay::addOutput(SRTNetCore& net) {
+    return addOutput(net, OutputConfig());
+}
+
+int SRTNetRelay::addOutput(SRTNetCore& net, const OutputConfig& config) {
+    return addOutput(
+        [&net, target = config.mTarget](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl) {
+            return net.sendData(data, size, &msgCtrl, target);
+        },
+        config);
+}
+
+int SRTNetRelay::addOutput(SendFunction send, const OutputConfig& config) {
+    if (!send) {
+        SRT_LOGGER(true, LOGG_ERROR, "The relay output needs a send function");
+        return -1;
+    }
+    if (config.mQueueSize == 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The relay output queue size must be at least 1");
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mOutputsMtx);
+    int id = mNextId++;
+    mOutputs.push_back(std::make_unique<Output>(*this, id, std::move(send), config));
+    return id;
+}
+
+bool SRTNetRelay::removeOutput(int id) {
+    std::unique_ptr<Output> output;
+    {
+        std::lock_guard<std::mutex> lock(mOutputsMtx);
+        for (auto iterator = mOutputs.begin(); iterator != mOutputs.end(); ++iterator) {
+            if ((*iterator)->mId == id) {
+                output = std::move(*iterator);
+                mOutputs.erase(iterator);
+                break;
+            }
+        }
+    }
+    // Joined outside the lock, the ingest continues to the other outputs meanwhile
+    return output != nullptr;
+}
+
+SRTNetRelay::Buffer* SRTNetRelay::takeBuffer() {
+    Buffer* buffer = mFree.load(std::memory_order_acquire);
+    while (buffer && !mFree.compare_exchange_weak(buffer, buffer->mNext, std::memory_order_acquire)) {
+    }
+    return buffer;
+}
+
+void SRTNetRelay::releaseBuffer(Buffer* buffer) {
+    if (buffer->mReferences.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    mBuffersInUse.fetch_sub(1, std::memory_order_relaxed);
+    Buffer* head = mFree.load(std::memory_order_relaxed);
+    do {
+        buffer->mNext = head;
+    } while (!mFree.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool SRTNetRelay::ingest(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+    mIngested.fetch_add(1, std::memory_order_relaxed);
+    if (size > kMaxMessageSize) {
+        mIngestDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    Buffer* buffer = takeBuffer();
+    if (!buffer) {
+        mIngestDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    mBuffersInUse.fetch_add(1, std::memory_order_relaxed);
+    std::memcpy(buffer->mData, data, size);
+    buffer->mSize = size;
+    buffer->mMsgCtrl = msgCtrl;
+    buffer->mIngested = std::chrono::steady_clock::now();
+    // The ingest holds one reference until every output has its own
+    buffer->mReferences.store(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mOutputsMtx);
+        for (auto& output : mOutputs) {
+            buffer->mReferences.fetch_add(1, std::memory_order_relaxed);
+            if (!output->push(buffer)) {
+                buffer->mReferences.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    releaseBuffer(buffer);
+    return true;
+}
+
+SRTNetRelay::Statistics SRTNetRelay::getStatistics() const {
+    Statistics stats;
+    stats.mIngested = mIngested.load(std::memory_order_relaxed);
+    stats.mIngestDropped = mIngestDropped.load(std::memory_order_relaxed);
+    stats.mBuffersInUse = mBuffersInUse.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mOutputsMtx);
+    stats.mOutputs = mOutputs.size();
+    return stats;
+}
+
+bool SRTNetRelay::getOutputStatistics(int id, OutputStatistics& outputStats) const {
+    std::lock_guard<std::mutex> lock(mOutputsMtx);
+    for (const auto& output : mOutputs) {
+        if (output->mId == id) {
+            output->getStatistics(outputStats);
+            return true;
+        }
+    }
+    return false;
+}
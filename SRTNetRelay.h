@@ -0,0 +1,144 @@
+//
+// Forwards the messages of one connection to many SRTNet outputs
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "SRTNet.h"
+
+///
+/// @brief Relays one ingest to any number of outputs. An ingested message is copied once into a refcounted buffer from
+/// a preallocated pool, every output queues a reference to the same buffer and sends it from its own thread. The
+/// buffer goes back to the pool when the last output has sent or dropped it.
+///
+/// Every output has a bounded queue and a drop policy, a slow output drops its own messages and never holds up the
+/// ingest or the other outputs.
+///
+/// SRTNet server;
+/// SRTNetRelay relay;
+/// relay.addOutput(downstreamClient);
+/// server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl, ...) {
+///     relay.ingest(data, size, msgCtrl);
+/// };
+class SRTNetRelay {
+public:
+    static constexpr size_t kMaxMessageSize = 2048;
+
+    /// What an output does with a new message when its queue is full
+    enum class DropPolicy {
+        newest, // Drop the new message
+        oldest  // Drop the oldest queued message to make room, keeps the output close to live
+    };
+
+    struct Config {
+        size_t mPoolSize = 4096; // Buffers shared by all outputs, the ingest drops messages when all are in use
+    };
+
+    /// Sends one message of an output, called on the thread of the output
+    using SendFunction = std::function<bool(const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl)>;
+
+    struct OutputConfig {
+        size_t mQueueSize = 1024;               // Messages queued per output, rounded up to a power of two
+        DropPolicy mDropPolicy = DropPolicy::oldest;
+        SRTSOCKET mTarget = 0;                  // The client to send to when the output is a server, see sendData
+        bool mKeepSourceTime = false;           // Send with the srctime of the ingested message
+    };
+
+    struct OutputStatistics {
+        uint64_t mForwarded = 0;                // Messages sent
+        uint64_t mDropped = 0;                  // Messages dropped by the drop policy
+        uint64_t mSendFailures = 0;             // Messages sendData failed for
+        size_t mQueueDepth = 0;                 // Messages queued now
+        size_t mMaxQueueDepth = 0;              // The deepest the queue has been
+        double mMeanLatency = 0.0;              // Microseconds from ingest until sendData returned
+        int64_t mMaxLatency = 0;                // Microseconds, the largest latency
+        std::chrono::nanoseconds mCpuTime{0};   // CPU time used by the thread of the output
+    };
+
+    struct Statistics {
+        uint64_t mIngested = 0;                 // Messages ingested
+        uint64_t mIngestDropped = 0;            // Messages dropped since no buffer was free or they were too large
+        size_t mBuffersInUse = 0;               // Buffers queued by at least one output
+        size_t mOutputs = 0;
+    };
+
+    SRTNetRelay();
+
+    explicit SRTNetRelay(const Config& config);
+
+    /// Removes all outputs
+    ~SRTNetRelay();
+
+    ///
+    /// @brief Add an output, it receives the messages ingested from now on
+    /// @param net the SRTNet to send with, it must be kept alive until the output is removed
+    /// @param config the queue and drop policy of the output
+    /// @return The output id, -1 if the config is not valid
+    int addOutput(SRTNetCore& net, const OutputConfig& config);
+
+    int addOutput(SRTNetCore& net);
+
+    ///
+    /// @brief Add an output sending with a function instead of an SRTNet, for destinations that are not SRT
+    /// @param send the function, it returns false if the message could not be sent. mTarget of the config is not used
+    /// @param config the queue and drop policy of the output
+    /// @return The output id, -1 if the config is not valid
+    int addOutput(SendFunction send, const OutputConfig& config);
+
+    ///
+    /// @brief Stop an output, queued messages are dropped
+    /// @param id the id returned by addOutput
+    /// @return false if there is no such output
+    bool removeOutput(int id);
+
+    ///
+    /// @brief Forward a message to all outputs, never blocks. Call it from one thread at a time, normally the
+    /// receivedDataNoCopy callback of the ingest connection
+    /// @return false if the message was dropped by the relay, drops by single outputs are not reported here
+    bool ingest(const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl);
+
+    Statistics getStatistics() const;
+
+    ///
+    /// @param id the id returned by addOutput
+    /// @param outputStats the statistics struct to populate
+    /// @return false if there is no such output
+    bool getOutputStatistics(int id, OutputStatistics& outputStats) const;
+
+    SRTNetRelay(SRTNetRelay const&) = delete;
+    SRTNetRelay(SRTNetRelay&&) = delete;
+    SRTNetRelay& operator=(SRTNetRelay const&) = delete;
+    SRTNetRelay& operator=(SRTNetRelay&&) = delete;
+
+private:
+    struct Buffer;
+    class Output;
+
+    /// Take a buffer from the pool, only called by the ingest thread
+    Buffer* takeBuffer();
+
+    /// Drop a reference, the last one returns the buffer to the pool. Called by any thread
+    void releaseBuffer(Buffer* buffer);
+
+    Config mConfig;
+    std::unique_ptr<Buffer[]> mBuffers;
+    // Free buffers, a stack linked through the buffers. Any thread pushes, only the ingest thread pops, so a popped
+    // buffer can not come back while the pop is in progress
+    std::atomic<Buffer*> mFree = {nullptr};
+
+    mutable std::mutex mOutputsMtx;
+    std::vector<std::unique_ptr<Output>> mOutputs;
+    int mNextId = 1;
+
+    std::atomic<uint64_t> mIngested = {0};
+    std::atomic<uint64_t> mIngestDropped = {0};
+    std::atomic<size_t> mBuffersInUse = {0};
+};
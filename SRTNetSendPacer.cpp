@@ -0,0 +1,271 @@
+//
+// PCR paced constant bitrate sending of MPEG-TS
+//
+
+#include "SRTNetSendPacer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "SRTNetInternal.h"
+#include "SRTNetTS.h"
+
+namespace {
+
+// PCR steps larger than this are not a rate but a jump in the stream
+constexpr int64_t kMaxPcrStep = SRTNetTS::kPcrClock;
+
+} // namespace
+
+void SRTNetSendPacer::RateMeter::add(size_t bytes, int64_t now, int64_t window) {
+    if (mFirst == 0) {
+        mFirst = now;
+        mWindowStart = now;
+    }
+    if (now - mWindowStart >= window) {
+        double rate = static_cast<double>(mWindowBytes) * 8.0 * 1000000.0 / static_cast<double>(window);
+        if (rate > mPeak.load(std::memory_order_relaxed)) {
+            mPeak.store(rate, std::memory_order_relaxed);
+        }
+        // Skip the empty windows in between
+        mWindowStart += (now - mWindowStart) / window * window;
+        mWindowBytes = 0;
+    }
+    mWindowBytes += bytes;
+    mTotalBytes += bytes;
+    if (now > mFirst) {
+        mMean.store(static_cast<double>(mTotalBytes) * 8.0 * 1000000.0 / static_cast<double>(now - mFirst),
+                    std::memory_order_relaxed);
+    }
+}
+
+SRTNetSendPacer::~SRTNetSendPacer() {
+    stop();
+}
+
+bool SRTNetSendPacer::start(SRTNetCore& net, const Config& config) {
+    if (mThread.joinable()) {
+        SRT_LOGGER(true, LOGG_ERROR, "The send pacer is already started");
+        return false;
+    }
+    if (config.mQueueSize == 0 || config.mBurstWindow.count() <= 0) {
+        SRT_LOGGER(true, LOGG_ERROR, "The send pacer needs a queue size of at least 1 and a burst window");
+        return false;
+    }
+    mNet = &net;
+    mConfig = config;
+    mCapacity = 1;
+    while (mCapacity < config.mQueueSize) {
+        mCapacity <<= 1;
+    }
+    mMessages = std::make_unique<Message[]>(mCapacity);
+    mWrite = 0;
+    mRead = 0;
+    mScanned = 0;
+    mTimed = 0;
+    mPosition = 0;
+    mPcrPid = config.mPcrPid;
+    mHavePcr = false;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = true;
+    }
+    mThread = std::thread(&SRTNetSendPacer::pacerWorker, this);
+    return true;
+}
+
+void SRTNetSendPacer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mActive = false;
+        mCondition.notify_one();
+    }
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    size_t write = mWrite.load();
+    mDropped.fetch_add(write - mRead.load(), std::memory_order_relaxed);
+    mRead.store(write);
+}
+
+bool SRTNetSendPacer::push(const uint8_t* data, size_t size) {
+    size_t write = mWrite.load(std::memory_order_relaxed);
+    if (!mMessages || size > kMaxMessageSize || write - mRead.load(std::memory_order_acquire) == mCapacity) {
+        mDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    int64_t now = srt_time_now();
+    Message& message = mMessages[write & (mCapacity - 1)];
+    message.mPushed = now;
+    message.mSize = size;
+    std::memcpy(message.mData, data, size);
+    // Sequentially consistent, pairs with the pacer announcing that it goes to sleep
+    mWrite.store(write + 1);
+    mInput.add(size, now, std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mBurstWindow).count());
+    if (mSleeping) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCondition.notify_one();
+    }
+    return true;
+}
+
+SRTNetSendPacer::Statistics SRTNetSendPacer::getStatistics() const {
+    Statistics stats;
+    stats.mMessages = mSent.load(std::memory_order_relaxed);
+    stats.mSendFailures = mSendFailures.load(std::memory_order_relaxed);
+    stats.mDropped = mDropped.load(std::memory_order_relaxed);
+    stats.mUnpaced = mUnpaced.load(std::memory_order_relaxed);
+    stats.mPcrs = mPcrs.load(std::memory_order_relaxed);
+    stats.mDiscontinuities = mDiscontinuities.load(std::memory_order_relaxed);
+    stats.mBitrate = mBitrate.load(std::memory_order_relaxed);
+    stats.mMeanRate = mInput.mMean.load(std::memory_order_relaxed);
+    stats.mInputPeakRate = mInput.mPeak.load(std::memory_order_relaxed);
+    stats.mOutputPeakRate = mOutput.mPeak.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void SRTNetSendPacer::pacerWorker() {
+    while (true) {
+        scan();
+        size_t read = mRead.load(std::memory_order_relaxed);
+        if (read == mScanned) {
+            if (!waitForPush(std::chrono::milliseconds(100))) {
+                break;
+            }
+            continue;
+        }
+
+        Message& message = mMessages[read & (mCapacity - 1)];
+        if (read < mTimed) {
+            if (!waitUntil(message.mSendTime)) {
+                break;
+            }
+            send(message, message.mSendTime);
+        } else {
+            int64_t waited = srt_time_now() - message.mPushed;
+            int64_t maxWait = std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mMaxPcrWait).count();
+            if (waited < maxWait) {
+                // Wait for the PCR that times the message
+                if (!waitForPush(std::chrono::microseconds(maxWait - waited))) {
+                    break;
+                }
+                continue;
+            }
+            mUnpaced.fetch_add(1, std::memory_order_relaxed);
+            send(message, srt_time_now());
+            // The next PCR times the messages after this one
+            mTimed = read + 1;
+        }
+        mRead.store(read + 1, std::memory_order_release);
+    }
+}
+
+void SRTNetSendPacer::scan() {
+    size_t write = mWrite.load(std::memory_order_acquire);
+    while (mScanned != write) {
+        Message& message = mMessages[mScanned & (mCapacity - 1)];
+        message.mPosition = mPosition;
+        for (size_t offset = 0; offset + SRTNetTS::kPacketSize <= message.mSize; offset += SRTNetTS::kPacketSize) {
+            const uint8_t* packet = message.mData + offset;
+            if (packet[0] != SRTNetTS::kSyncByte || !SRTNetTS::hasPcr(packet)) {
+                continue;
+            }
+            if (mPcrPid < 0) {
+                mPcrPid = SRTNetTS::pid(packet);
+            }
+            if (SRTNetTS::pid(packet) == mPcrPid) {
+                addPcr(SRTNetTS::pcr(packet), mPosition + offset, SRTNetTS::isDiscontinuity(packet));
+            }
+        }
+        mPosition += message.mSize;
+        mScanned++;
+    }
+}
+
+void SRTNetSendPacer::addPcr(int64_t pcr, uint64_t position, bool discontinuity) {
+    mPcrs.fetch_add(1, std::memory_order_relaxed);
+    const Message& current = mMessages[mScanned & (mCapacity - 1)];
+    const int64_t delay = std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mDelay).count();
+    // Where the PCR would be sent if the input had no bursts
+    const int64_t expected = current.mPushed + delay;
+
+    int64_t pcrTime = expected;
+    uint64_t bytes = position - mLastPcrPosition;
+    if (mHavePcr) {
+        int64_t ticks = SRTNetTS::pcrDifference(mLastPcr, pcr);
+        pcrTime = mLastPcrTime + ticks * 1000000 / SRTNetTS::kPcrClock;
+        // A jump in the PCR, or the muxer clock drifted a whole delay away from ours, start the timing over
+        if (discontinuity || ticks == 0 || ticks > kMaxPcrStep || bytes == 0 ||
+            std::llabs(pcrTime - expected) > delay) {
+            mDiscontinuities.fetch_add(1, std::memory_order_relaxed);
+            pcrTime = std::max(mLastPcrTime, expected);
+        } else {
+            mBitrate.store(static_cast<double>(bytes) * 8.0 * SRTNetTS::kPcrClock / static_cast<double>(ticks),
+                           std::memory_order_relaxed);
+        }
+    }
+
+    // Spread the messages since the last PCR, up to the one with this PCR, evenly over the PCR interval
+    for (size_t index = std::max(mTimed, mRead.load(std::memory_order_relaxed)); index <= mScanned; ++index) {
+        Message& message = mMessages[index & (mCapacity - 1)];
+        if (!mHavePcr || bytes == 0 || message.mPosition <= mLastPcrPosition) {
+            message.mSendTime = mHavePcr ? mLastPcrTime : pcrTime;
+        } else {
+            double share = static_cast<double>(message.mPosition - mLastPcrPosition) / static_cast<double>(bytes);
+            auto interval = static_cast<double>(pcrTime - mLastPcrTime);
+            message.mSendTime = mLastPcrTime + static_cast<int64_t>(share * interval);
+        }
+    }
+    mTimed = mScanned + 1;
+    mHavePcr = true;
+    mLastPcr = pcr;
+    mLastPcrPosition = position;
+    mLastPcrTime = pcrTime;
+}
+
+void SRTNetSendPacer::send(Message& message, int64_t srcTime) {
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    msgCtrl.srctime = srcTime;
+    if (mNet->sendData(message.mData, message.mSize, &msgCtrl, mConfig.mTarget)) {
+        mSent.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mSendFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    mOutput.add(message.mSize, srt_time_now(),
+                std::chrono::duration_cast<std::chrono::microseconds>(mConfig.mBurstWindow).count());
+}
+
+bool SRTNetSendPacer::waitUntil(int64_t time) {
+    const int64_t spin = mConfig.mSpin.count();
+    while (true) {
+        int64_t remaining = time - srt_time_now();
+        if (remaining <= 0) {
+            return true;
+        }
+        if (remaining > spin) {
+            // Sleep until the spin window, stop wakes the pacer
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (!mActive) {
+                return false;
+            }
+            mCondition.wait_for(lock, std::chrono::microseconds(remaining - spin));
+        } else {
+            // At most mSpin, stop is seen at the next sleep
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool SRTNetSendPacer::waitForPush(std::chrono::microseconds timeout) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (!mActive) {
+        return false;
+    }
+    mSleeping = true;
+    if (mWrite.load() == mScanned) {
+        // Pushes always wake the pacer
+        mCondition.wait_for(lock, timeout);
+    }
+    mSleeping = false;
+    return true;
+}
@@ -0,0 +1,153 @@
+//
+// PCR paced constant bitrate sending of MPEG-TS
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "SRTNet.h"
+
+///
+/// @brief Sends an MPEG-TS stream at the rate given by its PCRs instead of in the bursts the muxer writes. The bytes
+/// between two PCRs are spread evenly over the PCR interval, each message is handed to SRT at its time with a matching
+/// srctime. A message is timed when the next PCR has arrived, so the output runs mDelay behind the input and mDelay
+/// must cover the PCR interval of the stream.
+///
+/// The peak rate over short windows is measured before and after the pacer, see Statistics.
+///
+/// SRTNetSendPacer pacer;
+/// SRTNetSendPacer::Config config;
+/// pacer.start(mySRTNetClient, config);
+/// pacer.push(tsData, 1316); // Instead of mySRTNetClient.sendData
+class SRTNetSendPacer {
+public:
+    static constexpr size_t kMaxMessageSize = 2048;
+
+    struct Config {
+        int mPcrPid = -1;                              // The PID carrying the PCR, -1 == the first PID with a PCR
+        std::chrono::milliseconds mDelay{100};         // Output delay, longer than the PCR interval of the stream
+        std::chrono::milliseconds mMaxPcrWait{200};    // Send a message unpaced when no PCR times it this long
+        std::chrono::milliseconds mBurstWindow{10};    // Window of the peak rate measurement
+        size_t mQueueSize = 4096;                      // Messages queued, rounded up to a power of two
+        std::chrono::microseconds mSpin{200};          // Spin instead of sleep this close to a send, 0 == always sleep
+        SRTSOCKET mTarget = 0;                         // The client to send to when net is a server, see sendData
+    };
+
+    struct Statistics {
+        uint64_t mMessages = 0;        // Messages sent
+        uint64_t mSendFailures = 0;    // Messages sendData failed for
+        uint64_t mDropped = 0;         // Messages dropped since the queue was full or they were too large
+        uint64_t mUnpaced = 0;         // Messages sent without PCR timing
+        uint64_t mPcrs = 0;            // PCRs used for timing
+        uint64_t mDiscontinuities = 0; // PCR jumps the pacer restarted the timing at
+        double mBitrate = 0.0;         // Bits per second between the last two PCRs
+        double mMeanRate = 0.0;        // Bits per second, pushed bytes over the push time
+        double mInputPeakRate = 0.0;   // Bits per second, the highest rate of mBurstWindow as pushed
+        double mOutputPeakRate = 0.0;  // Bits per second, the highest rate of mBurstWindow as sent
+    };
+
+    ~SRTNetSendPacer();
+
+    ///
+    /// @brief Start the pacer thread
+    /// @param net the SRTNet to send with, it must be kept alive until the pacer is stopped
+    /// @param config the PCR PID, delay and queue size
+    /// @return false if the pacer is already started or the config is not valid
+    bool start(SRTNetCore& net, const Config& config);
+
+    ///
+    /// @brief Stop the pacer thread, queued messages are dropped
+    void stop();
+
+    ///
+    /// @brief Queue a message of whole TS packets, never blocks. Call it from one thread at a time
+    /// @return false if the message was dropped
+    bool push(const uint8_t* data, size_t size);
+
+    Statistics getStatistics() const;
+
+private:
+    ///
+    /// @brief The highest rate over a window of time, written by one thread
+    class RateMeter {
+    public:
+        void add(size_t bytes, int64_t now, int64_t window);
+
+        std::atomic<double> mPeak = {0.0};
+        std::atomic<double> mMean = {0.0};
+
+    private:
+        int64_t mFirst = 0;
+        int64_t mWindowStart = 0;
+        uint64_t mWindowBytes = 0;
+        uint64_t mTotalBytes = 0;
+    };
+
+    struct Message {
+        int64_t mPushed = 0;    // SRT clock, microseconds
+        int64_t mSendTime = 0;  // SRT clock, microseconds, valid once a PCR timed the message
+        uint64_t mPosition = 0; // Stream byte offset of the first byte
+        size_t mSize = 0;
+        uint8_t mData[kMaxMessageSize];
+    };
+
+    void pacerWorker();
+
+    /// Look for PCRs in the messages pushed since the last scan and time the messages they cover
+    void scan();
+
+    /// A PCR at stream byte position, time the messages up to it
+    void addPcr(int64_t pcr, uint64_t position, bool discontinuity);
+
+    void send(Message& message, int64_t srcTime);
+
+    /// Wait until the SRT clock reaches time
+    /// @return false if the pacer was stopped meanwhile
+    bool waitUntil(int64_t time);
+
+    /// Wait for a push, at most timeout
+    /// @return false if the pacer was stopped
+    bool waitForPush(std::chrono::microseconds timeout);
+
+    SRTNetCore* mNet = nullptr;
+    Config mConfig;
+    std::thread mThread;
+
+    // Single producer single consumer queue, push is the producer and the pacer thread the consumer
+    size_t mCapacity = 0;
+    std::unique_ptr<Message[]> mMessages;
+    alignas(64) std::atomic<size_t> mWrite = {0};
+    alignas(64) std::atomic<size_t> mRead = {0};
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mActive = false;
+    std::atomic<bool> mSleeping = {false};
+
+    // Pacer thread state
+    size_t mScanned = 0;       // Messages scanned for PCRs
+    size_t mTimed = 0;         // Messages timed
+    uint64_t mPosition = 0;    // Stream bytes scanned
+    int mPcrPid = -1;
+    bool mHavePcr = false;
+    int64_t mLastPcr = 0;
+    uint64_t mLastPcrPosition = 0;
+    int64_t mLastPcrTime = 0;  // SRT clock when the byte at mLastPcrPosition is sent
+
+    RateMeter mInput;
+    RateMeter mOutput;
+    std::atomic<uint64_t> mSent = {0};
+    std::atomic<uint64_t> mSendFailures = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::atomic<uint64_t> mUnpaced = {0};
+    std::atomic<uint64_t> mPcrs = {0};
+    std::atomic<uint64_t> mDiscontinuities = {0};
+    std::atomic<double> mBitrate = {0.0};
+};
@@ -0,0 +1,63 @@
+//
+// MPEG-TS helpers shared by the SRTNet components that look into the payload
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SRTNetTS {
+
+constexpr size_t kPacketSize = 188;
+constexpr uint8_t kSyncByte = 0x47;
+constexpr uint16_t kNullPid = 0x1fff;
+constexpr int64_t kPcrClock = 27000000;                         // PCR ticks per second
+constexpr int64_t kPcrWrap = (static_cast<int64_t>(1) << 33) * 300; // The PCR wraps at 2^33 * 300 ticks
+
+/// @return true if data is a whole number of TS packets
+inline bool isTransportStream(const uint8_t* data, size_t size) {
+    if (size == 0 || size % kPacketSize != 0) {
+        return false;
+    }
+    for (size_t offset = 0; offset < size; offset += kPacketSize) {
+        if (data[offset] != kSyncByte) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline uint16_t pid(const uint8_t* packet) {
+    return static_cast<uint16_t>(((packet[1] & 0x1f) << 8) | packet[2]);
+}
+
+inline bool hasAdaptationField(const uint8_t* packet) {
+    return (packet[3] & 0x20) && packet[4] > 0;
+}
+
+/// @return true if the packet carries a PCR
+inline bool hasPcr(const uint8_t* packet) {
+    return hasAdaptationField(packet) && packet[4] >= 7 && (packet[5] & 0x10);
+}
+
+/// @return true if the discontinuity indicator of the packet is set, the PCR does not follow the previous one
+inline bool isDiscontinuity(const uint8_t* packet) {
+    return hasAdaptationField(packet) && (packet[5] & 0x80);
+}
+
+/// @return The PCR of a packet with hasPcr, in 27 MHz ticks
+inline int64_t pcr(const uint8_t* packet) {
+    int64_t base = (static_cast<int64_t>(packet[6]) << 25) | (static_cast<int64_t>(packet[7]) << 17) |
+                   (static_cast<int64_t>(packet[8]) << 9) | (static_cast<int64_t>(packet[9]) << 1) |
+                   (packet[10] >> 7);
+    int64_t extension = (static_cast<int64_t>(packet[10] & 0x01) << 8) | packet[11];
+    return base * 300 + extension;
+}
+
+/// @return The ticks from one PCR to a later one, across the wrap
+inline int64_t pcrDifference(int64_t from, int64_t to) {
+    return (to - from + kPcrWrap) % kPcrWrap;
+}
+
+} // namespace SRTNetTS
@@ -0,0 +1,289 @@
+//
+// MPEG-TS checks of received messages: sync bytes, transport errors, continuity counters and PCR jitter
+//
+
+#include "SRTNetTSAnalyzer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "SRTNetTS.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define SRTNET_TS_SSE2
+#if defined(__GNUC__)
+// Compiled for AVX2 with the target attribute and only called when the CPU supports it
+#define SRTNET_TS_AVX2
+#endif
+#endif
+
+namespace {
+
+// Packets scanned at a time, one bit per packet in the masks
+constexpr size_t kBlock = 32;
+// A larger PCR step is a jump in the stream and not jitter
+constexpr int64_t kMaxPcrStep = SRTNetTS::kPcrClock;
+
+struct ScanResult {
+    uint32_t mSyncErrors = 0;      // Bit i set if packet i does not start with the sync byte
+    uint32_t mTransportErrors = 0; // Bit i set if packet i has the transport error indicator set
+};
+
+/// Collect the first four bytes of up to kBlock packets, byte 0 in the low bits, and flag the broken packets
+using ScanFunction = ScanResult (*)(const uint8_t* data, size_t count, uint32_t* headers);
+
+inline uint32_t readHeader(const uint8_t* packet) {
+    return static_cast<uint32_t>(packet[0]) | (static_cast<uint32_t>(packet[1]) << 8) |
+           (static_cast<uint32_t>(packet[2]) << 16) | (static_cast<uint32_t>(packet[3]) << 24);
+}
+
+void scanTail(const uint8_t* data, size_t first, size_t count, uint32_t* headers, ScanResult& result) {
+    for (size_t i = first; i < count; ++i) {
+        uint32_t header = readHeader(data + i * SRTNetTS::kPacketSize);
+        headers[i] = header;
+        if ((header & 0xff) != SRTNetTS::kSyncByte) {
+            result.mSyncErrors |= 1u << i;
+        }
+        if (header & 0x8000) {
+            result.mTransportErrors |= 1u << i;
+        }
+    }
+}
+
+ScanResult scanScalar(const uint8_t* data, size_t count, uint32_t* headers) {
+    ScanResult result;
+    scanTail(data, 0, count, headers, result);
+    return result;
+}
+
+#ifdef SRTNET_TS_SSE2
+ScanResult scanSse2(const uint8_t* data, size_t count, uint32_t* headers) {
+    ScanResult result;
+    const __m128i lowByte = _mm_set1_epi32(0xff);
+    const __m128i sync = _mm_set1_epi32(SRTNetTS::kSyncByte);
+    const __m128i transportError = _mm_set1_epi32(0x8000);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* packet = data + i * SRTNetTS::kPacketSize;
+        // SSE2 has no gather, the four headers are loaded one by one and checked together
+        __m128i header = _mm_setr_epi32(static_cast<int>(readHeader(packet)),
+                                        static_cast<int>(readHeader(packet + SRTNetTS::kPacketSize)),
+                                        static_cast<int>(readHeader(packet + 2 * SRTNetTS::kPacketSize)),
+                                        static_cast<int>(readHeader(packet + 3 * SRTNetTS::kPacketSize)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(headers + i), header);
+        __m128i synced = _mm_cmpeq_epi32(_mm_and_si128(header, lowByte), sync);
+        __m128i broken = _mm_cmpeq_epi32(_mm_and_si128(header, transportError), transportError);
+        auto syncedMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(synced)));
+        auto brokenMask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(broken)));
+        result.mSyncErrors |= (~syncedMask & 0xfu) << i;
+        result.mTransportErrors |= brokenMask << i;
+    }
+    scanTail(data, i, count, headers, result);
+    return result;
+}
+#endif
+
+#ifdef SRTNET_TS_AVX2
+__attribute__((target("avx2"))) ScanResult scanAvx2(const uint8_t* data, size_t count, uint32_t* headers) {
+    ScanResult result;
+    const __m256i offsets = _mm256_setr_epi32(0, 188, 376, 564, 752, 940, 1128, 1316);
+    const __m256i lowByte = _mm256_set1_epi32(0xff);
+    const __m256i sync = _mm256_set1_epi32(SRTNetTS::kSyncByte);
+    const __m256i transportError = _mm256_set1_epi32(0x8000);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const auto* packet = reinterpret_cast<const int*>(data + i * SRTNetTS::kPacketSize);
+        __m256i header = _mm256_i32gather_epi32(packet, offsets, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(headers + i), header);
+        __m256i synced = _mm256_cmpeq_epi32(_mm256_and_si256(header, lowByte), sync);
+        __m256i broken = _mm256_cmpeq_epi32(_mm256_and_si256(header, transportError), transportError);
+        auto syncedMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(synced)));
+        auto brokenMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(broken)));
+        result.mSyncErrors |= (~syncedMask & 0xffu) << i;
+        result.mTransportErrors |= brokenMask << i;
+    }
+    scanTail(data, i, count, headers, result);
+    return result;
+}
+#endif
+
+bool isSupported(SRTNetTSAnalyzer::Scan scan) {
+    switch (scan) {
+        case SRTNetTSAnalyzer::Scan::scalar:
+            return true;
+        case SRTNetTSAnalyzer::Scan::sse2:
+#ifdef SRTNET_TS_SSE2
+            return true;
+#else
+            return false;
+#endif
+        case SRTNetTSAnalyzer::Scan::avx2:
+#ifdef SRTNET_TS_AVX2
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+ScanFunction scanFunction(SRTNetTSAnalyzer::Scan scan) {
+    switch (scan) {
+#ifdef SRTNET_TS_SSE2
+        case SRTNetTSAnalyzer::Scan::sse2:
+            return scanSse2;
+#endif
+#ifdef SRTNET_TS_AVX2
+        case SRTNetTSAnalyzer::Scan::avx2:
+            return scanAvx2;
+#endif
+        default:
+            return scanScalar;
+    }
+}
+
+} // namespace
+
+SRTNetTSAnalyzer::SRTNetTSAnalyzer() : SRTNetTSAnalyzer(Config()) {
+}
+
+SRTNetTSAnalyzer::SRTNetTSAnalyzer(const Config& config) : mPcrPid(config.mPcrPid) {
+    if (config.mScan != Scan::automatic && isSupported(config.mScan)) {
+        mScan = config.mScan;
+    } else if (isSupported(Scan::avx2)) {
+        mScan = Scan::avx2;
+    } else if (isSupported(Scan::sse2)) {
+        mScan = Scan::sse2;
+    }
+    mPublishedPcrPid = mPcrPid;
+}
+
+void SRTNetTSAnalyzer::analyze(const uint8_t* data, size_t size, int64_t time) {
+    mMessages.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0 || size % SRTNetTS::kPacketSize != 0) {
+        mNotTransportStream.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const ScanFunction scan = scanFunction(mScan);
+    const size_t packets = size / SRTNetTS::kPacketSize;
+    uint64_t syncErrors = 0;
+    uint64_t transportErrors = 0;
+    uint64_t continuityErrors = 0;
+    uint64_t pcrs = 0;
+    uint32_t headers[kBlock];
+    for (size_t first = 0; first < packets; first += kBlock) {
+        const uint8_t* block = data + first * SRTNetTS::kPacketSize;
+        const size_t count = std::min(kBlock, packets - first);
+        ScanResult result = scan(block, count, headers);
+        for (size_t i = 0; i < count; ++i) {
+            const uint32_t bit = 1u << i;
+            // The rest of the header can not be trusted
+            if (result.mSyncErrors & bit) {
+                syncErrors++;
+            } else if (result.mTransportErrors & bit) {
+                transportErrors++;
+            } else {
+                checkPacket(block + i * SRTNetTS::kPacketSize, headers[i], time, continuityErrors, pcrs);
+            }
+        }
+    }
+    mPackets.fetch_add(packets, std::memory_order_relaxed);
+    if (syncErrors) {
+        mSyncErrors.fetch_add(syncErrors, std::memory_order_relaxed);
+    }
+    if (transportErrors) {
+        mTransportErrors.fetch_add(transportErrors, std::memory_order_relaxed);
+    }
+    if (continuityErrors) {
+        mContinuityErrors.fetch_add(continuityErrors, std::memory_order_relaxed);
+    }
+    if (pcrs) {
+        mPcrs.fetch_add(pcrs, std::memory_order_relaxed);
+    }
+}
+
+void SRTNetTSAnalyzer::checkPacket(const uint8_t* packet,
+                                   uint32_t header,
+                                   int64_t time,
+                                   uint64_t& continuityErrors,
+                                   uint64_t& pcrs) {
+    const auto pid = static_cast<uint16_t>(((header & 0x1f00) | ((header >> 16) & 0xff)));
+    const auto counter = static_cast<uint8_t>((header >> 24) & 0x0f);
+    const bool adaptationField = (header >> 24) & 0x20;
+    const bool payload = (header >> 24) & 0x10;
+    const bool discontinuity = adaptationField && SRTNetTS::isDiscontinuity(packet);
+
+    if (pid != SRTNetTS::kNullPid) {
+        uint8_t& state = mContinuity[pid];
+        const auto last = static_cast<uint8_t>(state & 0x0f);
+        if (!(state & kSeen) || discontinuity) {
+            state = kSeen | counter;
+        } else if (!payload) {
+            // The counter only counts packets with payload
+            if (counter != last) {
+                continuityErrors++;
+            }
+            state = kSeen | counter;
+        } else if (counter == last) {
+            // A packet may be sent twice, not more
+            if (state & kRepeated) {
+                continuityErrors++;
+            }
+            state |= kRepeated;
+        } else {
+            if (counter != ((last + 1) & 0x0f)) {
+                continuityErrors++;
+            }
+            state = kSeen | counter;
+        }
+    }
+
+    if (adaptationField && SRTNetTS::hasPcr(packet)) {
+        if (mPcrPid < 0) {
+            mPcrPid = pid;
+            mPublishedPcrPid.store(mPcrPid, std::memory_order_relaxed);
+        }
+        if (pid == mPcrPid) {
+            pcrs++;
+            addPcr(SRTNetTS::pcr(packet), time, discontinuity);
+        }
+    }
+}
+
+void SRTNetTSAnalyzer::addPcr(int64_t pcr, int64_t time, bool discontinuity) {
+    if (mHavePcr && !discontinuity) {
+        int64_t ticks = SRTNetTS::pcrDifference(mLastPcr, pcr);
+        if (ticks <= kMaxPcrStep) {
+            int64_t difference = std::llabs((time - mLastPcrTime) - ticks * 1000000 / SRTNetTS::kPcrClock);
+            mJitter += (static_cast<double>(difference) - mJitter) / 16.0;
+            mPcrJitter.store(static_cast<int64_t>(mJitter), std::memory_order_relaxed);
+            if (difference > mMaxPcrJitter.load(std::memory_order_relaxed)) {
+                mMaxPcrJitter.store(difference, std::memory_order_relaxed);
+            }
+        }
+    }
+    mHavePcr = true;
+    mLastPcr = pcr;
+    mLastPcrTime = time;
+}
+
+SRTNetTSAnalyzer::Statistics SRTNetTSAnalyzer::getStatistics() const {
+    Statistics stats;
+    stats.mMessages = mMessages.load(std::memory_order_relaxed);
+    stats.mPackets = mPackets.load(std::memory_order_relaxed);
+    stats.mNotTransportStream = mNotTransportStream.load(std::memory_order_relaxed);
+    stats.mSyncErrors = mSyncErrors.load(std::memory_order_relaxed);
+    stats.mTransportErrors = mTransportErrors.load(std::memory_order_relaxed);
+    stats.mContinuityErrors = mContinuityErrors.load(std::memory_order_relaxed);
+    stats.mPcrs = mPcrs.load(std::memory_order_relaxed);
+    stats.mPcrPid = mPublishedPcrPid.load(std::memory_order_relaxed);
+    stats.mPcrJitter = mPcrJitter.load(std::memory_order_relaxed);
+    stats.mMaxPcrJitter = mMaxPcrJitter.load(std::memory_order_relaxed);
+    return stats;
+}
+
+SRTNetTSAnalyzer::Scan SRTNetTSAnalyzer::getScan() const {
+    return mScan;
+}
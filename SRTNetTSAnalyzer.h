@@ -0,0 +1,95 @@
+//
+// MPEG-TS checks of received messages: sync bytes, transport errors, continuity counters and PCR jitter
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+///
+/// @brief Checks every TS packet of the messages of one connection. The headers of a message are gathered into SIMD
+/// registers and checked for the 0x47 sync byte and the transport error indicator several packets at a time (AVX2 or
+/// SSE2, picked at runtime), the continuity counters and PCRs are then followed packet by packet.
+///
+/// The PCR jitter is how much the time between two PCRs of the PCR PID differs from the PCR difference, smoothed the
+/// way RFC 3550 smooths the interarrival jitter. The time of a message is its SRT source time, the time the sender
+/// handed it to SRT, so the jitter is that of the source and not of the network that SRT evens out.
+///
+/// Call analyze from one thread at a time, getStatistics from any thread.
+///
+/// SRTNet uses one per connection, see SRTNetCore::setTSAnalysis.
+class SRTNetTSAnalyzer {
+public:
+    // How the packet headers are scanned
+    enum class Scan {
+        automatic, // The widest the CPU supports
+        scalar,
+        sse2,
+        avx2
+    };
+
+    struct Config {
+        int mPcrPid = -1;                   // The PID to measure the PCR jitter on, -1 == the first PID with a PCR
+        Scan mScan = Scan::automatic;       // A scan the CPU does not support falls back to automatic
+    };
+
+    struct Statistics {
+        uint64_t mMessages = 0;             // Messages checked
+        uint64_t mPackets = 0;              // TS packets checked
+        uint64_t mNotTransportStream = 0;   // Messages that are not a whole number of TS packets, they are not checked
+        uint64_t mSyncErrors = 0;           // Packets not starting with 0x47
+        uint64_t mTransportErrors = 0;      // Packets with the transport error indicator set
+        uint64_t mContinuityErrors = 0;     // Packets lost, out of order or repeated by their continuity counter
+        uint64_t mPcrs = 0;                 // PCRs of the PCR PID
+        int mPcrPid = -1;                   // The PID the PCR jitter is measured on, -1 == no PCR seen yet
+        int64_t mPcrJitter = 0;             // Smoothed PCR jitter, microseconds
+        int64_t mMaxPcrJitter = 0;          // The largest difference of one PCR interval, microseconds
+    };
+
+    SRTNetTSAnalyzer();
+
+    explicit SRTNetTSAnalyzer(const Config& config);
+
+    ///
+    /// @brief Check the TS packets of a message
+    /// @param data the message
+    /// @param size the message size
+    /// @param time the time the message was sent, microseconds on any clock that is the same for every message
+    void analyze(const uint8_t* data, size_t size, int64_t time);
+
+    Statistics getStatistics() const;
+
+    /// @return The scan used, never automatic
+    Scan getScan() const;
+
+private:
+    static constexpr uint8_t kSeen = 0x10;     // mContinuity: the PID was seen, the low nibble is its last counter
+    static constexpr uint8_t kRepeated = 0x20; // mContinuity: the last packet of the PID was a repeat
+
+    void checkPacket(const uint8_t* packet, uint32_t header, int64_t time, uint64_t& continuityErrors,
+                     uint64_t& pcrs);
+
+    void addPcr(int64_t pcr, int64_t time, bool discontinuity);
+
+    Scan mScan = Scan::scalar;
+    std::array<uint8_t, 0x2000> mContinuity = {};
+    int mPcrPid = -1;
+    bool mHavePcr = false;
+    int64_t mLastPcr = 0;
+    int64_t mLastPcrTime = 0;
+    double mJitter = 0.0;
+
+    std::atomic<uint64_t> mMessages = {0};
+    std::atomic<uint64_t> mPackets = {0};
+    std::atomic<uint64_t> mNotTransportStream = {0};
+    std::atomic<uint64_t> mSyncErrors = {0};
+    std::atomic<uint64_t> mTransportErrors = {0};
+    std::atomic<uint64_t> mContinuityErrors = {0};
+    std::atomic<uint64_t> mPcrs = {0};
+    std::atomic<int> mPublishedPcrPid = {-1};
+    std::atomic<int64_t> mPcrJitter = {0};
+    std::atomic<int64_t> mMaxPcrJitter = {0};
+};
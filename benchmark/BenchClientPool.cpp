@@ -0,0 +1,187 @@
+//
+// Threads and CPU per connection of many outgoing connections: one SRTNet client (and its receive thread) per
+// connection against all connections in one SRTNetClientPool.
+// A local server sends packetsPerSecond packets of 1316 bytes to every connection. The CPU time is that of the whole
+// process over the measurement window, so it includes the server and the threads libsrt starts for every socket, the
+// difference between the two runs is the receive side.
+//
+// Usage: runBenchmarks clientpool [clients] [seconds] [packetsPerSecond] [poolThreads]
+//
+
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+#include "Benchmark.h"
+#include "SRTNet.h"
+#include "SRTNetClientPool.h"
+
+namespace {
+
+constexpr uint16_t kPort = 8009;
+constexpr size_t kPayloadSize = 1316;
+
+/// @return The threads of the process, -1 where /proc is not available
+int threadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 8, "Threads:") == 0) {
+            return std::stoi(line.substr(8));
+        }
+    }
+    return -1;
+}
+
+size_t serverClients(SRTNet& server) {
+    size_t clients = 0;
+    server.getActiveClients([&](std::map<SRTSOCKET, std::shared_ptr<SRTNet::NetworkConnection>>& clientList) {
+        clients = clientList.size();
+    });
+    return clients;
+}
+
+/// Sends to every client of the server at a fixed packet rate while it lives
+class Feeder {
+public:
+    Feeder(SRTNet& server, double packetsPerSecond) : mServer(server) {
+        mThread = std::thread([this, packetsPerSecond]() {
+            uint8_t payload[kPayloadSize] = {1};
+            auto interval = std::chrono::duration<double>(1.0 / packetsPerSecond);
+            auto next = std::chrono::steady_clock::now();
+            std::vector<SRTSOCKET> sockets;
+            while (mActive) {
+                sockets.clear();
+                mServer.getActiveClients(
+                    [&](std::map<SRTSOCKET, std::shared_ptr<SRTNet::NetworkConnection>>& clientList) {
+                        for (auto& client : clientList) {
+                            sockets.push_back(client.first);
+                        }
+                    });
+                for (SRTSOCKET socket : sockets) {
+                    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+                    mServer.sendData(payload, sizeof(payload), &msgCtrl, socket);
+                }
+                next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+                std::this_thread::sleep_until(next);
+            }
+        });
+    }
+
+    ~Feeder() {
+        mActive = false;
+        mThread.join();
+    }
+
+private:
+    SRTNet& mServer;
+    std::atomic<bool> mActive = {true};
+    std::thread mThread;
+};
+
+struct Measurement {
+    int mThreads = 0;
+    double mCpuSeconds = 0.0;
+    uint64_t mMessages = 0;
+};
+
+/// Measure the process for a window while counter counts the received messages
+Measurement measure(double seconds, const std::atomic<uint64_t>& counter) {
+    Measurement measurement;
+    uint64_t messages = counter.load();
+    std::clock_t cpuStart = std::clock();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    measurement.mCpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    measurement.mMessages = counter.load() - messages;
+    measurement.mThreads = threadCount();
+    return measurement;
+}
+
+void printMeasurement(const char* name, const Measurement& measurement, size_t clients, double seconds) {
+    std::printf("%-22s %8d threads %8.3f %% CPU/connection %10.0f msg/s\n", name, measurement.mThreads,
+                measurement.mCpuSeconds / seconds / static_cast<double>(clients) * 100.0,
+                static_cast<double>(measurement.mMessages) / seconds);
+}
+
+int runClientPoolBenchmark(const std::vector<std::string>& arguments) {
+    auto clients = static_cast<size_t>(getArgument(arguments, 0, 200));
+    double seconds = getArgument(arguments, 1, 5);
+    double packetsPerSecond = getArgument(arguments, 2, 100);
+    SRTNetClientPool::Config poolConfig;
+    poolConfig.mThreads = static_cast<size_t>(getArgument(arguments, 3, 2));
+
+    SRTNet server;
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    server.clientConnected = [](struct sockaddr& sin, SRTSOCKET newSocket,
+                                std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    if (!server.startServer("127.0.0.1", kPort, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx)) {
+        std::printf("Failed starting the server on port %u\n", kPort);
+        return EXIT_FAILURE;
+    }
+    int baseThreads = threadCount();
+    Feeder feeder(server, packetsPerSecond);
+
+    std::atomic<uint64_t> clientMessages = {0};
+    Measurement clientMeasurement;
+    {
+        std::vector<std::unique_ptr<SRTNet>> netClients;
+        for (size_t i = 0; i < clients; ++i) {
+            auto client = std::make_unique<SRTNet>();
+            client->receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                             std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+                clientMessages.fetch_add(1, std::memory_order_relaxed);
+            };
+            if (!client->startClient("127.0.0.1", kPort, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE)) {
+                std::printf("Failed connecting client %zu\n", i);
+                return EXIT_FAILURE;
+            }
+            netClients.push_back(std::move(client));
+        }
+        clientMeasurement = measure(seconds, clientMessages);
+        for (auto& client : netClients) {
+            client->stop();
+        }
+    }
+    // Let the server notice the disconnects before the pool connects
+    for (int i = 0; i < 500 && serverClients(server) > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::atomic<uint64_t> poolMessages = {0};
+    Measurement poolMeasurement;
+    {
+        SRTNetClientPool pool(poolConfig);
+        pool.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                      std::shared_ptr<SRTNetCore::NetworkConnection>& ctx, SRTSOCKET socket) {
+            poolMessages.fetch_add(1, std::memory_order_relaxed);
+        };
+        for (size_t i = 0; i < clients; ++i) {
+            if (pool.addClient("127.0.0.1", kPort, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE) == SRT_INVALID_SOCK) {
+                std::printf("Failed connecting pool client %zu\n", i);
+                return EXIT_FAILURE;
+            }
+        }
+        poolMeasurement = measure(seconds, poolMessages);
+    }
+
+    std::printf("%zu connections, %.0f packets/s each, %d threads before the clients (server and benchmark)\n",
+                clients, packetsPerSecond, baseThreads);
+    printMeasurement("SRTNet per client", clientMeasurement, clients, seconds);
+    printMeasurement("SRTNetClientPool", poolMeasurement, clients, seconds);
+    if (clientMeasurement.mThreads < 0) {
+        std::printf("Thread counts are not available on this platform\n");
+    }
+    server.stop();
+    return EXIT_SUCCESS;
+}
+
+BenchmarkRegistration gClientPoolBenchmark("clientpool",
+                                           {"Threads and CPU per connection, one SRTNet client per connection vs "
+                                            "SRTNetClientPool",
+                                            runClientPoolBenchmark});
+
+} // namespace
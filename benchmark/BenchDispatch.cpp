@@ -0,0 +1,136 @@
+//
+// Per packet cost of handing received data to the application: the std::function callbacks of SRTNet (with and
+// without the std::any_cast of the connection context main.cpp does) against a compile time SRTNetT handler, with
+// and without a typed connection context.
+// The handlers are called the way the receive loops call them, so only the dispatch is measured and not the network.
+//
+// Usage: runBenchmarks dispatch [packets]
+//
+
+#include <cstdio>
+
+#include "Benchmark.h"
+#include "SRTNet.h"
+
+namespace {
+
+struct ConnectionState {
+    uint64_t mBytes = 0;
+};
+
+struct StaticHandler {
+    static std::shared_ptr<SRTNetCore::NetworkConnection>
+    clientConnected(SRTNetT<StaticHandler>& net,
+                    struct sockaddr& sin,
+                    SRTSOCKET newSocket,
+                    std::shared_ptr<SRTNetCore::NetworkConnection>& ctx) {
+        return nullptr;
+    }
+
+    static void receivedData(SRTNetT<StaticHandler>& net,
+                             const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                             SRTSOCKET socket) {
+        mState.mBytes += size + data[0];
+    }
+
+    static void clientDisconnected(SRTNetT<StaticHandler>& net,
+                                   std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                                   SRTSOCKET socket) {
+    }
+
+    static inline ConnectionState mState;
+};
+
+struct TypedContextHandler {
+    struct Context : public SRTNetCore::NetworkConnection {
+        ConnectionState mState;
+    };
+
+    static std::shared_ptr<Context> clientConnected(SRTNetT<TypedContextHandler>& net,
+                                                    struct sockaddr& sin,
+                                                    SRTSOCKET newSocket,
+                                                    std::shared_ptr<SRTNetCore::NetworkConnection>& ctx) {
+        return nullptr;
+    }
+
+    static void receivedData(SRTNetT<TypedContextHandler>& net,
+                             const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             Context& ctx,
+                             SRTSOCKET socket) {
+        ctx.mState.mBytes += size + data[0];
+    }
+
+    static void clientDisconnected(SRTNetT<TypedContextHandler>& net, Context& ctx, SRTSOCKET socket) {
+    }
+};
+
+int runDispatchBenchmark(const std::vector<std::string>& arguments) {
+    auto packets = static_cast<size_t>(getArgument(arguments, 0, 50000000));
+    uint8_t payload[1316] = {1};
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+
+    auto state = std::make_shared<ConnectionState>();
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ctx->mObject = state;
+
+    SRTNet anyCastNet;
+    anyCastNet.receivedDataNoCopy = [](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                       std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        auto& connectionState = std::any_cast<std::shared_ptr<ConnectionState>&>(ctx->mObject);
+        connectionState->mBytes += size + data[0];
+    };
+    double anyCastTime = nanosecondsPerCall(packets, [&]() {
+        doNotOptimize(payload);
+        SRTNetCallbackHandler::receivedData(anyCastNet, payload, sizeof(payload), msgCtrl, ctx, 1);
+    });
+
+    SRTNet functionNet;
+    ConnectionState functionState;
+    functionNet.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                         std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        functionState.mBytes += size + data[0];
+    };
+    double functionTime = nanosecondsPerCall(packets, [&]() {
+        doNotOptimize(payload);
+        SRTNetCallbackHandler::receivedData(functionNet, payload, sizeof(payload), msgCtrl, ctx, 1);
+    });
+
+    SRTNetT<StaticHandler> staticNet;
+    double staticTime = nanosecondsPerCall(packets, [&]() {
+        doNotOptimize(payload);
+        StaticHandler::receivedData(staticNet, payload, sizeof(payload), msgCtrl, ctx, 1);
+    });
+
+    SRTNetT<TypedContextHandler> typedNet;
+    auto typedCtx = std::make_shared<TypedContextHandler::Context>();
+    std::shared_ptr<SRTNetCore::NetworkConnection> tableEntry = typedCtx;
+    double typedTime = nanosecondsPerCall(packets, [&]() {
+        doNotOptimize(payload);
+        // What the receive loop does with the connection table entry
+        TypedContextHandler::receivedData(typedNet, payload, sizeof(payload), msgCtrl,
+                                          static_cast<TypedContextHandler::Context&>(*tableEntry), 1);
+    });
+
+    std::printf("%-36s %8.2f ns/packet\n", "SRTNet std::function + any_cast", anyCastTime);
+    std::printf("%-36s %8.2f ns/packet\n", "SRTNet std::function", functionTime);
+    std::printf("%-36s %8.2f ns/packet\n", "SRTNetT static handler", staticTime);
+    std::printf("%-36s %8.2f ns/packet\n", "SRTNetT typed context", typedTime);
+    if (state->mBytes != functionState.mBytes || state->mBytes != StaticHandler::mState.mBytes ||
+        state->mBytes != typedCtx->mState.mBytes) {
+        std::printf("Byte count mismatch\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+BenchmarkRegistration gDispatchBenchmark("dispatch",
+                                         {"Per packet dispatch cost, SRTNet std::function callbacks and any_cast vs "
+                                          "SRTNetT static handler and typed context",
+                                          runDispatchBenchmark});
+
+} // namespace
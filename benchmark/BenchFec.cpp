@@ -0,0 +1,150 @@
+//
+// Compares SRT retransmission (ARQ) only against the built-in FEC packet filter at fixed loss rates.
+//
+// Usage: runBenchmarks fec [seconds per run] [bitrate Mbit/s]
+//
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <thread>
+
+#include "Benchmark.h"
+#include "ImpairmentRelay.h"
+#include "SRTNet.h"
+
+namespace {
+
+const uint16_t kServerPort = 9000;
+const uint16_t kRelayPort = 9001;
+const int32_t kLatency = 120;
+const size_t kPayloadSize = 1316;
+
+struct FecRunResult {
+    uint64_t mSent = 0;
+    uint64_t mDelivered = 0;
+    int64_t mUniquePackets = 0;
+    int64_t mRetransmitted = 0;
+    int64_t mFecPackets = 0;
+    int64_t mRecovered = 0;
+    int64_t mDropped = 0;
+};
+
+FecRunResult runFecScenario(const std::optional<SRTNet::FecConfig>& fec, double lossRate, int seconds,
+                            double bitrateMbps) {
+    FecRunResult runResult;
+    SRTNet server;
+    SRTNet client;
+    std::atomic<SRTSOCKET> connectedSocket = {0};
+    std::atomic<uint64_t> delivered = {0};
+
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        connectedSocket = newSocket;
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        delivered++;
+    };
+
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    if (!server.setForwardErrorCorrection(fec) || !client.setForwardErrorCorrection(fec)) {
+        std::cerr << "Failed to configure FEC" << std::endl;
+        return runResult;
+    }
+    if (!server.startServer("127.0.0.1", kServerPort, 16, kLatency, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", true, ctx)) {
+        std::cerr << "Failed to start server" << std::endl;
+        return runResult;
+    }
+    ImpairmentRelay relay;
+    if (!relay.start(kRelayPort, kServerPort)) {
+        std::cerr << "Failed to start relay" << std::endl;
+        return runResult;
+    }
+    if (!client.startClient("127.0.0.1", kRelayPort, 16, kLatency, 100, ctx, SRT_LIVE_MAX_PLSIZE)) {
+        std::cerr << "Failed to connect client" << std::endl;
+        return runResult;
+    }
+
+    // Impair the link once connected, the handshake is not part of the measurement
+    relay.setLossRate(lossRate);
+
+    std::vector<uint8_t> payload(kPayloadSize);
+    auto interval = std::chrono::nanoseconds(static_cast<int64_t>(kPayloadSize * 8 * 1000.0 / bitrateMbps));
+    auto start = std::chrono::steady_clock::now();
+    auto nextSend = start;
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        if (client.sendData(payload.data(), payload.size(), &msgCtrl)) {
+            runResult.mSent++;
+        }
+        nextSend += interval;
+        std::this_thread::sleep_until(nextSend);
+    }
+    // Let the last packets pass the latency window
+    std::this_thread::sleep_for(std::chrono::milliseconds(kLatency * 4));
+
+    SRT_TRACEBSTATS senderStats = {};
+    client.getStatistics(&senderStats, SRTNetClearStats::no, SRTNetInstant::no);
+    SRT_TRACEBSTATS receiverStats = {};
+    server.getStatistics(&receiverStats, SRTNetClearStats::no, SRTNetInstant::no, connectedSocket);
+
+    runResult.mDelivered = delivered;
+    runResult.mUniquePackets = senderStats.pktSentUniqueTotal;
+    runResult.mRetransmitted = senderStats.pktRetransTotal;
+    runResult.mFecPackets = senderStats.pktSndFilterExtraTotal;
+    runResult.mRecovered = receiverStats.pktRcvFilterSupplyTotal;
+    runResult.mDropped = receiverStats.pktRcvDropTotal;
+
+    client.stop();
+    server.stop();
+    relay.stop();
+    return runResult;
+}
+
+int runFecBenchmark(const std::vector<std::string>& arguments) {
+    int seconds = static_cast<int>(getArgument(arguments, 0, 10));
+    double bitrateMbps = getArgument(arguments, 1, 5.0);
+
+    SRTNet::FecConfig fecWithArq;
+    fecWithArq.mArq = SRTNet::FecConfig::Arq::onreq;
+    SRTNet::FecConfig fecOnly;
+    fecOnly.mArq = SRTNet::FecConfig::Arq::never;
+    const std::vector<std::pair<std::string, std::optional<SRTNet::FecConfig>>> modes = {
+        {"ARQ only", std::nullopt},
+        {"FEC 10x5 + ARQ", fecWithArq},
+        {"FEC 10x5 no ARQ", fecOnly},
+    };
+    const double lossRates[] = {0.005, 0.01, 0.02, 0.05};
+
+    std::cout << "FEC benchmark, " << seconds << " s per run at " << bitrateMbps << " Mbit/s, latency " << kLatency
+              << " ms" << std::endl;
+    std::printf("%-6s %-16s %10s %10s %10s %10s %10s %10s\n", "loss", "mode", "overhead", "retrans", "fec pkts",
+                "recovered", "dropped", "delivered");
+    for (double lossRate : lossRates) {
+        for (const auto& [name, fec] : modes) {
+            FecRunResult runResult = runFecScenario(fec, lossRate, seconds, bitrateMbps);
+            double overhead = 0.0;
+            if (runResult.mUniquePackets > 0) {
+                overhead = 100.0 * static_cast<double>(runResult.mRetransmitted + runResult.mFecPackets) /
+                           static_cast<double>(runResult.mUniquePackets);
+            }
+            double deliveredPercent =
+                runResult.mSent ? 100.0 * static_cast<double>(runResult.mDelivered) / runResult.mSent : 0.0;
+            std::printf("%5.1f%% %-16s %9.1f%% %10lld %10lld %10lld %10lld %9.2f%%\n", lossRate * 100.0, name.c_str(),
+                        overhead, static_cast<long long>(runResult.mRetransmitted),
+                        static_cast<long long>(runResult.mFecPackets), static_cast<long long>(runResult.mRecovered),
+                        static_cast<long long>(runResult.mDropped), deliveredPercent);
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+BenchmarkRegistration gFecBenchmark("fec",
+                                    {"FEC packet filter vs ARQ only: bandwidth overhead and recovered packets at "
+                                     "0.5-5% loss",
+                                     runFecBenchmark});
+
+} // namespace
@@ -0,0 +1,154 @@
+//
+// sendData from many threads at once. Every thread sends on a connection of its own, first through the lock free
+// sendData and then with every call behind one shared mutex, the way a sendData locking mNetMtx would behave.
+// The enter and leave of the SRTNetEpoch guard sendData uses is also timed alone against a mutex lock and unlock, with
+// the same number of threads, so the cost of the gate is seen without the SRT send path.
+//
+// Usage: runBenchmarks sendcontention [threads] [messagesPerThread]
+//
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "Benchmark.h"
+#include "SRTNet.h"
+#include "SRTNetEpoch.h"
+
+namespace {
+
+constexpr uint16_t kPort = 8009;
+constexpr size_t kPayloadSize = 188;
+
+/// Run function(thread index) on threads threads at the same time
+/// @return The wall time of the slowest thread in nanoseconds
+template <typename Function>
+double runThreads(size_t threads, Function&& function) {
+    std::atomic<size_t> ready = {0};
+    std::atomic<bool> go = {false};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i]() {
+            ready++;
+            while (!go) {
+                std::this_thread::yield();
+            }
+            function(i);
+        });
+    }
+    while (ready != threads) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+int runSendContentionBenchmark(const std::vector<std::string>& arguments) {
+    auto threads = static_cast<size_t>(getArgument(arguments, 0, 4));
+    auto messages = static_cast<size_t>(getArgument(arguments, 1, 20000));
+    const double calls = static_cast<double>(threads * messages);
+
+    // The gate alone
+    SRTNetEpoch epoch;
+    std::mutex gateMutex;
+    uint64_t guarded = 0;
+    double epochTime = runThreads(threads, [&](size_t) {
+        for (size_t i = 0; i < messages * 50; ++i) {
+            SRTNetEpoch::Guard guard(epoch);
+            doNotOptimize(i);
+        }
+    });
+    double mutexTime = runThreads(threads, [&](size_t) {
+        for (size_t i = 0; i < messages * 50; ++i) {
+            std::lock_guard<std::mutex> lock(gateMutex);
+            guarded++;
+        }
+    });
+
+    // sendData, one connection per thread
+    SRTNet server;
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    server.clientConnected = [](struct sockaddr& sin, SRTSOCKET newSocket,
+                                std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    if (!server.startServer("127.0.0.1", kPort, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx)) {
+        std::printf("Failed starting the server on port %u\n", kPort);
+        return EXIT_FAILURE;
+    }
+    std::vector<std::unique_ptr<SRTNet>> clients;
+    for (size_t i = 0; i < threads; ++i) {
+        clients.push_back(std::make_unique<SRTNet>());
+        if (!clients.back()->startClient("127.0.0.1", kPort, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE)) {
+            std::printf("Failed connecting client %zu\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+    std::vector<SRTSOCKET> sockets;
+    for (int i = 0; i < 500 && sockets.size() < threads; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        sockets.clear();
+        server.getActiveClients([&](std::map<SRTSOCKET, std::shared_ptr<SRTNet::NetworkConnection>>& clientList) {
+            for (auto& client : clientList) {
+                sockets.push_back(client.first);
+            }
+        });
+    }
+    if (sockets.size() < threads) {
+        std::printf("Only %zu of %zu clients connected\n", sockets.size(), threads);
+        return EXIT_FAILURE;
+    }
+
+    std::atomic<size_t> failures = {0};
+    uint8_t payload[kPayloadSize] = {0x47};
+    double lockFreeTime = runThreads(threads, [&](size_t index) {
+        for (size_t i = 0; i < messages; ++i) {
+            SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+            if (!server.sendData(payload, sizeof(payload), &msgCtrl, sockets[index])) {
+                failures++;
+            }
+        }
+    });
+    std::mutex sendMutex;
+    double lockedTime = runThreads(threads, [&](size_t index) {
+        for (size_t i = 0; i < messages; ++i) {
+            SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+            std::lock_guard<std::mutex> lock(sendMutex);
+            if (!server.sendData(payload, sizeof(payload), &msgCtrl, sockets[index])) {
+                failures++;
+            }
+        }
+    });
+    for (auto& client : clients) {
+        client->stop();
+    }
+    server.stop();
+
+    std::printf("%zu threads\n", threads);
+    std::printf("%-28s %10.2f ns/call %12.0f calls/s\n", "SRTNetEpoch guard", epochTime / (calls * 50),
+                calls * 50 * 1e9 / epochTime);
+    std::printf("%-28s %10.2f ns/call %12.0f calls/s\n", "std::mutex", mutexTime / (calls * 50),
+                calls * 50 * 1e9 / mutexTime);
+    std::printf("%-28s %10.2f ns/message %9.0f messages/s\n", "sendData lock free", lockFreeTime / calls,
+                calls * 1e9 / lockFreeTime);
+    std::printf("%-28s %10.2f ns/message %9.0f messages/s\n", "sendData behind one mutex", lockedTime / calls,
+                calls * 1e9 / lockedTime);
+    if (failures) {
+        std::printf("%zu sends failed\n", failures.load());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+BenchmarkRegistration gSendContentionBenchmark("sendcontention",
+                                               {"sendData from many threads on their own connections, lock free vs "
+                                                "behind one mutex",
+                                                runSendContentionBenchmark});
+
+} // namespace
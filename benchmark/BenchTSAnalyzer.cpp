@@ -0,0 +1,106 @@
+//
+// Throughput of the MPEG-TS analyzer SRTNet runs on the receive path with setTSAnalysis, on one core. A clean
+// transport stream of four PIDs in messages of seven packets, one PID carrying a PCR every 40 packets, is checked with
+// every header scan the CPU supports.
+//
+// Usage: runBenchmarks tsanalyzer [messages]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Benchmark.h"
+#include "SRTNetTS.h"
+#include "SRTNetTSAnalyzer.h"
+
+namespace {
+
+constexpr size_t kPacketsPerMessage = 7;
+constexpr size_t kMessageSize = kPacketsPerMessage * SRTNetTS::kPacketSize;
+// The continuity counters of all four PIDs are where they started when the buffer wraps
+constexpr size_t kBufferMessages = 1024;
+constexpr uint16_t kFirstPid = 0x100;
+constexpr size_t kPids = 4;
+
+std::vector<uint8_t> makeTransportStream() {
+    std::vector<uint8_t> buffer(kBufferMessages * kMessageSize, 0xff);
+    int64_t pcr = 0;
+    for (size_t i = 0; i < kBufferMessages * kPacketsPerMessage; ++i) {
+        uint8_t* packet = buffer.data() + i * SRTNetTS::kPacketSize;
+        auto pid = static_cast<uint16_t>(kFirstPid + i % kPids);
+        packet[0] = SRTNetTS::kSyncByte;
+        packet[1] = static_cast<uint8_t>(pid >> 8);
+        packet[2] = static_cast<uint8_t>(pid);
+        packet[3] = static_cast<uint8_t>(0x10 | ((i / kPids) & 0x0f));
+        if (pid == kFirstPid && (i / kPids) % 40 == 0) {
+            int64_t base = pcr / 300;
+            packet[3] |= 0x20;
+            packet[4] = 7;
+            packet[5] = 0x10;
+            packet[6] = static_cast<uint8_t>(base >> 25);
+            packet[7] = static_cast<uint8_t>(base >> 17);
+            packet[8] = static_cast<uint8_t>(base >> 9);
+            packet[9] = static_cast<uint8_t>(base >> 1);
+            packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7e);
+            packet[11] = 0;
+            pcr += SRTNetTS::kPcrClock / 100;
+        }
+    }
+    return buffer;
+}
+
+const char* scanName(SRTNetTSAnalyzer::Scan scan) {
+    switch (scan) {
+        case SRTNetTSAnalyzer::Scan::sse2:
+            return "SSE2";
+        case SRTNetTSAnalyzer::Scan::avx2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+int runTSAnalyzerBenchmark(const std::vector<std::string>& arguments) {
+    auto messages = static_cast<size_t>(getArgument(arguments, 0, 2000000));
+    std::vector<uint8_t> buffer = makeTransportStream();
+
+    std::printf("%zu messages of %zu bytes\n", messages, kMessageSize);
+    bool clean = true;
+    for (auto requested : {SRTNetTSAnalyzer::Scan::scalar, SRTNetTSAnalyzer::Scan::sse2,
+                           SRTNetTSAnalyzer::Scan::avx2}) {
+        SRTNetTSAnalyzer::Config config;
+        config.mScan = requested;
+        SRTNetTSAnalyzer analyzer(config);
+        if (analyzer.getScan() != requested) {
+            std::printf("%-8s not supported\n", scanName(requested));
+            continue;
+        }
+        size_t message = 0;
+        int64_t sendTime = 0;
+        double nanoseconds = nanosecondsPerCall(messages, [&]() {
+            analyzer.analyze(buffer.data() + message * kMessageSize, kMessageSize, sendTime);
+            message = (message + 1) % kBufferMessages;
+            sendTime += 1000;
+        });
+        SRTNetTSAnalyzer::Statistics stats = analyzer.getStatistics();
+        double perPacket = nanoseconds / kPacketsPerMessage;
+        std::printf("%-8s %8.2f ns/packet %8.2f Gbit/s\n", scanName(requested), perPacket,
+                    SRTNetTS::kPacketSize * 8.0 / perPacket);
+        if (stats.mSyncErrors || stats.mTransportErrors || stats.mContinuityErrors || stats.mPcrs == 0) {
+            clean = false;
+        }
+    }
+    if (!clean) {
+        std::printf("The analyzer found errors in a clean stream\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+BenchmarkRegistration gTSAnalyzerBenchmark("tsanalyzer",
+                                           {"MPEG-TS analyzer throughput on one core, scalar vs SSE2 vs AVX2 header "
+                                            "scan",
+                                            runTSAnalyzerBenchmark});
+
+} // namespace
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+///
+/// @brief A benchmark scenario run by the runBenchmarks executable. Scenarios register themselves with a
+/// BenchmarkRegistration object at namespace scope in their own source file.
+struct Benchmark {
+    std::string mDescription;
+    // Runs the scenario with the command line arguments following the scenario name, returns the exit code
+    std::function<int(const std::vector<std::string>& arguments)> mRun;
+};
+
+///
+/// @return All registered scenarios by name
+inline std::map<std::string, Benchmark>& getBenchmarks() {
+    static std::map<std::string, Benchmark> benchmarks;
+    return benchmarks;
+}
+
+struct BenchmarkRegistration {
+    BenchmarkRegistration(const std::string& name, const Benchmark& benchmark) {
+        getBenchmarks()[name] = benchmark;
+    }
+};
+
+///
+/// @brief Get a numeric command line argument
+/// @param arguments The scenario arguments
+/// @param index The argument index
+/// @param defaultValue Value used when the argument is not given
+inline double getArgument(const std::vector<std::string>& arguments, size_t index, double defaultValue) {
+    if (index < arguments.size()) {
+        return std::stod(arguments[index]);
+    }
+    return defaultValue;
+}
+
+///
+/// @brief Keep the compiler from optimizing away or hoisting computations on value in a timed loop
+template <typename T>
+inline void doNotOptimize(T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : "+m"(value) : : "memory");
+#else
+    volatile auto* escaped = &value;
+    (void)escaped;
+#endif
+}
+
+///
+/// @brief Time a function called in a tight loop
+/// @param calls Number of calls
+/// @param function The function to time
+/// @return The average time per call in nanoseconds
+template <typename Function>
+double nanosecondsPerCall(size_t calls, Function&& function) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        function();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / calls;
+}
@@ -0,0 +1,27 @@
+//
+// Runs the benchmark scenarios registered in the benchmark directory.
+//
+// Usage: runBenchmarks                        lists the scenarios
+//        runBenchmarks <scenario> [arguments] runs one scenario
+//
+
+#include <iostream>
+
+#include "Benchmark.h"
+#include "SRTNet.h"
+
+int main(int argc, const char* argv[]) {
+    if (argc < 2 || getBenchmarks().find(argv[1]) == getBenchmarks().end()) {
+        std::cout << "Usage: " << argv[0] << " <scenario> [arguments]" << std::endl << std::endl;
+        for (const auto& [name, benchmark] : getBenchmarks()) {
+            std::cout << "  " << name << " - " << benchmark.mDescription << std::endl;
+        }
+        return argc < 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::vector<std::string> arguments(argv + 2, argv + argc);
+    srt_startup();
+    int result = getBenchmarks()[argv[1]].mRun(arguments);
+    srt_cleanup();
+    return result;
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+#ifdef WIN32
+#include <Winsock2.h>
+#include <ws2tcpip.h>
+using RelaySocket = SOCKET;
+constexpr RelaySocket kInvalidRelaySocket = INVALID_SOCKET;
+#define RELAY_CLOSE_SOCKET closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using RelaySocket = int;
+constexpr RelaySocket kInvalidRelaySocket = -1;
+#define RELAY_CLOSE_SOCKET close
+#endif
+
+///
+/// @brief A UDP relay sitting between an SRT caller and an SRT listener on the loopback interface. The relay can drop
+/// a share of the packets or all of them (blackhole) to emulate impaired or broken network links.
+/// The caller connects to the listen port, the first sender seen on the listen port is considered the caller and all
+/// answers from the target are sent back to it.
+class ImpairmentRelay {
+public:
+    ImpairmentRelay() = default;
+
+    ~ImpairmentRelay() {
+        stop();
+    }
+
+    ///
+    /// @brief Start relaying packets
+    /// @param listenPort The loopback port the caller should connect to
+    /// @param targetPort The loopback port of the listener to relay to
+    /// @return true if the relay was started
+    bool start(uint16_t listenPort, uint16_t targetPort) {
+        mCallerFacing = openSocket(listenPort);
+        mTargetFacing = openSocket(0);
+        if (mCallerFacing == kInvalidRelaySocket || mTargetFacing == kInvalidRelaySocket) {
+            stop();
+            return false;
+        }
+        mTarget = {};
+        mTarget.sin_family = AF_INET;
+        mTarget.sin_port = htons(targetPort);
+        inet_pton(AF_INET, "127.0.0.1", &mTarget.sin_addr);
+        mActive = true;
+        mThread = std::thread(&ImpairmentRelay::relayWorker, this);
+        return true;
+    }
+
+    void stop() {
+        mActive = false;
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+        if (mCallerFacing != kInvalidRelaySocket) {
+            RELAY_CLOSE_SOCKET(mCallerFacing);
+            mCallerFacing = kInvalidRelaySocket;
+        }
+        if (mTargetFacing != kInvalidRelaySocket) {
+            RELAY_CLOSE_SOCKET(mTargetFacing);
+            mTargetFacing = kInvalidRelaySocket;
+        }
+    }
+
+    ///
+    /// @brief Drop packets at random in both directions
+    /// @param lossRate The share of packets to drop, 0.0 - 1.0
+    void setLossRate(double lossRate) {
+        mLossRate = lossRate;
+    }
+
+    ///
+    /// @brief Drop every packet in both directions, emulating a broken link
+    void setBlackhole(bool blackhole) {
+        mBlackhole = blackhole;
+    }
+
+    uint64_t getForwardedPackets() const {
+        return mForwarded;
+    }
+
+    uint64_t getDroppedPackets() const {
+        return mDropped;
+    }
+
+private:
+    static RelaySocket openSocket(uint16_t port) {
+        RelaySocket relaySocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (relaySocket == kInvalidRelaySocket) {
+            return kInvalidRelaySocket;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        if (bind(relaySocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            RELAY_CLOSE_SOCKET(relaySocket);
+            return kInvalidRelaySocket;
+        }
+        return relaySocket;
+    }
+
+    bool shouldDrop() {
+        if (mBlackhole) {
+            return true;
+        }
+        double lossRate = mLossRate;
+        return lossRate > 0.0 && mDistribution(mRandom) < lossRate;
+    }
+
+    void relayWorker() {
+        char buffer[2048];
+        bool haveCaller = false;
+        sockaddr_in caller{};
+        while (mActive) {
+            fd_set readSet;
+            FD_ZERO(&readSet);
+            FD_SET(mCallerFacing, &readSet);
+            FD_SET(mTargetFacing, &readSet);
+            timeval timeout{0, 10000};
+            RelaySocket maxSocket = mCallerFacing > mTargetFacing ? mCallerFacing : mTargetFacing;
+            if (select(static_cast<int>(maxSocket) + 1, &readSet, nullptr, nullptr, &timeout) <= 0) {
+                continue;
+            }
+
+            if (FD_ISSET(mCallerFacing, &readSet)) {
+                sockaddr_in from{};
+                socklen_t fromLength = sizeof(from);
+                auto size = recvfrom(mCallerFacing, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from),
+                                     &fromLength);
+                if (size > 0) {
+                    caller = from;
+                    haveCaller = true;
+                    forward(mTargetFacing, buffer, size, mTarget);
+                }
+            }
+
+            if (FD_ISSET(mTargetFacing, &readSet)) {
+                auto size = recvfrom(mTargetFacing, buffer, sizeof(buffer), 0, nullptr, nullptr);
+                if (size > 0 && haveCaller) {
+                    forward(mCallerFacing, buffer, size, caller);
+                }
+            }
+        }
+    }
+
+    void forward(RelaySocket relaySocket, const char* buffer, size_t size, const sockaddr_in& destination) {
+        if (shouldDrop()) {
+            mDropped++;
+            return;
+        }
+        sendto(relaySocket, buffer, static_cast<int>(size), 0, reinterpret_cast<const sockaddr*>(&destination),
+               sizeof(destination));
+        mForwarded++;
+    }
+
+    RelaySocket mCallerFacing = kInvalidRelaySocket;
+    RelaySocket mTargetFacing = kInvalidRelaySocket;
+    sockaddr_in mTarget{};
+    std::thread mThread;
+    std::atomic<bool> mActive = {false};
+    std::atomic<bool> mBlackhole = {false};
+    std::atomic<double> mLossRate = {0.0};
+    std::atomic<uint64_t> mForwarded = {0};
+    std::atomic<uint64_t> mDropped = {0};
+    std::mt19937 mRandom{4711};
+    std::uniform_real_distribution<double> mDistribution{0.0, 1.0};
+};
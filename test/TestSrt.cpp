@@ -1,15 +1,124 @@
+#include <algorithm>
 #include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <new>
 #include <thread>
 
 #include <gtest/gtest.h>
 
+#ifdef WIN32
+#include <malloc.h>
+#endif
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "ImpairmentRelay.h"
 #include "SRTNet.h"
+#include "SRTNetClientPool.h"
+#include "SRTNetCongestionDrop.h"
+#include "SRTNetEpoch.h"
+#include "SRTNetFraming.h"
+#include "SRTNetGateway.h"
+#include "SRTNetMux.h"
+#include "SRTNetPlayout.h"
+#include "SRTNetRelay.h"
+#include "SRTNetSendPacer.h"
+#include "SRTNetTS.h"
+#include "SRTNetTSAnalyzer.h"
 
 std::string kValidPsk = "Th1$_is_4n_0pt10N4L_P$k";
 std::string kInvalidPsk = "Th1$_is_4_F4k3_P$k";
 
 size_t kMaxMessageSize = SRT_LIVE_MAX_PLSIZE;
 
+// Every heap allocation of the test binary is counted per thread, the SRT threads allocate on their own
+thread_local uint64_t tAllocations = 0;
+
+namespace {
+
+void* allocateAligned(size_t size, size_t align) {
+#ifdef WIN32
+    // The MSVC runtime has no aligned_alloc, its aligned blocks must be freed with _aligned_free
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc wants a size that is a multiple of the alignment
+    return std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align);
+#endif
+}
+
+void freeAligned(void* pointer) {
+#ifdef WIN32
+    _aligned_free(pointer);
+#else
+    std::free(pointer);
+#endif
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    tAllocations++;
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    tAllocations++;
+    if (void* pointer = allocateAligned(size, static_cast<size_t>(alignment))) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+    freeAligned(pointer);
+}
+
 namespace {
 ///
 /// @brief Get the bind IP address and port of an SRT socket
@@ -55,6 +164,246 @@ std::pair<std::string, uint16_t> getPeerIpAndPortFromSRTSocket(SRTSOCKET socket)
     return {"Unsupported", 0};
 }
 
+struct FailoverResult {
+    std::chrono::milliseconds mLongestGap{0};
+    uint32_t mSent = 0;
+    uint32_t mReceived = 0;
+    size_t mGroupMembers = 0;
+};
+
+///
+/// @brief Send a steady stream of numbered messages through a two link socket group where each link passes an
+/// ImpairmentRelay, break the link that carries the traffic and measure the longest gap in delivery at the receiver.
+/// @param groupType The group type to test
+/// @param serverPort The server port, the relays use the two following ports
+/// @return The measured failover
+FailoverResult measureGroupFailover(SRT_GROUP_TYPE groupType, uint16_t serverPort) {
+    FailoverResult failoverResult;
+    SRTNet server;
+    SRTNet client;
+
+    std::mutex receiveMutex;
+    uint32_t received = 0;
+    std::chrono::steady_clock::time_point lastArrival{};
+    std::chrono::steady_clock::duration longestGap{0};
+    bool measuring = false;
+
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        std::lock_guard<std::mutex> lock(receiveMutex);
+        auto now = std::chrono::steady_clock::now();
+        if (measuring && now - lastArrival > longestGap) {
+            longestGap = now - lastArrival;
+        }
+        lastArrival = now;
+        received++;
+    };
+
+    auto serverCtx = std::make_shared<SRTNet::NetworkConnection>();
+    EXPECT_TRUE(server.setAllowGroupConnections(true));
+    EXPECT_TRUE(server.startServer("127.0.0.1", serverPort, 16, 300, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false,
+                                   serverCtx));
+
+    const uint16_t kRelayPorts[] = {static_cast<uint16_t>(serverPort + 1), static_cast<uint16_t>(serverPort + 2)};
+    ImpairmentRelay relays[2];
+    EXPECT_TRUE(relays[0].start(kRelayPorts[0], serverPort));
+    EXPECT_TRUE(relays[1].start(kRelayPorts[1], serverPort));
+
+    std::vector<SRTNet::GroupMember> members(2);
+    for (size_t i = 0; i < members.size(); ++i) {
+        members[i].mHost = "127.0.0.1";
+        members[i].mPort = kRelayPorts[i];
+        members[i].mWeight = static_cast<uint16_t>(i);
+    }
+    auto clientCtx = std::make_shared<SRTNet::NetworkConnection>();
+    if (!client.startClientGroup(groupType, members, 16, 300, 100, clientCtx, SRT_LIVE_MAX_PLSIZE)) {
+        ADD_FAILURE() << "Failed to connect the socket group";
+        return failoverResult;
+    }
+
+    // Wait for the second link to connect in the background
+    std::vector<SRTNet::GroupMemberStatistics> memberStatistics;
+    for (int i = 0; i < 200; ++i) {
+        EXPECT_TRUE(client.getGroupStatistics(memberStatistics, SRTNetClearStats::no, SRTNetInstant::yes));
+        size_t connected = std::count_if(memberStatistics.begin(), memberStatistics.end(), [](const auto& member) {
+            return member.mSocketState == SRTS_CONNECTED;
+        });
+        if (connected == members.size()) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    failoverResult.mGroupMembers = memberStatistics.size();
+
+    std::atomic<bool> sending = {true};
+    std::atomic<uint32_t> sent = {0};
+    std::thread sender([&]() {
+        std::vector<uint8_t> payload(1316);
+        while (sending) {
+            uint32_t sequence = sent;
+            std::memcpy(payload.data(), &sequence, sizeof(sequence));
+            SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+            if (client.sendData(payload.data(), payload.size(), &msgCtrl)) {
+                sent++;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    {
+        std::lock_guard<std::mutex> lock(receiveMutex);
+        measuring = true;
+    }
+
+    // Break the link carrying the traffic, in broadcast mode all links do so break the first one
+    size_t brokenLink = 0;
+    EXPECT_TRUE(client.getGroupStatistics(memberStatistics, SRTNetClearStats::no, SRTNetInstant::yes));
+    for (const auto& member : memberStatistics) {
+        if (member.mMemberState == SRT_GST_RUNNING) {
+            const auto* peer = reinterpret_cast<const sockaddr_in*>(&member.mPeerAddress);
+            brokenLink = ntohs(peer->sin_port) == kRelayPorts[0] ? 0 : 1;
+            break;
+        }
+    }
+    relays[brokenLink].setBlackhole(true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    sending = false;
+    sender.join();
+    // Let the receiver drain the latency window
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    {
+        std::lock_guard<std::mutex> lock(receiveMutex);
+        failoverResult.mLongestGap = std::chrono::duration_cast<std::chrono::milliseconds>(longestGap);
+        failoverResult.mReceived = received;
+    }
+    failoverResult.mSent = sent;
+    client.stop();
+    server.stop();
+    return failoverResult;
+}
+
+///
+/// @brief SRTNetT handler counting what it sees, shared by the server and the client in the test
+struct CountingHandler {
+    static std::shared_ptr<SRTNetCore::NetworkConnection>
+    clientConnected(SRTNetT<CountingHandler>& net,
+                    struct sockaddr& sin,
+                    SRTSOCKET newSocket,
+                    std::shared_ptr<SRTNetCore::NetworkConnection>& ctx) {
+        mConnected++;
+        return std::make_shared<SRTNetCore::NetworkConnection>();
+    }
+
+    static void receivedData(SRTNetT<CountingHandler>& net,
+                             const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                             SRTSOCKET socket) {
+        mReceivedBytes += size;
+        // Echo from the server side
+        if (net.getCurrentMode() == SRTNetCore::Mode::server) {
+            SRT_MSGCTRL echoMsgCtrl = srt_msgctrl_default;
+            net.sendData(data, size, &echoMsgCtrl, socket);
+        } else {
+            mEchoedMessages++;
+        }
+    }
+
+    static void clientDisconnected(SRTNetT<CountingHandler>& net,
+                                   std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                                   SRTSOCKET socket) {
+        mDisconnected++;
+    }
+
+    static inline std::atomic<size_t> mConnected = {0};
+    static inline std::atomic<size_t> mDisconnected = {0};
+    static inline std::atomic<size_t> mReceivedBytes = {0};
+    static inline std::atomic<size_t> mEchoedMessages = {0};
+};
+
+///
+/// @brief SRTNetT echo handler for the dispatch workers, it calls a getter taking mNetMtx for every message
+struct DispatchEchoHandler {
+    static std::shared_ptr<SRTNetCore::NetworkConnection>
+    clientConnected(SRTNetT<DispatchEchoHandler>& net,
+                    struct sockaddr& sin,
+                    SRTSOCKET newSocket,
+                    std::shared_ptr<SRTNetCore::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNetCore::NetworkConnection>();
+    }
+
+    static void receivedData(SRTNetT<DispatchEchoHandler>& net,
+                             const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                             SRTSOCKET socket) {
+        // Echo from the server side
+        if (net.getCurrentMode() == SRTNetCore::Mode::server) {
+            SRT_MSGCTRL echoMsgCtrl = srt_msgctrl_default;
+            net.sendData(data, size, &echoMsgCtrl, socket);
+            if (mStopping) {
+                mReceivedInStop++;
+            }
+            if (mSlow) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        } else {
+            mEchoedMessages++;
+        }
+    }
+
+    static void clientDisconnected(SRTNetT<DispatchEchoHandler>& net,
+                                   std::shared_ptr<SRTNetCore::NetworkConnection>& ctx,
+                                   SRTSOCKET socket) {
+    }
+
+    static inline std::atomic<size_t> mEchoedMessages = {0};
+    static inline std::atomic<bool> mSlow = {false};
+    static inline std::atomic<bool> mStopping = {false};
+    static inline std::atomic<size_t> mReceivedInStop = {0};
+};
+
+///
+/// @brief SRTNetT handler with a typed connection context
+struct TypedContextHandler {
+    struct Context : public SRTNetCore::NetworkConnection {
+        SRTSOCKET mSocket = 0;
+        size_t mReceivedMessages = 0;
+    };
+
+    static std::shared_ptr<Context> clientConnected(SRTNetT<TypedContextHandler>& net,
+                                                    struct sockaddr& sin,
+                                                    SRTSOCKET newSocket,
+                                                    std::shared_ptr<SRTNetCore::NetworkConnection>& ctx) {
+        auto context = std::make_shared<Context>();
+        context->mSocket = newSocket;
+        return context;
+    }
+
+    static void receivedData(SRTNetT<TypedContextHandler>& net,
+                             const uint8_t* data,
+                             size_t size,
+                             SRT_MSGCTRL& msgCtrl,
+                             Context& ctx,
+                             SRTSOCKET socket) {
+        EXPECT_EQ(ctx.mSocket, socket);
+        ctx.mReceivedMessages++;
+    }
+
+    static void clientDisconnected(SRTNetT<TypedContextHandler>& net, Context& ctx, SRTSOCKET socket) {
+        EXPECT_EQ(ctx.mSocket, socket);
+    }
+};
+
 class TestSRTFixture : public ::testing::Test {
 public:
     void SetUp() override {
@@ -565,3 +914,1976 @@ TEST_F(TestSRTFixture, FailToConnectWhenRemoteHostnameIsCorrupt) {
     ASSERT_FALSE(mClient.startClient(kIllFormattedIP, kPort, 16, 1000, 100, mClientCtx,
                                      SRT_LIVE_MAX_PLSIZE, 5000, kValidPsk));
 }
+
+TEST(TestSrt, GroupBroadcastIsHitless) {
+    FailoverResult result = measureGroupFailover(SRT_GTYPE_BROADCAST, 8030);
+    EXPECT_EQ(result.mGroupMembers, 2);
+    std::cout << "Broadcast group failover, longest delivery gap: " << result.mLongestGap.count() << " ms, sent "
+              << result.mSent << " received " << result.mReceived << std::endl;
+    ::testing::Test::RecordProperty("FailoverMs", static_cast<int>(result.mLongestGap.count()));
+    EXPECT_GT(result.mSent, 0);
+    EXPECT_EQ(result.mReceived, result.mSent) << "Expected no loss when one of two broadcast links breaks";
+    EXPECT_LT(result.mLongestGap, std::chrono::milliseconds(100));
+}
+
+TEST(TestSrt, GroupBackupFailover) {
+    FailoverResult result = measureGroupFailover(SRT_GTYPE_BACKUP, 8035);
+    EXPECT_EQ(result.mGroupMembers, 2);
+    std::cout << "Backup group failover, longest delivery gap: " << result.mLongestGap.count() << " ms, sent "
+              << result.mSent << " received " << result.mReceived << std::endl;
+    ::testing::Test::RecordProperty("FailoverMs", static_cast<int>(result.mLongestGap.count()));
+    EXPECT_GT(result.mSent, 0);
+    EXPECT_GT(result.mReceived, result.mSent * 99 / 100);
+    EXPECT_LT(result.mLongestGap, std::chrono::milliseconds(1000));
+}
+
+TEST(TestSrt, GroupStatisticsOnSingleSocket) {
+    SRTNet server;
+    SRTNet client;
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) { return ctx; };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    EXPECT_FALSE(server.setAllowGroupConnections(true)) << "Expect to fail when the server is already started";
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    std::vector<SRTNet::GroupMemberStatistics> members;
+    EXPECT_FALSE(client.getGroupStatistics(members, SRTNetClearStats::no, SRTNetInstant::yes))
+        << "Expect to fail for a connection that is not a socket group";
+}
+
+TEST_F(TestSRTFixture, ForwardErrorCorrection) {
+    SRTNet::FecConfig invalidFec;
+    invalidFec.mColumns = 0;
+    EXPECT_FALSE(mServer.setForwardErrorCorrection(invalidFec));
+
+    SRTNet::FecConfig fec;
+    fec.mColumns = 4;
+    fec.mRows = 2;
+    ASSERT_TRUE(mServer.setForwardErrorCorrection(fec));
+    ASSERT_TRUE(mClient.setForwardErrorCorrection(fec));
+
+    std::atomic<size_t> receivedMessages = {0};
+    std::atomic<SRTSOCKET> clientSocket = {0};
+    mServer.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                     std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        clientSocket = socket;
+        receivedMessages++;
+    };
+
+    ASSERT_TRUE(
+        mServer.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, kValidPsk, false, mServerCtx));
+    EXPECT_FALSE(mServer.setForwardErrorCorrection(std::nullopt)) << "Expect to fail when the server is started";
+    ASSERT_TRUE(mClient.startClient("127.0.0.1", 8009, 16, 1000, 100, mClientCtx, SRT_LIVE_MAX_PLSIZE, 5000, kValidPsk));
+
+    const size_t kMessages = 64;
+    std::vector<uint8_t> sendBuffer(1316, 1);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(mClient.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+
+    for (int i = 0; i < 300 && receivedMessages < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(receivedMessages, kMessages);
+
+    SRTNet::FilterStatistics clientFilterStats;
+    ASSERT_TRUE(mClient.getFilterStatistics(clientFilterStats));
+    EXPECT_GT(clientFilterStats.mFecPacketsSent, 0);
+    SRTNet::FilterStatistics serverFilterStats;
+    ASSERT_TRUE(mServer.getFilterStatistics(serverFilterStats, clientSocket));
+    EXPECT_EQ(serverFilterStats.mFecPacketsReceived, clientFilterStats.mFecPacketsSent);
+    EXPECT_EQ(serverFilterStats.mPacketsUnrecovered, 0);
+}
+
+TEST(TestSrt, StaticHandler) {
+    SRTNetT<CountingHandler> server;
+    SRTNetT<CountingHandler> client;
+    auto ctx = std::make_shared<SRTNetCore::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    const size_t kMessages = 10;
+    std::vector<uint8_t> sendBuffer(1000, 7);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+    for (int i = 0; i < 300 && CountingHandler::mEchoedMessages < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(CountingHandler::mConnected, 1);
+    EXPECT_EQ(CountingHandler::mEchoedMessages, kMessages);
+    EXPECT_EQ(CountingHandler::mReceivedBytes, 2 * kMessages * sendBuffer.size());
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+    EXPECT_EQ(CountingHandler::mDisconnected, 2);
+}
+
+TEST(TestSrt, TypedContext) {
+    SRTNetT<TypedContextHandler> server;
+    SRTNetT<TypedContextHandler> client;
+    auto serverCtx = std::make_shared<SRTNetCore::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, serverCtx));
+
+    std::shared_ptr<SRTNetCore::NetworkConnection> untypedCtx = std::make_shared<SRTNetCore::NetworkConnection>();
+    EXPECT_FALSE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, untypedCtx, SRT_LIVE_MAX_PLSIZE))
+        << "Expect to fail when the client context is not the Handler's Context type";
+
+    auto typedCtx = std::make_shared<TypedContextHandler::Context>();
+    std::shared_ptr<SRTNetCore::NetworkConnection> clientCtx = typedCtx;
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, clientCtx, SRT_LIVE_MAX_PLSIZE));
+    typedCtx->mSocket = client.getBoundSocket();
+
+    const size_t kMessages = 10;
+    std::vector<uint8_t> sendBuffer(1000, 3);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+
+    auto receivedMessages = [&]() {
+        size_t messages = 0;
+        server.getActiveClients([&](std::map<SRTSOCKET, std::shared_ptr<SRTNetCore::NetworkConnection>>& clients) {
+            for (auto& [socket, ctx] : clients) {
+                messages += static_cast<TypedContextHandler::Context&>(*ctx).mReceivedMessages;
+            }
+        });
+        return messages;
+    };
+    for (int i = 0; i < 300 && receivedMessages() < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(receivedMessages(), kMessages);
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, DispatchKeepsOrderPerConnection) {
+    SRTNet server;
+    SRTNet::DispatchConfig dispatchConfig;
+    dispatchConfig.mWorkers = 2;
+    dispatchConfig.mQueueSize = 1024;
+    ASSERT_TRUE(server.setDispatch(dispatchConfig));
+
+    std::mutex receiveMutex;
+    std::map<SRTSOCKET, uint32_t> nextSequence;
+    std::map<SRTSOCKET, bool> disconnected;
+    std::atomic<size_t> outOfOrder = {0};
+    std::atomic<size_t> received = {0};
+    std::atomic<size_t> receivedAfterDisconnect = {0};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        uint32_t sequence = 0;
+        std::memcpy(&sequence, data, sizeof(sequence));
+        {
+            std::lock_guard<std::mutex> lock(receiveMutex);
+            if (disconnected[socket]) {
+                receivedAfterDisconnect++;
+            }
+            if (sequence != nextSequence[socket]) {
+                outOfOrder++;
+            }
+            nextSequence[socket] = sequence + 1;
+        }
+        // A heavy callback, the receive thread must keep reading the other connection meanwhile
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        received++;
+    };
+    server.clientDisconnected = [&](std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        std::lock_guard<std::mutex> lock(receiveMutex);
+        disconnected[socket] = true;
+    };
+
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    SRTNet clients[2];
+    for (auto& client : clients) {
+        ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    }
+
+    const uint32_t kMessages = 500;
+    std::vector<uint8_t> sendBuffer(1000);
+    for (uint32_t i = 0; i < kMessages; ++i) {
+        std::memcpy(sendBuffer.data(), &i, sizeof(i));
+        for (auto& client : clients) {
+            SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+            EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+        }
+    }
+    for (int i = 0; i < 500 && received < 2 * kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(received, 2 * kMessages);
+    EXPECT_EQ(outOfOrder, 0);
+
+    SRTNet::DispatchStatistics dispatchStats;
+    ASSERT_TRUE(server.getDispatchStatistics(dispatchStats));
+    EXPECT_EQ(dispatchStats.mQueued, 2 * kMessages);
+    EXPECT_EQ(dispatchStats.mOverflows, 0);
+    EXPECT_GT(dispatchStats.mMaxQueueDepth, 0);
+
+    for (auto& client : clients) {
+        EXPECT_TRUE(client.stop());
+    }
+    EXPECT_TRUE(server.stop());
+    EXPECT_EQ(disconnected.size(), 2);
+    EXPECT_EQ(receivedAfterDisconnect, 0);
+}
+
+TEST(TestSrt, DispatchStaticHandler) {
+    SRTNet::DispatchConfig dispatchConfig;
+    dispatchConfig.mWorkers = 1;
+    dispatchConfig.mQueueSize = 64;
+    SRTNetT<DispatchEchoHandler> server;
+    SRTNetT<DispatchEchoHandler> client;
+    ASSERT_TRUE(server.setDispatch(dispatchConfig));
+    ASSERT_TRUE(client.setDispatch(dispatchConfig));
+    auto ctx = std::make_shared<SRTNetCore::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    const size_t kMessages = 10;
+    std::vector<uint8_t> sendBuffer(1000, 7);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+    for (int i = 0; i < 300 && DispatchEchoHandler::mEchoedMessages < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(DispatchEchoHandler::mEchoedMessages, kMessages);
+
+    // Stop the server with messages still queued, the workers drain them while stop runs
+    DispatchEchoHandler::mSlow = true;
+    for (size_t i = 0; i < dispatchConfig.mQueueSize; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+    SRTNet::DispatchStatistics dispatchStats;
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_TRUE(server.getDispatchStatistics(dispatchStats));
+        if (dispatchStats.mQueueDepth > 1) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    DispatchEchoHandler::mStopping = true;
+    EXPECT_TRUE(server.stop()) << "Expect callbacks using the getters not to block stop";
+    EXPECT_GT(DispatchEchoHandler::mReceivedInStop, 0);
+    EXPECT_TRUE(client.stop());
+}
+
+TEST(TestSrt, DispatchQueueOverflow) {
+    SRTNet server;
+    SRTNet::DispatchConfig dispatchConfig;
+    dispatchConfig.mWorkers = 1;
+    dispatchConfig.mQueueSize = 8;
+    ASSERT_TRUE(server.setDispatch(dispatchConfig));
+
+    std::atomic<SRTSOCKET> clientSocket = {0};
+    std::atomic<size_t> received = {0};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        clientSocket = newSocket;
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        received++;
+    };
+
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    SRTNet client;
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    const size_t kMessages = 100;
+    std::vector<uint8_t> sendBuffer(1000, 1);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+
+    SRTNet::DispatchStatistics dispatchStats;
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_TRUE(server.getDispatchStatistics(dispatchStats, clientSocket));
+        if (dispatchStats.mQueued + dispatchStats.mOverflows == kMessages && dispatchStats.mQueueDepth == 0) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GT(dispatchStats.mOverflows, 0);
+    EXPECT_LE(dispatchStats.mMaxQueueDepth, dispatchConfig.mQueueSize);
+    EXPECT_EQ(dispatchStats.mQueued + dispatchStats.mOverflows, kMessages);
+    EXPECT_EQ(received, dispatchStats.mQueued);
+
+    EXPECT_FALSE(server.setDispatch(dispatchConfig)) << "Expect to fail when the server is started";
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, ThreadConfig) {
+    SRTNet server;
+    SRTNet::ThreadConfig invalidConfig;
+    invalidConfig.mRealtimePriority = 100;
+    EXPECT_FALSE(server.setThreadConfig(SRTNet::ThreadRole::event, invalidConfig));
+
+    SRTNet::ThreadConfig eventConfig;
+    eventConfig.mCpus = {0};
+    eventConfig.mName = "test-event";
+    ASSERT_TRUE(server.setThreadConfig(SRTNet::ThreadRole::event, eventConfig));
+
+    std::mutex threadMutex;
+    std::string threadName;
+    std::vector<int> threadCpus;
+    std::atomic<bool> received = {false};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+#if defined(__linux__)
+        std::lock_guard<std::mutex> lock(threadMutex);
+        char name[16] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        threadName = name;
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        threadCpus.clear();
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &cpuSet)) {
+                threadCpus.push_back(cpu);
+            }
+        }
+#endif
+        received = true;
+    };
+
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    EXPECT_FALSE(server.setThreadConfig(SRTNet::ThreadRole::event, eventConfig))
+        << "Expect to fail when the server is started";
+    SRTNet client;
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    std::vector<uint8_t> sendBuffer(100, 1);
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    for (int i = 0; i < 300 && !received; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(received);
+#if defined(__linux__)
+    {
+        std::lock_guard<std::mutex> lock(threadMutex);
+        EXPECT_EQ(threadName, "test-event");
+        EXPECT_EQ(threadCpus, std::vector<int>{0});
+    }
+#endif
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, StopLatency) {
+    const auto kMaxStopTime = std::chrono::milliseconds(100);
+    auto timeStop = [](SRTNet& net) {
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(net.stop());
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    };
+
+    SRTNet server;
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+
+    // Idle server, the accept thread waits in srt_accept and the event thread in srt_epoll_uwait
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LT(timeStop(server), kMaxStopTime);
+
+    // Server with a connected client
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    SRTNet client;
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LT(timeStop(server), kMaxStopTime);
+    EXPECT_LT(timeStop(client), kMaxStopTime);
+}
+
+TEST(TestSrt, StopDrainsSendBuffer) {
+    SRTNet server;
+    std::atomic<size_t> received = {0};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        received++;
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 120, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    SRTNet client;
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 120, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    const size_t kMessages = 200;
+    std::vector<uint8_t> sendBuffer(1316, 1);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(sendBuffer.data(), sendBuffer.size(), &msgCtrl));
+    }
+    EXPECT_TRUE(client.stop(std::chrono::milliseconds(2000)));
+
+    for (int i = 0; i < 100 && received < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(received, kMessages);
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, AdmissionMaxConnections) {
+    SRTNet server;
+    SRTNet::AdmissionConfig admissionConfig;
+    admissionConfig.mMaxConnections = 2;
+    admissionConfig.mMaxConnectionsPerIP = 1;
+    ASSERT_TRUE(server.setAdmissionControl(admissionConfig));
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("0.0.0.0", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+
+    SRTNet client1;
+    SRTNet client2;
+    SRTNet client3;
+    ASSERT_TRUE(client1.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    EXPECT_FALSE(client2.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE))
+        << "Expect the second connection from the same IP to be rejected";
+    // 127.0.0.2 is another source IP on the loopback interface (not available on every OS)
+    bool secondIP = client2.startClient("127.0.0.1", 8009, "127.0.0.2", 0, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE);
+    if (secondIP) {
+        EXPECT_FALSE(client3.startClient("127.0.0.1", 8009, "127.0.0.3", 0, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE))
+            << "Expect the third connection to be rejected";
+    }
+
+    SRTNet::AdmissionStatistics admissionStats = server.getAdmissionStatistics();
+    EXPECT_EQ(admissionStats.mConnections, secondIP ? 2 : 1);
+    EXPECT_EQ(admissionStats.mAccepted, secondIP ? 2 : 1);
+    EXPECT_GE(admissionStats.mRejectedPerIP, 1);
+    if (secondIP) {
+        EXPECT_GE(admissionStats.mRejectedMaxConnections, 1);
+    }
+
+    // A closed connection frees its share of the limits
+    EXPECT_TRUE(client1.stop());
+    for (int i = 0; i < 300 && server.getAdmissionStatistics().mConnections == admissionStats.mConnections; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(client1.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    EXPECT_TRUE(client1.stop());
+    EXPECT_TRUE(client2.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, AdmissionRateLimit) {
+    SRTNet server;
+    SRTNet::AdmissionConfig admissionConfig;
+    admissionConfig.mMaxConnectionRate = 0.5;
+    admissionConfig.mConnectionBurst = 2;
+    ASSERT_TRUE(server.setAdmissionControl(admissionConfig));
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+
+    SRTNet clients[3];
+    EXPECT_TRUE(clients[0].startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    EXPECT_TRUE(clients[1].startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    EXPECT_FALSE(clients[2].startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE))
+        << "Expect the connection after the burst to be rejected";
+
+    SRTNet::AdmissionStatistics admissionStats = server.getAdmissionStatistics();
+    EXPECT_EQ(admissionStats.mAccepted, 2);
+    EXPECT_GE(admissionStats.mRejectedRate, 1);
+
+    for (auto& client : clients) {
+        EXPECT_TRUE(client.stop());
+    }
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, OverloadDetection) {
+    SRTNet server;
+    SRTNet client;
+    std::mutex eventMtx;
+    std::condition_variable eventCondition;
+    std::vector<SRTNet::OverloadEvent> events;
+    SRTNet::OverloadStatus overloadStatus;
+
+    SRTNet::OverloadConfig overloadConfig;
+    overloadConfig.mInterval = std::chrono::milliseconds(50);
+    overloadConfig.mHighCallbackLoad = 0.8;
+    overloadConfig.mLowCallbackLoad = 0.2;
+    EXPECT_FALSE(server.setOverloadDetection(SRTNet::OverloadConfig(), [](SRTNet::OverloadEvent event,
+                                                                         const SRTNet::OverloadStatus& status,
+                                                                         std::shared_ptr<SRTNet::NetworkConnection>& ctx,
+                                                                         SRTSOCKET socket) {}))
+        << "Expect a config without thresholds to be rejected";
+    ASSERT_TRUE(server.setOverloadDetection(overloadConfig, [&](SRTNet::OverloadEvent event,
+                                                                const SRTNet::OverloadStatus& status,
+                                                                std::shared_ptr<SRTNet::NetworkConnection>& ctx,
+                                                                SRTSOCKET socket) {
+        std::lock_guard<std::mutex> lock(eventMtx);
+        if (event == SRTNet::OverloadEvent::overload) {
+            overloadStatus = status;
+        }
+        events.push_back(event);
+        eventCondition.notify_one();
+    }));
+
+    std::atomic<bool> slowCallback = {true};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        if (slowCallback) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    // 1000 packets per second, the callback can handle 200
+    std::vector<uint8_t> payload(1316);
+    for (int i = 0; i < 300; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(payload.data(), payload.size(), &msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    {
+        std::unique_lock<std::mutex> lock(eventMtx);
+        EXPECT_TRUE(eventCondition.wait_for(lock, std::chrono::seconds(2), [&]() { return !events.empty(); }));
+        ASSERT_FALSE(events.empty());
+        EXPECT_EQ(events.front(), SRTNet::OverloadEvent::overload);
+        EXPECT_GT(overloadStatus.mCallbackLoad, 0.8);
+        EXPECT_GE(overloadStatus.mMaxCallbackTime.count(), 5000);
+    }
+
+    // Let the callback catch up
+    slowCallback = false;
+    {
+        std::unique_lock<std::mutex> lock(eventMtx);
+        EXPECT_TRUE(eventCondition.wait_for(lock, std::chrono::seconds(3), [&]() { return events.size() >= 2; }));
+        ASSERT_EQ(events.size(), 2);
+        EXPECT_EQ(events.back(), SRTNet::OverloadEvent::recovered);
+    }
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, Logger) {
+    SRTNetLogger& logger = SRTNetLogger::get();
+    int defaultLevel = logger.getLevel();
+#ifndef DEBUG
+    EXPECT_EQ(defaultLevel, LOGG_OFF) << "Expect release builds to log nothing unless asked to";
+    EXPECT_FALSE(logger.isEnabled(LOGG_FATAL));
+#endif
+    std::mutex recordsMtx;
+    std::vector<std::pair<int, std::string>> records;
+    std::atomic<bool> blockSink = {false};
+    logger.setSink([&](const SRTNetLogger::Record& record) {
+        while (blockSink) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (record.mMessage.rfind("TestLogger", 0) == 0) {
+            std::lock_guard<std::mutex> lock(recordsMtx);
+            records.emplace_back(record.mLevel, std::string(record.mMessage));
+        }
+    });
+
+    logger.setLevel(LOGG_WARN);
+    EXPECT_FALSE(logger.isEnabled(LOGG_NOTIFY));
+    EXPECT_TRUE(logger.isEnabled(LOGG_ERROR));
+    logger.log(LOGG_NOTIFY, "TestLogger notify");
+    logger.log(LOGG_WARN, "TestLogger warn\n");
+    logger.log(LOGG_FATAL, "TestLogger fatal");
+    EXPECT_TRUE(logger.flush());
+    {
+        std::lock_guard<std::mutex> lock(recordsMtx);
+        ASSERT_EQ(records.size(), 2);
+        EXPECT_EQ(records[0].first, LOGG_WARN);
+        EXPECT_EQ(records[0].second, "TestLogger warn");
+        EXPECT_EQ(records[1].first, LOGG_FATAL);
+    }
+
+    // A stalled sink never blocks the logging threads, records that do not fit are dropped
+    blockSink = true;
+    logger.log(LOGG_ERROR, "TestLogger stall");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    uint64_t dropped = logger.getDroppedRecords();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < SRTNetLogger::kRingSize + 10; ++i) {
+        logger.log(LOGG_ERROR, "TestLogger fill");
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_GE(logger.getDroppedRecords() - dropped, 10);
+    blockSink = false;
+    EXPECT_TRUE(logger.flush());
+
+    logger.setSink(nullptr);
+    logger.setLevel(defaultLevel);
+}
+
+TEST(TestSrt, Recorder) {
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / "srtnet-recorder-test";
+    fs::remove_all(directory);
+    ASSERT_TRUE(fs::create_directories(directory));
+
+    SRTNetRecorder::Config recorderConfig;
+    recorderConfig.mDirectory = directory.string();
+    recorderConfig.mPrefix = "test";
+    recorderConfig.mMaxFileSize = 64 * 1024;
+    recorderConfig.mBufferSize = 16 * 1024;
+    recorderConfig.mIndexInterval = std::chrono::milliseconds(10);
+    auto recorder = std::make_shared<SRTNetRecorder>(recorderConfig);
+
+    SRTNet server;
+    SRTNet client;
+    ASSERT_TRUE(server.setRecorder(recorder));
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    const size_t kMessages = 200;
+    const size_t kMessageSize = 1000;
+    for (size_t i = 0; i < kMessages; ++i) {
+        std::vector<uint8_t> payload(kMessageSize, static_cast<uint8_t>(i));
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(payload.data(), payload.size(), &msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int i = 0; i < 300 && recorder->getStatistics().mRecords < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+    SRTNetRecorder::Statistics recorderStats = recorder->getStatistics();
+    EXPECT_EQ(recorderStats.mRecords, kMessages);
+    EXPECT_EQ(recorderStats.mRecordsDropped, 0);
+    // The last reference, waits for the writer to finish
+    EXPECT_TRUE(server.setRecorder(nullptr));
+    recorder.reset();
+
+    std::vector<std::pair<int, fs::path>> captures;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        std::string name = entry.path().filename().string();
+        if (entry.path().extension() == ".srtcap") {
+            size_t number = name.rfind('-') + 1;
+            captures.emplace_back(std::stoi(name.substr(number, name.size() - number - 7)), entry.path());
+        }
+    }
+    std::sort(captures.begin(), captures.end());
+    ASSERT_GT(captures.size(), 1) << "Expect the recording to be split by the size limit";
+
+    auto readFile = [](const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    size_t received = 0;
+    for (const auto& capture : captures) {
+        std::vector<uint8_t> data = readFile(capture.second);
+        EXPECT_LE(data.size(), recorderConfig.mMaxFileSize);
+        ASSERT_GE(data.size(), sizeof(SRTNetCaptureFileHeader));
+        EXPECT_EQ(std::memcmp(data.data(), kSRTNetCaptureMagic, sizeof(kSRTNetCaptureMagic)), 0);
+        std::map<uint64_t, int64_t> recordTimes;
+        size_t offset = sizeof(SRTNetCaptureFileHeader);
+        while (offset + sizeof(SRTNetCaptureRecordHeader) <= data.size()) {
+            SRTNetCaptureRecordHeader header;
+            std::memcpy(&header, data.data() + offset, sizeof(header));
+            recordTimes[offset] = header.mArrivalTime;
+            offset += sizeof(header);
+            ASSERT_EQ(header.mSize, kMessageSize);
+            ASSERT_LE(offset + header.mSize, data.size());
+            EXPECT_EQ(data[offset], static_cast<uint8_t>(received));
+            EXPECT_EQ(data[offset + header.mSize - 1], static_cast<uint8_t>(received));
+            offset += header.mSize;
+            received++;
+        }
+        EXPECT_EQ(offset, data.size());
+
+        // Every index entry points at a record with the same arrival time
+        fs::path indexPath = capture.second;
+        indexPath += ".idx";
+        std::vector<uint8_t> index = readFile(indexPath);
+        ASSERT_GE(index.size(), sizeof(SRTNetCaptureFileHeader) + sizeof(SRTNetCaptureIndexEntry));
+        EXPECT_EQ(std::memcmp(index.data(), kSRTNetIndexMagic, sizeof(kSRTNetIndexMagic)), 0);
+        for (size_t entryOffset = sizeof(SRTNetCaptureFileHeader); entryOffset < index.size();
+             entryOffset += sizeof(SRTNetCaptureIndexEntry)) {
+            SRTNetCaptureIndexEntry entry;
+            std::memcpy(&entry, index.data() + entryOffset, sizeof(entry));
+            ASSERT_EQ(recordTimes.count(entry.mOffset), 1);
+            EXPECT_EQ(recordTimes[entry.mOffset], entry.mArrivalTime);
+        }
+    }
+    EXPECT_EQ(received, kMessages);
+    fs::remove_all(directory);
+}
+
+TEST(TestSrt, CaptureReaderSeek) {
+    namespace fs = std::filesystem;
+    fs::path directory = fs::temp_directory_path() / "srtnet-capture-reader-test";
+    fs::remove_all(directory);
+    ASSERT_TRUE(fs::create_directories(directory));
+
+    SRTNetRecorder::Config recorderConfig;
+    recorderConfig.mDirectory = directory.string();
+    recorderConfig.mPrefix = "test";
+    recorderConfig.mBufferSize = 4096;
+    recorderConfig.mIndexInterval = std::chrono::milliseconds(20);
+    auto recorder = std::make_shared<SRTNetRecorder>(recorderConfig);
+    auto recording = recorder->open("seek");
+    std::vector<uint8_t> payload(100);
+    for (int i = 0; i < 100; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        msgCtrl.msgno = i;
+        EXPECT_TRUE(recording->write(payload.data(), payload.size(), msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    recording->close();
+    recording.reset();
+    recorder.reset();
+
+    fs::path capture;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == ".srtcap") {
+            capture = entry.path();
+        }
+    }
+    SRTNetCaptureReader reader;
+    ASSERT_TRUE(reader.open(capture.string()));
+    EXPECT_GT(reader.getIndex().size(), 2);
+    std::vector<SRTNetCaptureRecordHeader> headers;
+    SRTNetCaptureRecordHeader header;
+    while (reader.next(header, payload)) {
+        headers.push_back(header);
+    }
+    ASSERT_EQ(headers.size(), 100);
+
+    // Seek to a time between two records, the reader continues at the later one
+    int64_t target = headers[60].mArrivalTime - 1;
+    ASSERT_TRUE(reader.seek(target));
+    ASSERT_TRUE(reader.next(header, payload));
+    EXPECT_EQ(header.mMsgNo, headers[60].mMsgNo);
+    EXPECT_EQ(payload.size(), 100);
+    EXPECT_FALSE(reader.seek(headers.back().mArrivalTime + 1));
+    fs::remove_all(directory);
+}
+
+TEST(TestSrt, Relay) {
+    const uint16_t kOutputPorts[] = {8010, 8011};
+    const size_t kMessages = 100;
+
+    // Two downstream servers, each counting what the relay forwards to it
+    SRTNet downstream[2];
+    std::atomic<size_t> received[2] = {0, 0};
+    std::atomic<size_t> corrupted = {0};
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    for (size_t i = 0; i < 2; ++i) {
+        downstream[i].clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                            std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+            return std::make_shared<SRTNet::NetworkConnection>();
+        };
+        downstream[i].receivedDataNoCopy = [&, i](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                                  std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+            if (size != 1000 || data[0] != data[size - 1]) {
+                corrupted++;
+            }
+            received[i]++;
+        };
+        ASSERT_TRUE(downstream[i].startServer("127.0.0.1", kOutputPorts[i], 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000,
+                                              "", false, ctx));
+    }
+
+    SRTNet outputs[2];
+    SRTNetRelay relay;
+    int outputIds[2];
+    for (size_t i = 0; i < 2; ++i) {
+        ASSERT_TRUE(outputs[i].startClient("127.0.0.1", kOutputPorts[i], 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+        outputIds[i] = relay.addOutput(outputs[i]);
+        ASSERT_GT(outputIds[i], 0);
+    }
+
+    SRTNet ingest;
+    SRTNet source;
+    ingest.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    ingest.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        relay.ingest(data, size, msgCtrl);
+    };
+    ASSERT_TRUE(ingest.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(source.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    for (size_t i = 0; i < kMessages; ++i) {
+        std::vector<uint8_t> payload(1000, static_cast<uint8_t>(i));
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(source.sendData(payload.data(), payload.size(), &msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int i = 0; i < 300 && (received[0] < kMessages || received[1] < kMessages ||
+                                relay.getStatistics().mBuffersInUse > 0);
+         ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(received[0], kMessages);
+    EXPECT_EQ(received[1], kMessages);
+    EXPECT_EQ(corrupted, 0);
+
+    SRTNetRelay::Statistics relayStats = relay.getStatistics();
+    EXPECT_EQ(relayStats.mIngested, kMessages);
+    EXPECT_EQ(relayStats.mIngestDropped, 0);
+    EXPECT_EQ(relayStats.mBuffersInUse, 0) << "Expect every buffer back in the pool";
+    EXPECT_EQ(relayStats.mOutputs, 2);
+    for (int id : outputIds) {
+        SRTNetRelay::OutputStatistics outputStats;
+        ASSERT_TRUE(relay.getOutputStatistics(id, outputStats));
+        EXPECT_EQ(outputStats.mForwarded, kMessages);
+        EXPECT_EQ(outputStats.mDropped, 0);
+        EXPECT_EQ(outputStats.mQueueDepth, 0);
+        EXPECT_GT(outputStats.mMeanLatency, 0.0);
+        EXPECT_GE(outputStats.mMaxLatency, static_cast<int64_t>(outputStats.mMeanLatency));
+    }
+    EXPECT_TRUE(relay.removeOutput(outputIds[0]));
+    EXPECT_FALSE(relay.removeOutput(outputIds[0]));
+
+    EXPECT_TRUE(source.stop());
+    EXPECT_TRUE(ingest.stop());
+    EXPECT_TRUE(relay.removeOutput(outputIds[1]));
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_TRUE(outputs[i].stop());
+        EXPECT_TRUE(downstream[i].stop());
+    }
+}
+
+TEST(TestSrt, RelayBlockedOutput) {
+    const size_t kMessages = 20;
+    const size_t kQueueSize = 4;
+
+    auto waitFor = [](const std::function<bool()>& condition) {
+        for (int i = 0; i < 300 && !condition(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return condition();
+    };
+
+    for (auto policy : {SRTNetRelay::DropPolicy::oldest, SRTNetRelay::DropPolicy::newest}) {
+        SCOPED_TRACE(policy == SRTNetRelay::DropPolicy::oldest ? "oldest" : "newest");
+        std::mutex receivedMtx;
+        std::vector<uint8_t> fastReceived;
+        std::vector<uint8_t> slowReceived;
+        std::atomic<bool> blocked = {true};
+        std::atomic<bool> sending = {false};
+
+        SRTNetRelay relay;
+        SRTNetRelay::OutputConfig fastConfig;
+        fastConfig.mQueueSize = kMessages;
+        int fastId = relay.addOutput(
+            [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl) {
+                std::lock_guard<std::mutex> lock(receivedMtx);
+                fastReceived.push_back(data[0]);
+                return true;
+            },
+            fastConfig);
+        SRTNetRelay::OutputConfig slowConfig;
+        slowConfig.mQueueSize = kQueueSize;
+        slowConfig.mDropPolicy = policy;
+        int slowId = relay.addOutput(
+            [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl) {
+                sending = true;
+                while (blocked) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                std::lock_guard<std::mutex> lock(receivedMtx);
+                slowReceived.push_back(data[0]);
+                return true;
+            },
+            slowConfig);
+        ASSERT_GT(fastId, 0);
+        ASSERT_GT(slowId, 0);
+
+        // The slow output takes the first message and blocks in its send, the rest of the burst hits its full queue
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        uint8_t message = 0;
+        EXPECT_TRUE(relay.ingest(&message, sizeof(message), msgCtrl));
+        ASSERT_TRUE(waitFor([&]() { return sending.load(); }));
+        for (message = 1; message < kMessages; ++message) {
+            EXPECT_TRUE(relay.ingest(&message, sizeof(message), msgCtrl));
+        }
+        EXPECT_TRUE(waitFor([&]() {
+            std::lock_guard<std::mutex> lock(receivedMtx);
+            return fastReceived.size() == kMessages;
+        })) << "Expect the other output to get every message while one output is blocked";
+
+        SRTNetRelay::OutputStatistics slowStats;
+        ASSERT_TRUE(relay.getOutputStatistics(slowId, slowStats));
+        EXPECT_EQ(slowStats.mDropped, kMessages - 1 - kQueueSize);
+        EXPECT_EQ(slowStats.mQueueDepth, kQueueSize);
+        SRTNetRelay::OutputStatistics fastStats;
+        ASSERT_TRUE(relay.getOutputStatistics(fastId, fastStats));
+        EXPECT_EQ(fastStats.mDropped, 0);
+
+        blocked = false;
+        EXPECT_TRUE(waitFor([&]() {
+            std::lock_guard<std::mutex> lock(receivedMtx);
+            return slowReceived.size() == kQueueSize + 1;
+        }));
+        // The message being sent when the output blocked, then what its queue kept
+        std::vector<uint8_t> expected = {0};
+        for (size_t i = 0; i < kQueueSize; ++i) {
+            expected.push_back(static_cast<uint8_t>(
+                policy == SRTNetRelay::DropPolicy::oldest ? kMessages - kQueueSize + i : 1 + i));
+        }
+        std::vector<uint8_t> expectedFast(kMessages);
+        for (size_t i = 0; i < kMessages; ++i) {
+            expectedFast[i] = static_cast<uint8_t>(i);
+        }
+        std::lock_guard<std::mutex> lock(receivedMtx);
+        EXPECT_EQ(slowReceived, expected);
+        EXPECT_EQ(fastReceived, expectedFast);
+    }
+}
+
+#if defined(__linux__)
+TEST(TestSrt, UdpGatewayMulticast) {
+    const char* kInputGroup = "239.255.10.1";
+    const char* kOutputGroup = "239.255.10.2";
+    const uint16_t kInputPort = 5001;
+    const uint16_t kOutputPort = 5003;
+    const size_t kMessages = 10;
+    const size_t kPacketsPerMessage = 7;
+
+    // The listener on the output group, joined on the loopback interface
+    int listener = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(listener, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in listenAddress{};
+    listenAddress.sin_family = AF_INET;
+    listenAddress.sin_port = htons(kOutputPort);
+    inet_pton(AF_INET, kOutputGroup, &listenAddress.sin_addr);
+    ASSERT_EQ(bind(listener, reinterpret_cast<sockaddr*>(&listenAddress), sizeof(listenAddress)), 0);
+    ip_mreq membership{};
+    membership.imr_multiaddr = listenAddress.sin_addr;
+    inet_pton(AF_INET, "127.0.0.1", &membership.imr_interface);
+    ASSERT_EQ(setsockopt(listener, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)), 0);
+    timeval timeout{2, 0};
+    setsockopt(listener, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // UDP multicast -> input -> SRT client -> SRT server -> output -> UDP multicast
+    SRTNet server;
+    SRTNet client;
+    SRTNetUdpOutput output;
+    SRTNetUdpOutput::Config outputConfig;
+    outputConfig.mAddress = kOutputGroup;
+    outputConfig.mPort = kOutputPort;
+    outputConfig.mInterface = "127.0.0.1";
+    ASSERT_TRUE(output.start(outputConfig));
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        output.send(data, size);
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    SRTNetUdpInput input;
+    SRTNetUdpInput::Config inputConfig;
+    inputConfig.mAddress = kInputGroup;
+    inputConfig.mPort = kInputPort;
+    inputConfig.mInterface = "127.0.0.1";
+    inputConfig.mTsPacketsPerMessage = kPacketsPerMessage;
+    // Only full messages are sent, a slow sender must not get a partly filled message flushed by the deadline
+    inputConfig.mMaxAggregationDelay = std::chrono::seconds(10);
+    ASSERT_TRUE(input.start(client, inputConfig));
+
+    // One TS packet per datagram, the input packs 7 into every SRT message
+    int sender = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_GE(sender, 0);
+    in_addr loopback{};
+    inet_pton(AF_INET, "127.0.0.1", &loopback);
+    ASSERT_EQ(setsockopt(sender, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)), 0);
+    sockaddr_in inputAddress{};
+    inputAddress.sin_family = AF_INET;
+    inputAddress.sin_port = htons(kInputPort);
+    inet_pton(AF_INET, kInputGroup, &inputAddress.sin_addr);
+    for (size_t i = 0; i < kMessages * kPacketsPerMessage; ++i) {
+        uint8_t packet[188] = {0x47};
+        std::memset(packet + 1, static_cast<int>(i), sizeof(packet) - 1);
+        ASSERT_EQ(sendto(sender, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&inputAddress),
+                         sizeof(inputAddress)),
+                  static_cast<ssize_t>(sizeof(packet)));
+    }
+
+    size_t packet = 0;
+    for (size_t i = 0; i < kMessages; ++i) {
+        uint8_t datagram[2048];
+        ssize_t received = recv(listener, datagram, sizeof(datagram), 0);
+        ASSERT_EQ(received, static_cast<ssize_t>(kPacketsPerMessage * 188)) << "Datagram " << i;
+        for (size_t offset = 0; offset < static_cast<size_t>(received); offset += 188) {
+            EXPECT_EQ(datagram[offset], 0x47);
+            EXPECT_EQ(datagram[offset + 187], static_cast<uint8_t>(packet++));
+        }
+    }
+    EXPECT_EQ(packet, kMessages * kPacketsPerMessage);
+
+    SRTNetUdpInput::Statistics inputStats = input.getStatistics();
+    EXPECT_EQ(inputStats.mDatagrams, kMessages * kPacketsPerMessage);
+    EXPECT_EQ(inputStats.mMessages, kMessages);
+    EXPECT_LE(inputStats.mBatches, inputStats.mDatagrams);
+    SRTNetUdpOutput::Statistics outputStats = output.getStatistics();
+    EXPECT_EQ(outputStats.mDatagrams, kMessages);
+    EXPECT_EQ(outputStats.mDropped, 0);
+
+    input.stop();
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+    output.stop();
+    close(sender);
+    close(listener);
+}
+#endif
+
+TEST(TestSrt, PlayoutPacer) {
+    const size_t kMessages = 20;
+    const int64_t kSpacing = 5000;
+    SRTNetPlayoutPacer pacer;
+    SRTNetPlayoutPacer::Config config;
+    config.mOffset = std::chrono::milliseconds(20);
+    std::mutex releaseMtx;
+    std::vector<int64_t> releases;
+    ASSERT_TRUE(pacer.start(config, [&](const uint8_t* data, size_t size, const SRT_MSGCTRL& msgCtrl) {
+        std::lock_guard<std::mutex> lock(releaseMtx);
+        releases.push_back(srt_time_now());
+    }));
+
+    // A burst of messages with source times 5 ms apart, as after a receive wakeup
+    int64_t base = srt_time_now();
+    std::vector<uint8_t> payload(1316);
+    for (size_t i = 0; i < kMessages; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        msgCtrl.srctime = base + static_cast<int64_t>(i) * kSpacing;
+        EXPECT_TRUE(pacer.push(payload.data(), payload.size(), msgCtrl));
+    }
+    for (int i = 0; i < 200 && pacer.getStatistics().mReleased < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    {
+        std::lock_guard<std::mutex> lock(releaseMtx);
+        ASSERT_EQ(releases.size(), kMessages);
+        for (size_t i = 0; i < kMessages; ++i) {
+            EXPECT_GE(releases[i], base + 20000 + static_cast<int64_t>(i) * kSpacing) << "Released early " << i;
+            if (i > 0) {
+                EXPECT_NEAR(releases[i] - releases[i - 1], kSpacing, 2000) << "Message " << i;
+            }
+        }
+    }
+    SRTNetPlayoutPacer::Statistics stats = pacer.getStatistics();
+    EXPECT_EQ(stats.mReleased, kMessages);
+    EXPECT_EQ(stats.mLate, 0);
+    EXPECT_EQ(stats.mDropped, 0);
+    EXPECT_GE(stats.mMaxQueueDepth, kMessages);
+    EXPECT_GE(stats.mMeanError, 0.0);
+
+    // A message that is already due is released at once and counted as late
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    msgCtrl.srctime = srt_time_now() - 100000;
+    EXPECT_TRUE(pacer.push(payload.data(), payload.size(), msgCtrl));
+    for (int i = 0; i < 100 && pacer.getStatistics().mReleased <= kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(pacer.getStatistics().mLate, 1);
+    pacer.stop();
+}
+
+TEST(TestSrt, SendPacer) {
+    const uint16_t kPcrPid = 0x100;
+    const size_t kPcrIntervals = 25;
+    const size_t kPacketsPerInterval = 53;
+    const int64_t kPcrInterval = SRTNetTS::kPcrClock / 50; // 20 ms
+    const size_t kIntervalsPerBurst = 5;
+
+    // A constant bitrate stream with a PCR every 20 ms
+    std::vector<uint8_t> stream;
+    for (size_t interval = 0; interval < kPcrIntervals; ++interval) {
+        for (size_t i = 0; i < kPacketsPerInterval; ++i) {
+            uint8_t packet[SRTNetTS::kPacketSize] = {SRTNetTS::kSyncByte, kPcrPid >> 8, kPcrPid & 0xff, 0x10};
+            if (i == 0) {
+                int64_t pcr = static_cast<int64_t>(interval) * kPcrInterval;
+                int64_t base = pcr / 300;
+                int64_t extension = pcr % 300;
+                packet[3] = 0x30;
+                packet[4] = 7;
+                packet[5] = 0x10;
+                packet[6] = static_cast<uint8_t>(base >> 25);
+                packet[7] = static_cast<uint8_t>(base >> 17);
+                packet[8] = static_cast<uint8_t>(base >> 9);
+                packet[9] = static_cast<uint8_t>(base >> 1);
+                packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7e | (extension >> 8));
+                packet[11] = static_cast<uint8_t>(extension);
+                ASSERT_EQ(SRTNetTS::pcr(packet), pcr);
+            }
+            stream.insert(stream.end(), packet, packet + sizeof(packet));
+        }
+    }
+    const size_t kMessageSize = 7 * SRTNetTS::kPacketSize;
+    const size_t kBurstSize = kIntervalsPerBurst * kPacketsPerInterval * SRTNetTS::kPacketSize;
+    const size_t kMessages = (stream.size() + kMessageSize - 1) / kMessageSize;
+
+    SRTNet server;
+    SRTNet client;
+    std::atomic<size_t> received = {0};
+    std::atomic<size_t> backwards = {0};
+    int64_t lastSrcTime = 0;
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        if (msgCtrl.srctime < lastSrcTime) {
+            backwards++;
+        }
+        lastSrcTime = msgCtrl.srctime;
+        received++;
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    SRTNetSendPacer pacer;
+    SRTNetSendPacer::Config config;
+    config.mDelay = std::chrono::milliseconds(150);
+    ASSERT_TRUE(pacer.start(client, config));
+
+    // The muxer writes 100 ms of stream at once
+    auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0, burst = 0; offset < stream.size(); ++burst) {
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(100) * burst);
+        size_t burstEnd = std::min(stream.size(), offset + kBurstSize);
+        for (; offset < burstEnd; offset += kMessageSize) {
+            EXPECT_TRUE(pacer.push(stream.data() + offset, std::min(kMessageSize, stream.size() - offset)));
+        }
+    }
+    for (int i = 0; i < 300 && pacer.getStatistics().mMessages < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (int i = 0; i < 300 && received < kMessages; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    SRTNetSendPacer::Statistics stats = pacer.getStatistics();
+    EXPECT_EQ(stats.mMessages, kMessages);
+    EXPECT_EQ(stats.mDropped, 0);
+    EXPECT_EQ(stats.mPcrs, kPcrIntervals);
+    EXPECT_EQ(stats.mDiscontinuities, 0);
+    // Only the messages after the last PCR are sent unpaced
+    EXPECT_LE(stats.mUnpaced, kPacketsPerInterval / 7 + 1);
+    double bitrate = kPacketsPerInterval * SRTNetTS::kPacketSize * 8.0 * 50.0;
+    EXPECT_NEAR(stats.mBitrate, bitrate, bitrate * 0.01);
+    EXPECT_LT(stats.mOutputPeakRate * 2.0, stats.mInputPeakRate) << "Expect the pacer to remove the bursts";
+    EXPECT_EQ(received, kMessages);
+    EXPECT_EQ(backwards, 0);
+    pacer.stop();
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, ClientPool) {
+    const size_t kClients = 4;
+    const size_t kMessages = 50;
+
+    // The server echoes every message back to the connection it came on
+    SRTNet server;
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        SRT_MSGCTRL echoCtrl = srt_msgctrl_default;
+        server.sendData(data, size, &echoCtrl, socket);
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+
+    SRTNetClientPool::Config config;
+    config.mThreads = 2;
+    SRTNetClientPool pool(config);
+    std::atomic<size_t> received[kClients] = {};
+    std::atomic<size_t> misrouted = {0};
+    std::atomic<size_t> disconnected = {0};
+    pool.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                  std::shared_ptr<SRTNetCore::NetworkConnection>& ctx, SRTSOCKET socket) {
+        auto index = std::any_cast<size_t>(ctx->mObject);
+        if (data[0] != index) {
+            misrouted++;
+        }
+        received[index]++;
+    };
+    pool.clientDisconnected = [&](std::shared_ptr<SRTNetCore::NetworkConnection>& ctx, SRTSOCKET socket) {
+        disconnected++;
+    };
+
+    SRTSOCKET sockets[kClients];
+    for (size_t i = 0; i < kClients; ++i) {
+        auto clientCtx = std::make_shared<SRTNet::NetworkConnection>();
+        clientCtx->mObject = i;
+        sockets[i] = pool.addClient("127.0.0.1", 8009, 16, 1000, 100, clientCtx, SRT_LIVE_MAX_PLSIZE);
+        ASSERT_NE(sockets[i], SRT_INVALID_SOCK);
+    }
+    EXPECT_EQ(pool.getPoolStatistics().mConnections, kClients);
+    EXPECT_EQ(pool.getPoolStatistics().mThreads, 2);
+
+    for (size_t message = 0; message < kMessages; ++message) {
+        for (size_t i = 0; i < kClients; ++i) {
+            std::vector<uint8_t> payload(1000, static_cast<uint8_t>(i));
+            SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+            EXPECT_TRUE(pool.sendData(payload.data(), payload.size(), &msgCtrl, sockets[i]));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto allReceived = [&]() {
+        return std::all_of(std::begin(received), std::end(received),
+                           [&](const std::atomic<size_t>& count) { return count == kMessages; });
+    };
+    for (int i = 0; i < 300 && !allReceived(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (size_t i = 0; i < kClients; ++i) {
+        EXPECT_EQ(received[i], kMessages) << "Connection " << i;
+    }
+    EXPECT_EQ(misrouted, 0);
+    EXPECT_EQ(pool.getPoolStatistics().mMessages, kClients * kMessages);
+
+    SRT_TRACEBSTATS stats;
+    EXPECT_TRUE(pool.getStatistics(&stats, 0, 1, sockets[0]));
+    EXPECT_EQ(stats.pktSentUniqueTotal, kMessages);
+
+    // A removed connection is not reported as lost, the others are when the server goes away
+    EXPECT_TRUE(pool.removeClient(sockets[0]));
+    EXPECT_FALSE(pool.removeClient(sockets[0]));
+    uint8_t payload[1] = {0};
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    EXPECT_FALSE(pool.sendData(payload, sizeof(payload), &msgCtrl, sockets[0]));
+    EXPECT_TRUE(server.stop());
+    for (int i = 0; i < 500 && disconnected < kClients - 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(disconnected, kClients - 1);
+    EXPECT_EQ(pool.getPoolStatistics().mConnections, 0);
+    EXPECT_EQ(pool.getPoolStatistics().mDisconnects, kClients - 1);
+    pool.stop();
+}
+
+TEST(TestSrt, EpochReclamation) {
+    SRTNetEpoch epoch;
+    std::atomic<int> reclaimed = {0};
+    {
+        SRTNetEpoch::Guard guard(epoch);
+        epoch.retire([&]() { reclaimed++; });
+        epoch.reclaim();
+        EXPECT_EQ(reclaimed, 0) << "Expect a reader that entered before the retire to hold the reclaim back";
+    }
+    epoch.reclaim();
+    EXPECT_EQ(reclaimed, 1);
+
+    // A reader entered after the retire does not hold it back
+    epoch.retire([&]() { reclaimed++; });
+    {
+        SRTNetEpoch::Guard guard(epoch);
+        epoch.reclaim();
+        EXPECT_EQ(reclaimed, 2);
+    }
+
+    // synchronize waits for the readers on other threads
+    std::atomic<bool> entered = {false};
+    std::atomic<bool> left = {false};
+    std::thread reader([&]() {
+        SRTNetEpoch::Guard guard(epoch);
+        entered = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        left = true;
+    });
+    while (!entered) {
+        std::this_thread::yield();
+    }
+    epoch.retire([&]() { reclaimed++; });
+    epoch.synchronize();
+    EXPECT_TRUE(left);
+    EXPECT_EQ(reclaimed, 3);
+    reader.join();
+}
+
+TEST(TestSrt, ConcurrentSendData) {
+    const size_t kClients = 4;
+
+    SRTNet server;
+    std::atomic<size_t> received = {0};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+
+    SRTNet clients[kClients];
+    for (auto& client : clients) {
+        client.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                        std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+            received++;
+        };
+        ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    }
+    std::vector<SRTSOCKET> sockets;
+    for (int i = 0; i < 300 && sockets.size() < kClients; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        sockets.clear();
+        server.getActiveClients([&](std::map<SRTSOCKET, std::shared_ptr<SRTNet::NetworkConnection>>& clientList) {
+            for (auto& client : clientList) {
+                sockets.push_back(client.first);
+            }
+        });
+    }
+    ASSERT_EQ(sockets.size(), kClients);
+
+    // Every thread sends on its own connection while a client goes away and then the server stops
+    std::atomic<bool> sending = {true};
+    std::atomic<size_t> sent = {0};
+    std::vector<std::thread> senders;
+    for (SRTSOCKET socket : sockets) {
+        senders.emplace_back([&, socket]() {
+            uint8_t payload[188] = {0x47};
+            while (sending) {
+                SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+                if (server.sendData(payload, sizeof(payload), &msgCtrl, socket)) {
+                    sent++;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(clients[0].stop());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_TRUE(server.stop());
+    size_t sentAtStop = sent;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(sent, sentAtStop) << "Expect no send to succeed after stop";
+    sending = false;
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    EXPECT_GT(sentAtStop, 0);
+    EXPECT_GT(received, 0);
+
+    // Sockets the server never had are refused
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    uint8_t payload[188] = {0x47};
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    EXPECT_FALSE(server.sendData(payload, sizeof(payload), &msgCtrl, sockets[0]));
+    EXPECT_TRUE(server.stop());
+    for (auto& client : clients) {
+        client.stop();
+    }
+}
+
+TEST(TestSrt, SendDataInClientConnected) {
+    SRTNet server;
+    std::atomic<bool> sentInCallback = {false};
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        uint8_t greeting[4] = {1, 2, 3, 4};
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        sentInCallback = server.sendData(greeting, sizeof(greeting), &msgCtrl, newSocket);
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+
+    SRTNet client;
+    std::atomic<size_t> received = {0};
+    client.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        if (size == 4 && data[0] == 1 && data[3] == 4) {
+            received++;
+        }
+    };
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    for (int i = 0; i < 300 && received == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(sentInCallback) << "Expect a new connection to be sendable from clientConnected";
+    EXPECT_EQ(received, 1);
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, FrameReassembly) {
+    // Frames of one byte, one message, several messages and many messages
+    const size_t kFrameSizes[] = {1, 1000, 5000, 200000};
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t size : kFrameSizes) {
+        std::vector<uint8_t> frame(size);
+        for (size_t i = 0; i < size; ++i) {
+            frame[i] = static_cast<uint8_t>(i * 7 + size);
+        }
+        frames.push_back(std::move(frame));
+    }
+
+    SRTNet server;
+    SRTNet client;
+    SRTNetFrameReassembler reassembler;
+    std::mutex receivedMutex;
+    std::vector<std::vector<uint8_t>> received;
+    std::atomic<size_t> plainMessages = {0};
+    ASSERT_TRUE(reassembler.start(SRTNetFrameReassembler::Config(),
+                                  [&](const uint8_t* data, size_t size, SRTSOCKET socket) {
+                                      std::lock_guard<std::mutex> lock(receivedMutex);
+                                      received.emplace_back(data, data + size);
+                                  }));
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        if (!reassembler.receive(data, size, socket)) {
+            plainMessages++;
+        }
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    SRTNetFrameSender sender;
+    EXPECT_FALSE(sender.sendFrame(client, frames[0].data(), sender.getMaxFrameSize() + 1));
+    for (auto& frame : frames) {
+        EXPECT_TRUE(sender.sendFrame(client, frame.data(), frame.size()));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    uint8_t plain[100] = {0x47};
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    EXPECT_TRUE(client.sendData(plain, sizeof(plain), &msgCtrl));
+
+    for (int i = 0; i < 300 && (reassembler.getStatistics().mFrames < frames.size() || plainMessages == 0); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(plainMessages, 1);
+    {
+        std::lock_guard<std::mutex> lock(receivedMutex);
+        ASSERT_EQ(received.size(), frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) {
+            EXPECT_EQ(received[i], frames[i]) << "Frame " << i;
+        }
+    }
+    SRTNetFrameReassembler::Statistics stats = reassembler.getStatistics();
+    EXPECT_EQ(stats.mPending, 0);
+    EXPECT_EQ(stats.mExpired, 0);
+    EXPECT_EQ(stats.mInvalid, 0);
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+
+    // A frame missing a fragment is dropped when its TTL expires
+    SRTNetFrameReassembler::Config config;
+    config.mTtl = std::chrono::milliseconds(20);
+    size_t delivered = 0;
+    ASSERT_TRUE(reassembler.start(config, [&](const uint8_t* data, size_t size, SRTSOCKET socket) { delivered++; }));
+    // Fragment 0 of 2 of frame 7, 10 of 20 bytes
+    uint8_t fragment[SRTNetFraming::kHeaderSize + 10] = {SRTNetFraming::kMagic, SRTNetFraming::kVersion, 0, 0, 0, 2,
+                                                          0, 0, 0, 7, 0, 0, 0, 20};
+    EXPECT_TRUE(reassembler.receive(fragment, sizeof(fragment), 1));
+    EXPECT_EQ(reassembler.getStatistics().mPending, 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    reassembler.expire();
+    EXPECT_EQ(reassembler.getStatistics().mPending, 0);
+    EXPECT_EQ(reassembler.getStatistics().mExpired, 1);
+    // The last fragment alone does not complete it any more
+    fragment[3] = 1;
+    EXPECT_TRUE(reassembler.receive(fragment, sizeof(fragment), 1));
+    EXPECT_EQ(delivered, 0);
+    EXPECT_EQ(reassembler.getStatistics().mPending, 1);
+}
+
+TEST(TestSrt, PriorityMux) {
+    const size_t kMessages = 50;
+    const size_t kExpiring = 10;
+
+    SRTNet server;
+    SRTNet client;
+    SRTNetDemux demux;
+    std::mutex orderMutex;
+    std::vector<int> order;
+    std::atomic<size_t> plainMessages = {0};
+    std::atomic<size_t> corrupted = {0};
+    for (int stream = 0; stream < 3; ++stream) {
+        demux.setStreamCallback(stream, [&, stream](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                                    SRTSOCKET socket) {
+            if (size != 1000 || data[0] != stream) {
+                corrupted++;
+            }
+            std::lock_guard<std::mutex> lock(orderMutex);
+            order.push_back(stream);
+        });
+    }
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        if (!demux.receive(data, size, msgCtrl, socket)) {
+            plainMessages++;
+        }
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    SRTNetMux mux;
+    SRTNetMux::StreamConfig telemetry;
+    int telemetryStream = mux.openStream(telemetry);
+    SRTNetMux::StreamConfig audio;
+    audio.mPriority = 10;
+    int audioStream = mux.openStream(audio);
+    SRTNetMux::StreamConfig stale;
+    stale.mPriority = -1;
+    stale.mTtl = std::chrono::milliseconds(20);
+    int staleStream = mux.openStream(stale);
+    ASSERT_EQ(telemetryStream, 0);
+    ASSERT_EQ(audioStream, 1);
+    ASSERT_EQ(staleStream, 2);
+
+    // 2 Mbps, a 1000 byte message every 4 ms, so the queues build up
+    SRTNetMux::Config config;
+    config.mBitrate = 2000000;
+    ASSERT_TRUE(mux.start(client, config));
+    EXPECT_EQ(mux.openStream(telemetry), -1) << "Expect streams to be opened before start";
+
+    std::vector<uint8_t> payload(1000);
+    for (int stream : {staleStream, telemetryStream, audioStream}) {
+        std::fill(payload.begin(), payload.end(), static_cast<uint8_t>(stream));
+        for (size_t i = 0; i < (stream == staleStream ? kExpiring : kMessages); ++i) {
+            EXPECT_TRUE(mux.send(stream, payload.data(), payload.size()));
+        }
+    }
+    EXPECT_FALSE(mux.send(audioStream, payload.data(), SRTNetMux::kMaxPayloadSize + 1));
+    uint8_t plain[100] = {0x47};
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    EXPECT_TRUE(client.sendData(plain, sizeof(plain), &msgCtrl));
+
+    for (int i = 0; i < 300; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(orderMutex);
+            if (order.size() >= 2 * kMessages) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    mux.stop();
+
+    std::lock_guard<std::mutex> lock(orderMutex);
+    ASSERT_EQ(order.size(), 2 * kMessages);
+    EXPECT_EQ(static_cast<size_t>(std::count(order.begin(), order.end(), audioStream)), kMessages);
+    EXPECT_EQ(static_cast<size_t>(std::count(order.begin(), order.end(), telemetryStream)), kMessages);
+    // Telemetry was queued first, audio overtakes it after the few messages already on their way
+    auto lastAudio = static_cast<size_t>(std::find(order.rbegin(), order.rend(), audioStream).base() - order.begin());
+    EXPECT_LT(lastAudio, kMessages + 5);
+    EXPECT_EQ(corrupted, 0);
+    EXPECT_EQ(plainMessages, 1);
+
+    SRTNetMux::StreamStatistics stats;
+    ASSERT_TRUE(mux.getStreamStatistics(staleStream, stats));
+    EXPECT_EQ(stats.mExpired, kExpiring);
+    EXPECT_EQ(stats.mSent, 0);
+    ASSERT_TRUE(mux.getStreamStatistics(audioStream, stats));
+    EXPECT_EQ(stats.mSent, kMessages);
+    EXPECT_EQ(stats.mBytes, kMessages * payload.size());
+    EXPECT_EQ(stats.mDropped, 1);
+    EXPECT_FALSE(mux.getStreamStatistics(3, stats));
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, TSAnalysis) {
+    const uint16_t kVideoPid = 0x100;
+    const uint16_t kAudioPid = 0x101;
+
+    // A message of seven packets, the video packets carry the counters and a PCR in the first packet
+    uint8_t videoCounter = 0;
+    uint8_t audioCounter = 0;
+    auto makeMessage = [&](int64_t pcr) {
+        std::vector<uint8_t> message(7 * SRTNetTS::kPacketSize, 0xff);
+        for (size_t i = 0; i < 7; ++i) {
+            uint8_t* packet = message.data() + i * SRTNetTS::kPacketSize;
+            uint16_t pid = i < 5 ? kVideoPid : kAudioPid;
+            uint8_t& counter = pid == kVideoPid ? videoCounter : audioCounter;
+            packet[0] = SRTNetTS::kSyncByte;
+            packet[1] = static_cast<uint8_t>(pid >> 8);
+            packet[2] = static_cast<uint8_t>(pid);
+            packet[3] = static_cast<uint8_t>(0x10 | counter);
+            counter = (counter + 1) & 0x0f;
+            if (i == 0) {
+                int64_t base = pcr / 300;
+                packet[3] |= 0x20;
+                packet[4] = 7;
+                packet[5] = 0x10;
+                packet[6] = static_cast<uint8_t>(base >> 25);
+                packet[7] = static_cast<uint8_t>(base >> 17);
+                packet[8] = static_cast<uint8_t>(base >> 9);
+                packet[9] = static_cast<uint8_t>(base >> 1);
+                packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7e);
+                packet[11] = 0;
+            }
+        }
+        return message;
+    };
+
+    // Every header scan finds the same errors
+    for (auto scan : {SRTNetTSAnalyzer::Scan::scalar, SRTNetTSAnalyzer::Scan::sse2, SRTNetTSAnalyzer::Scan::avx2}) {
+        SRTNetTSAnalyzer::Config config;
+        config.mScan = scan;
+        SRTNetTSAnalyzer analyzer(config);
+        if (analyzer.getScan() != scan) {
+            continue; // Not supported here
+        }
+        videoCounter = 0;
+        audioCounter = 0;
+        // A PCR every 10 ms, the messages arrive 1 ms off every other time
+        for (int64_t i = 0; i < 20; ++i) {
+            std::vector<uint8_t> message = makeMessage(i * SRTNetTS::kPcrClock / 100);
+            analyzer.analyze(message.data(), message.size(), i * 10000 + (i % 2) * 1000);
+        }
+        SRTNetTSAnalyzer::Statistics stats = analyzer.getStatistics();
+        EXPECT_EQ(stats.mMessages, 20u);
+        EXPECT_EQ(stats.mPackets, 140u);
+        EXPECT_EQ(stats.mSyncErrors, 0u);
+        EXPECT_EQ(stats.mTransportErrors, 0u);
+        EXPECT_EQ(stats.mContinuityErrors, 0u);
+        EXPECT_EQ(stats.mPcrs, 20u);
+        EXPECT_EQ(stats.mPcrPid, kVideoPid);
+        EXPECT_EQ(stats.mMaxPcrJitter, 1000);
+        EXPECT_GT(stats.mPcrJitter, 0);
+
+        std::vector<uint8_t> message = makeMessage(0);
+        message[SRTNetTS::kPacketSize] = 0x00;                 // Packet 1 lost its sync byte
+        message[2 * SRTNetTS::kPacketSize + 1] |= 0x80;        // Packet 2 has the transport error indicator set
+        analyzer.analyze(message.data(), message.size(), 0);
+        // The video counter skips one
+        videoCounter = (videoCounter + 1) & 0x0f;
+        message = makeMessage(0);
+        // A packet repeated once is fine, twice is not
+        for (size_t i = 3; i < 5; ++i) {
+            std::memcpy(message.data() + i * SRTNetTS::kPacketSize, message.data() + 2 * SRTNetTS::kPacketSize,
+                        SRTNetTS::kPacketSize);
+        }
+        analyzer.analyze(message.data(), message.size(), 0);
+        uint8_t notTransportStream[100] = {SRTNetTS::kSyncByte};
+        analyzer.analyze(notTransportStream, sizeof(notTransportStream), 0);
+
+        stats = analyzer.getStatistics();
+        EXPECT_EQ(stats.mSyncErrors, 1u);
+        EXPECT_EQ(stats.mTransportErrors, 1u);
+        // Packets 1 and 2 were not counted, packet 3 is two off. Then the skipped counter and the second repeat
+        EXPECT_EQ(stats.mContinuityErrors, 3u);
+        EXPECT_EQ(stats.mNotTransportStream, 1u);
+    }
+
+    // Through SRTNet, per connection
+    SRTNet server;
+    SRTNet client;
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    std::atomic<size_t> received = {0};
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        received++;
+    };
+    SRTNetTSAnalyzer::Statistics tsStats;
+    EXPECT_FALSE(server.getTSStatistics(tsStats, 0));
+    ASSERT_TRUE(server.setTSAnalysis(SRTNetTSAnalyzer::Config()));
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    EXPECT_FALSE(server.setTSAnalysis(std::nullopt));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    videoCounter = 0;
+    audioCounter = 0;
+    for (int64_t i = 0; i < 20; ++i) {
+        if (i == 10) {
+            audioCounter = (audioCounter + 1) & 0x0f;
+        }
+        std::vector<uint8_t> message = makeMessage(i * SRTNetTS::kPcrClock / 100);
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(client.sendData(message.data(), message.size(), &msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (int i = 0; i < 300 && received < 20; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(received, 20u);
+    SRTSOCKET clientSocket = 0;
+    server.getActiveClients([&](std::map<SRTSOCKET, std::shared_ptr<SRTNet::NetworkConnection>>& clientList) {
+        if (!clientList.empty()) {
+            clientSocket = clientList.begin()->first;
+        }
+    });
+    EXPECT_FALSE(server.getTSStatistics(tsStats, 0)) << "Expect the server to need a connection";
+    ASSERT_TRUE(server.getTSStatistics(tsStats, clientSocket));
+    EXPECT_EQ(tsStats.mPackets, 140u);
+    EXPECT_EQ(tsStats.mContinuityErrors, 1u);
+    EXPECT_EQ(tsStats.mPcrs, 20u);
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrt, CongestionDrop) {
+    const uint16_t kVideoPid = 0x100;
+    const uint16_t kDataPid = 0x102;
+    const uint8_t kIdr = 0x65;          // nal_ref_idc 3, IDR slice
+    const uint8_t kReference = 0x41;    // nal_ref_idc 2, non-IDR slice
+    const uint8_t kNonReference = 0x01; // nal_ref_idc 0, non-IDR slice
+
+    // One H.264 frame in six packets, optionally followed by a packet of the low priority PID
+    uint8_t videoCounter = 0;
+    auto makeMessage = [&](uint8_t slice, bool withData) {
+        std::vector<uint8_t> message;
+        for (size_t i = 0; i < 6; ++i) {
+            uint8_t packet[SRTNetTS::kPacketSize] = {SRTNetTS::kSyncByte, static_cast<uint8_t>(kVideoPid >> 8),
+                                                     static_cast<uint8_t>(kVideoPid),
+                                                     static_cast<uint8_t>(0x10 | videoCounter)};
+            videoCounter = (videoCounter + 1) & 0x0f;
+            if (i == 0) {
+                // PES header without PTS, an access unit delimiter and the slice
+                const uint8_t payload[] = {0, 0, 1, 0xe0, 0, 0, 0x80, 0, 0, 0, 0, 0, 1, 0x09, 0xf0, 0, 0, 1, slice};
+                packet[1] |= 0x40;
+                std::memcpy(packet + 4, payload, sizeof(payload));
+            }
+            message.insert(message.end(), packet, packet + sizeof(packet));
+        }
+        if (withData) {
+            uint8_t packet[SRTNetTS::kPacketSize] = {SRTNetTS::kSyncByte, kDataPid >> 8, kDataPid & 0xff, 0x10};
+            message.insert(message.end(), packet, packet + sizeof(packet));
+        }
+        return message;
+    };
+
+    SRTNetCongestionDrop dropper;
+    SRTNetCongestionDrop::Config config;
+    EXPECT_FALSE(dropper.start(config)) << "Expect a high threshold to be required";
+    config.mHighBufferPackets = 10;
+    config.mLowBufferPackets = 2;
+    config.mVideoPids[kVideoPid] = SRTNetCongestionDrop::Codec::h264;
+    config.mLowPriorityPids = {kVideoPid};
+    EXPECT_FALSE(dropper.start(config)) << "Expect a PID to be either video or low priority";
+    config.mLowPriorityPids = {kDataPid};
+    ASSERT_TRUE(dropper.start(config));
+
+    // The client reaches the server through a relay that can break the link
+    SRTNet server;
+    SRTNet client;
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+    };
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ImpairmentRelay relay;
+    ASSERT_TRUE(relay.start(8010, 8009));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8010, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+
+    // Nothing is acknowledged, the send buffer fills up with reference frames
+    relay.setBlackhole(true);
+    for (int i = 0; i < 200 && !dropper.getStatistics().mCongested; ++i) {
+        std::vector<uint8_t> message = makeMessage(kIdr, false);
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(dropper.sendData(client, message.data(), message.size(), &msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    SRTNetCongestionDrop::Statistics before = dropper.getStatistics();
+    ASSERT_TRUE(before.mCongested);
+    EXPECT_EQ(before.mCongestionEvents, 1u);
+    EXPECT_GT(before.mBufferPackets, 10);
+    EXPECT_EQ(before.mDroppedFrames, 0u);
+    EXPECT_EQ(before.mDroppedNonReference, 0u);
+
+    // I B B P, the B frames and the low priority packets are dropped
+    const uint8_t kGop[] = {kIdr, kNonReference, kNonReference, kReference};
+    for (size_t i = 0; i < 20; ++i) {
+        std::vector<uint8_t> message = makeMessage(kGop[i % 4], true);
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(dropper.sendData(client, message.data(), message.size(), &msgCtrl));
+    }
+    SRTNetCongestionDrop::Statistics during = dropper.getStatistics();
+    EXPECT_TRUE(during.mCongested);
+    EXPECT_EQ(during.mDroppedFrames, 10u);
+    EXPECT_EQ(during.mDroppedNonReference, 60u);
+    EXPECT_EQ(during.mDroppedLowPriority, 20u);
+    EXPECT_EQ(during.mSentPackets - before.mSentPackets, 60u);
+
+    // The link comes back, the send buffer drains and nothing is dropped any more
+    relay.setBlackhole(false);
+    for (int i = 0; i < 300 && dropper.getStatistics().mCongested; ++i) {
+        std::vector<uint8_t> message = makeMessage(kReference, false);
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(dropper.sendData(client, message.data(), message.size(), &msgCtrl));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(dropper.getStatistics().mCongested);
+    for (size_t i = 0; i < 8; ++i) {
+        std::vector<uint8_t> message = makeMessage(kGop[i % 4], true);
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(dropper.sendData(client, message.data(), message.size(), &msgCtrl));
+    }
+    SRTNetCongestionDrop::Statistics after = dropper.getStatistics();
+    EXPECT_EQ(after.mDroppedFrames, during.mDroppedFrames);
+    EXPECT_EQ(after.mDroppedLowPriority, during.mDroppedLowPriority);
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+    relay.stop();
+}
+
+namespace {
+///
+/// @brief Counts the allocations of the thread calling onPacket from packet kWarmup to packet kWarmup + kMeasured
+struct AllocationWindow {
+    static constexpr size_t kWarmup = 200;
+    static constexpr size_t kMeasured = 500;
+
+    void onPacket() {
+        size_t packet = ++mPackets;
+        if (packet == kWarmup) {
+            mStart = tAllocations;
+        } else if (packet == kWarmup + kMeasured) {
+            mEnd = tAllocations;
+            mDone = true;
+        }
+    }
+
+    bool waitDone() const {
+        for (int i = 0; i < 300 && !mDone; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return mDone;
+    }
+
+    uint64_t allocations() const {
+        return mEnd - mStart;
+    }
+
+    std::atomic<size_t> mPackets = {0};
+    std::atomic<uint64_t> mStart = {0};
+    std::atomic<uint64_t> mEnd = {0};
+    std::atomic<bool> mDone = {false};
+};
+
+/// Send the packets of a window and count the allocations of the sending thread
+void sendWindow(SRTNet& net, SRTSOCKET target, AllocationWindow& window) {
+    uint8_t payload[188] = {0x47};
+    // Some packets more, live mode may drop one on the receive side
+    for (size_t i = 0; i < AllocationWindow::kWarmup + AllocationWindow::kMeasured + 50; ++i) {
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        EXPECT_TRUE(net.sendData(payload, sizeof(payload), &msgCtrl, target));
+        window.onPacket();
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+} // namespace
+
+TEST(TestSrt, ZeroAllocationSteadyState) {
+    SRTNet server;
+    SRTNet client;
+    AllocationWindow serverReceive;
+    AllocationWindow clientReceive;
+    std::atomic<SRTSOCKET> serverSocket = {0};
+
+    server.clientConnected = [&](struct sockaddr& sin, SRTSOCKET newSocket,
+                                 std::shared_ptr<SRTNet::NetworkConnection>& ctx) {
+        serverSocket = newSocket;
+        return std::make_shared<SRTNet::NetworkConnection>();
+    };
+    server.receivedDataNoCopy = [&](const uint8_t* data, size_t size, SRT_MSGCTRL& msgCtrl,
+                                    std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        serverReceive.onPacket();
+    };
+    // The vector is left to SRTNet, it is reused for the next packet
+    client.receivedData = [&](std::unique_ptr<std::vector<uint8_t>>& data, SRT_MSGCTRL& msgCtrl,
+                              std::shared_ptr<SRTNet::NetworkConnection>& ctx, SRTSOCKET socket) {
+        clientReceive.onPacket();
+    };
+
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    ASSERT_TRUE(server.startServer("127.0.0.1", 8009, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE, 5000, "", false, ctx));
+    ASSERT_TRUE(client.startClient("127.0.0.1", 8009, 16, 1000, 100, ctx, SRT_LIVE_MAX_PLSIZE));
+    for (int i = 0; i < 300 && serverSocket.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_NE(serverSocket.load(), 0);
+
+    // Client sendData and the serverEventHandler receive path
+    AllocationWindow clientSend;
+    sendWindow(client, 0, clientSend);
+    ASSERT_TRUE(serverReceive.waitDone());
+    EXPECT_EQ(clientSend.allocations(), 0u) << "Expect the client sendData to not allocate";
+    EXPECT_EQ(serverReceive.allocations(), 0u) << "Expect the server receive path to not allocate";
+
+    // Server sendData and the clientWorker receive path
+    AllocationWindow serverSend;
+    sendWindow(server, serverSocket, serverSend);
+    ASSERT_TRUE(clientReceive.waitDone());
+    EXPECT_EQ(serverSend.allocations(), 0u) << "Expect the server sendData to not allocate";
+    EXPECT_EQ(clientReceive.allocations(), 0u) << "Expect the client receive path to not allocate";
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
@@ -0,0 +1,113 @@
+#include <condition_variable>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "SRTNetCoroutine.h"
+
+namespace {
+
+SRTNetCoroutine::Task echoSession(std::shared_ptr<SRTNetCoroutine::Connection> connection) {
+    while (auto message = co_await connection->receive()) {
+        EXPECT_TRUE(co_await connection->send(message.mData, message.mSize));
+    }
+}
+
+SRTNetCoroutine::Task acceptLoop(SRTNetCoroutine::Server& server, std::atomic<int>& accepted) {
+    while (auto connection = co_await server.accept()) {
+        accepted++;
+        echoSession(connection);
+    }
+}
+
+} // namespace
+
+TEST(TestSrtCoroutine, EchoRoundTrip) {
+    SRTNetCoroutine::Server server;
+    std::atomic<int> accepted = {0};
+    acceptLoop(server, accepted);
+    ASSERT_TRUE(server.start("127.0.0.1", 8012, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE));
+
+    SRTNetCoroutine::Client client;
+    auto connection = client.connect("127.0.0.1", 8012, 16, 1000, 100, SRT_LIVE_MAX_PLSIZE);
+    ASSERT_NE(connection, nullptr);
+    EXPECT_NE(connection->getSocket(), 0);
+
+    const size_t kMessages = 10;
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    size_t echoed = 0;
+    auto session = [&](std::shared_ptr<SRTNetCoroutine::Connection> connection) -> SRTNetCoroutine::Task {
+        std::vector<uint8_t> payload(1000);
+        for (size_t i = 0; i < kMessages; ++i) {
+            std::fill(payload.begin(), payload.end(), static_cast<uint8_t>(i));
+            EXPECT_TRUE(co_await connection->send(payload.data(), payload.size()));
+            auto message = co_await connection->receive();
+            if (!message) {
+                break;
+            }
+            EXPECT_EQ(std::vector<uint8_t>(message.mData, message.mData + message.mSize), payload);
+            std::lock_guard<std::mutex> lock(doneMutex);
+            echoed++;
+        }
+        doneCondition.notify_one();
+    };
+    session(connection);
+
+    {
+        std::unique_lock<std::mutex> lock(doneMutex);
+        EXPECT_TRUE(doneCondition.wait_for(lock, std::chrono::seconds(5), [&]() { return echoed == kMessages; }));
+    }
+    EXPECT_EQ(accepted, 1);
+    EXPECT_EQ(connection->getDroppedMessages(), 0);
+
+    EXPECT_TRUE(client.stop());
+    EXPECT_TRUE(server.stop());
+}
+
+TEST(TestSrtCoroutine, BacklogWhenNotWaiting) {
+    SRTNet net;
+    SRTNetCoroutine::Connection connection(net, 1, 1);
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    for (uint8_t i = 0; i < SRTNetCoroutine::Connection::kBacklogSize + 2; ++i) {
+        connection.deliver(&i, sizeof(i), msgCtrl);
+    }
+    EXPECT_EQ(connection.getDroppedMessages(), 2);
+
+    std::vector<uint8_t> received;
+    auto reader = [&]() -> SRTNetCoroutine::Task {
+        while (auto message = co_await connection.receive()) {
+            received.push_back(message.mData[0]);
+        }
+    };
+    reader();
+    // The backlog is drained without suspending, then the reader waits for the next message
+    EXPECT_EQ(received.size(), SRTNetCoroutine::Connection::kBacklogSize);
+    EXPECT_EQ(received.front(), 2);
+    uint8_t last = 200;
+    connection.deliver(&last, sizeof(last), msgCtrl);
+    EXPECT_EQ(received.back(), 200);
+    connection.disconnected();
+}
+
+TEST(TestSrtCoroutine, BackloggedMessageNotOverwritten) {
+    SRTNet net;
+    SRTNetCoroutine::Connection connection(net, 1, 1);
+    SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+    for (uint8_t i = 0; i < SRTNetCoroutine::Connection::kBacklogSize; ++i) {
+        connection.deliver(&i, sizeof(i), msgCtrl);
+    }
+
+    SRTNetCoroutine::Message taken;
+    auto reader = [&]() -> SRTNetCoroutine::Task {
+        taken = co_await connection.receive();
+    };
+    reader();
+    ASSERT_TRUE(taken);
+    // The slot the message was taken from is the next one the receive thread writes
+    uint8_t next = 200;
+    connection.deliver(&next, sizeof(next), msgCtrl);
+    EXPECT_EQ(taken.mData[0], 0);
+    EXPECT_EQ(connection.getDroppedMessages(), 0);
+    connection.disconnected();
+}
@@ -0,0 +1,350 @@
+//
+// Starts many SRT clients against a server to find its connection and throughput limits.
+//
+// Usage: srtnet_loadgen <host> <port> [options]
+//
+//   --clients <n>       number of client sessions (default 10)
+//   --bitrate <Mbit/s>  send bitrate per session (default 5)
+//   --payload <bytes>   message size (default 1316)
+//   --duration <s>      how long to send after the last session connected (default 30)
+//   --ramp <n/s>        new connections per second, 0 connects as fast as possible (default 50)
+//   --threads <n>       send scheduler threads (default 1)
+//   --latency <ms>      SRT latency (default 120)
+//   --report <s>        seconds between the progress reports (default 5)
+//   --per-session       print one line per session in the final report
+//
+// The sends of all sessions are driven by a few scheduler threads, each with a timer heap ordered by the time the
+// next message of a session is due. Sessions are never given a thread of their own for sending.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SRTNet.h"
+
+namespace {
+
+struct LoadOptions {
+    std::string mHost;
+    uint16_t mPort = 0;
+    size_t mClients = 10;
+    double mBitrate = 5.0;
+    size_t mPayload = 1316;
+    int mDuration = 30;
+    double mRamp = 50.0;
+    size_t mThreads = 1;
+    int32_t mLatency = 120;
+    int mReport = 5;
+    bool mPerSession = false;
+};
+
+struct LoadSession {
+    SRTNet mNet;
+    bool mConnected = false;
+    std::chrono::microseconds mConnectTime{0};
+    std::chrono::steady_clock::time_point mConnectedAt;
+    std::atomic<uint64_t> mSent = {0};
+    std::atomic<uint64_t> mFailed = {0};
+};
+
+///
+/// @brief Sends for a share of the sessions, one timer heap per scheduler thread
+class SendScheduler {
+public:
+    SendScheduler(const LoadOptions& options, const std::vector<uint8_t>& payload)
+        : mPayload(payload) {
+        mInterval = std::chrono::nanoseconds(
+            static_cast<int64_t>(static_cast<double>(options.mPayload) * 8.0 * 1000.0 / options.mBitrate));
+    }
+
+    ///
+    /// @brief Hand a connected session to the scheduler thread
+    void add(LoadSession* session) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mAdded.push_back(session);
+    }
+
+    void start() {
+        mThread = std::thread(&SendScheduler::run, this);
+    }
+
+    void stop() {
+        mActive = false;
+        if (mThread.joinable()) {
+            mThread.join();
+        }
+    }
+
+    /// @return How late the sends were, the largest seen in microseconds
+    int64_t getMaxLateness() const {
+        return mMaxLateness;
+    }
+
+private:
+    using Due = std::pair<std::chrono::steady_clock::time_point, LoadSession*>;
+
+    void run() {
+        std::priority_queue<Due, std::vector<Due>, std::greater<>> timers;
+        std::vector<LoadSession*> added;
+        while (mActive) {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                added.swap(mAdded);
+            }
+            auto now = std::chrono::steady_clock::now();
+            for (auto* session : added) {
+                timers.emplace(now, session);
+            }
+            added.clear();
+
+            // Wait for the next send, at most 10 ms so that new sessions and stop are seen
+            auto wakeUp = now + std::chrono::milliseconds(10);
+            if (!timers.empty() && timers.top().first < wakeUp) {
+                wakeUp = timers.top().first;
+            }
+            std::this_thread::sleep_until(wakeUp);
+
+            now = std::chrono::steady_clock::now();
+            while (!timers.empty() && timers.top().first <= now) {
+                auto [due, session] = timers.top();
+                timers.pop();
+                SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+                if (session->mNet.sendData(mPayload.data(), mPayload.size(), &msgCtrl)) {
+                    session->mSent.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    session->mFailed.fetch_add(1, std::memory_order_relaxed);
+                }
+                int64_t lateness = std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+                if (lateness > mMaxLateness) {
+                    mMaxLateness = lateness;
+                }
+                // Keep the schedule of the session, a late send does not shift the following ones
+                timers.emplace(due + mInterval, session);
+            }
+        }
+    }
+
+    const std::vector<uint8_t>& mPayload;
+    std::chrono::nanoseconds mInterval{0};
+    std::mutex mMutex;
+    std::vector<LoadSession*> mAdded;
+    std::atomic<bool> mActive = {true};
+    std::atomic<int64_t> mMaxLateness = {0};
+    std::thread mThread;
+};
+
+std::atomic<bool> gRunning = {true};
+
+void stopLoad(int) {
+    gRunning = false;
+}
+
+bool parseOptions(int argc, const char* argv[], LoadOptions& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--clients" && hasValue) {
+            options.mClients = std::stoul(argv[++i]);
+        } else if (argument == "--bitrate" && hasValue) {
+            options.mBitrate = std::stod(argv[++i]);
+        } else if (argument == "--payload" && hasValue) {
+            options.mPayload = std::stoul(argv[++i]);
+        } else if (argument == "--duration" && hasValue) {
+            options.mDuration = std::stoi(argv[++i]);
+        } else if (argument == "--ramp" && hasValue) {
+            options.mRamp = std::stod(argv[++i]);
+        } else if (argument == "--threads" && hasValue) {
+            options.mThreads = std::stoul(argv[++i]);
+        } else if (argument == "--latency" && hasValue) {
+            options.mLatency = std::stoi(argv[++i]);
+        } else if (argument == "--report" && hasValue) {
+            options.mReport = std::stoi(argv[++i]);
+        } else if (argument == "--per-session") {
+            options.mPerSession = true;
+        } else if (argument.rfind("--", 0) == 0) {
+            return false;
+        } else {
+            positional.push_back(argument);
+        }
+    }
+    if (positional.size() != 2 || options.mClients == 0 || options.mBitrate <= 0.0 || options.mPayload == 0 ||
+        options.mPayload > SRT_LIVE_MAX_PLSIZE || options.mThreads == 0 || options.mReport <= 0) {
+        return false;
+    }
+    options.mHost = positional[0];
+    options.mPort = static_cast<uint16_t>(std::stoi(positional[1]));
+    return true;
+}
+
+///
+/// @return The value below which share of the sorted values are
+double percentile(const std::vector<double>& sorted, double share) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(share * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+void printProgress(const std::vector<std::unique_ptr<LoadSession>>& sessions,
+                   uint64_t& lastSent,
+                   std::chrono::steady_clock::time_point& lastReport,
+                   size_t payload) {
+    uint64_t sent = 0;
+    uint64_t failed = 0;
+    size_t connected = 0;
+    for (const auto& session : sessions) {
+        sent += session->mSent.load(std::memory_order_relaxed);
+        failed += session->mFailed.load(std::memory_order_relaxed);
+        connected += session->mConnected ? 1 : 0;
+    }
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - lastReport).count();
+    double mbps = seconds > 0.0 ? static_cast<double>(sent - lastSent) * payload * 8.0 / seconds / 1000000.0 : 0.0;
+    std::printf("connected %zu, sent %llu messages (%.1f Mbit/s), send failures %llu\n", connected,
+                static_cast<unsigned long long>(sent), mbps, static_cast<unsigned long long>(failed));
+    std::fflush(stdout);
+    lastSent = sent;
+    lastReport = now;
+}
+
+void printReport(const std::vector<std::unique_ptr<LoadSession>>& sessions,
+                 const LoadOptions& options,
+                 size_t attempted,
+                 int64_t maxLateness) {
+    std::vector<double> connectTimes;
+    std::vector<double> rtts;
+    uint64_t totalSent = 0;
+    int64_t totalDropped = 0;
+    int64_t totalRetransmitted = 0;
+    double totalMbps = 0.0;
+    auto now = std::chrono::steady_clock::now();
+    if (options.mPerSession) {
+        std::printf("%-8s %10s %10s %10s %10s %10s %10s\n", "session", "connect ms", "sent", "Mbit/s", "dropped",
+                    "retrans", "rtt ms");
+    }
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        LoadSession& session = *sessions[i];
+        if (!session.mConnected) {
+            continue;
+        }
+        SRT_TRACEBSTATS stats = {};
+        session.mNet.getStatistics(&stats, SRTNetClearStats::no, SRTNetInstant::yes);
+        double seconds = std::chrono::duration<double>(now - session.mConnectedAt).count();
+        uint64_t sent = session.mSent.load();
+        double mbps = seconds > 0.0 ? static_cast<double>(sent) * options.mPayload * 8.0 / seconds / 1000000.0 : 0.0;
+        double connectMs = static_cast<double>(session.mConnectTime.count()) / 1000.0;
+        connectTimes.push_back(connectMs);
+        rtts.push_back(stats.msRTT);
+        totalSent += sent;
+        totalDropped += stats.pktSndDropTotal;
+        totalRetransmitted += stats.pktRetransTotal;
+        totalMbps += mbps;
+        if (options.mPerSession) {
+            std::printf("%-8zu %10.1f %10llu %10.2f %10d %10d %10.1f\n", i, connectMs,
+                        static_cast<unsigned long long>(sent), mbps, stats.pktSndDropTotal, stats.pktRetransTotal,
+                        stats.msRTT);
+        }
+    }
+    std::sort(connectTimes.begin(), connectTimes.end());
+    std::sort(rtts.begin(), rtts.end());
+    std::printf("Sessions: %zu connected of %zu attempted\n", connectTimes.size(), attempted);
+    std::printf("Connect time: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", percentile(connectTimes, 0.5),
+                percentile(connectTimes, 0.99), connectTimes.empty() ? 0.0 : connectTimes.back());
+    std::printf("Throughput: %.1f Mbit/s total, %llu messages sent\n", totalMbps,
+                static_cast<unsigned long long>(totalSent));
+    std::printf("Sender drops: %lld, retransmitted: %lld\n", static_cast<long long>(totalDropped),
+                static_cast<long long>(totalRetransmitted));
+    std::printf("RTT: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", percentile(rtts, 0.5), percentile(rtts, 0.99),
+                rtts.empty() ? 0.0 : rtts.back());
+    std::printf("Largest send delay of the schedulers: %.1f ms\n", static_cast<double>(maxLateness) / 1000.0);
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    LoadOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cout << "Usage: " << argv[0]
+                  << " <host> <port> [--clients n] [--bitrate Mbit/s] [--payload bytes] [--duration s]"
+                     " [--ramp n/s] [--threads n] [--latency ms] [--report s] [--per-session]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    srt_startup();
+    std::signal(SIGINT, stopLoad);
+
+    std::vector<uint8_t> payload(options.mPayload, 0x47);
+    std::vector<std::unique_ptr<SendScheduler>> schedulers;
+    for (size_t i = 0; i < options.mThreads; ++i) {
+        schedulers.push_back(std::make_unique<SendScheduler>(options, payload));
+        schedulers.back()->start();
+    }
+
+    std::cout << "Connecting " << options.mClients << " sessions to " << options.mHost << ":" << options.mPort
+              << " at " << options.mBitrate << " Mbit/s each" << std::endl;
+    std::vector<std::unique_ptr<LoadSession>> sessions;
+    sessions.reserve(options.mClients);
+    auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+    auto rampStart = std::chrono::steady_clock::now();
+    auto lastReport = rampStart;
+    uint64_t lastSent = 0;
+    size_t attempted = 0;
+    for (size_t i = 0; i < options.mClients && gRunning; ++i) {
+        if (options.mRamp > 0.0) {
+            std::this_thread::sleep_until(
+                rampStart + std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(i) * 1000000.0 /
+                                                                           options.mRamp)));
+        }
+        auto session = std::make_unique<LoadSession>();
+        auto connectStart = std::chrono::steady_clock::now();
+        attempted++;
+        session->mConnected = session->mNet.startClient(options.mHost, options.mPort, 16, options.mLatency, 25, ctx,
+                                                        SRT_LIVE_MAX_PLSIZE);
+        session->mConnectedAt = std::chrono::steady_clock::now();
+        session->mConnectTime =
+            std::chrono::duration_cast<std::chrono::microseconds>(session->mConnectedAt - connectStart);
+        if (session->mConnected) {
+            schedulers[i % schedulers.size()]->add(session.get());
+        } else {
+            std::cerr << "Session " << i << " failed to connect" << std::endl;
+        }
+        sessions.push_back(std::move(session));
+        if (std::chrono::steady_clock::now() - lastReport >= std::chrono::seconds(options.mReport)) {
+            printProgress(sessions, lastSent, lastReport, options.mPayload);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(options.mDuration);
+    while (gRunning && std::chrono::steady_clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (std::chrono::steady_clock::now() - lastReport >= std::chrono::seconds(options.mReport)) {
+            printProgress(sessions, lastSent, lastReport, options.mPayload);
+        }
+    }
+
+    int64_t maxLateness = 0;
+    for (auto& scheduler : schedulers) {
+        scheduler->stop();
+        maxLateness = std::max(maxLateness, scheduler->getMaxLateness());
+    }
+    printReport(sessions, options, attempted, maxLateness);
+    for (auto& session : sessions) {
+        session->mNet.stop();
+    }
+    sessions.clear();
+    srt_cleanup();
+    return EXIT_SUCCESS;
+}
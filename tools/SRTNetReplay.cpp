@@ -0,0 +1,304 @@
+//
+// Re-sends SRTNetRecorder captures to an SRT server with the original timing.
+//
+// Usage: srtnet_replay <host> <port> <capture file> [capture file ...] [options]
+//
+//   --sessions <n>      parallel replay sessions, one SRT connection each (default 1)
+//   --speed <factor>    replay speed, 2.0 sends twice as fast (default 1.0)
+//   --start <seconds>   start this far into the capture, seeks with the capture index (default 0)
+//   --stagger <ms>      delay between the session starts (default 10)
+//   --latency <ms>      SRT latency (default 120)
+//   --loop              start over at the end of the capture until stopped with Ctrl-C, the messages of the capture
+//                       must not all have the same time
+//
+// The rotated files of one recording are given in order and replayed as one capture. Every session sends the whole
+// capture. The timing of all sessions is driven by one thread, so the session count is limited by the bitrate and not
+// by the number of threads. The capture is kept in memory.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SRTNet.h"
+
+namespace {
+
+struct CapturedMessage {
+    int64_t mOffset = 0; // Microseconds since the first message
+    std::vector<uint8_t> mPayload;
+};
+
+struct ReplayOptions {
+    std::string mHost;
+    uint16_t mPort = 0;
+    std::vector<std::string> mFiles;
+    size_t mSessions = 1;
+    double mSpeed = 1.0;
+    double mStart = 0.0;
+    int mStagger = 10;
+    int32_t mLatency = 120;
+    bool mLoop = false;
+};
+
+///
+/// @brief Send time error histogram, 10 us buckets up to 100 ms
+class LatenessHistogram {
+public:
+    void add(int64_t microseconds) {
+        size_t bucket = static_cast<size_t>(std::max<int64_t>(microseconds, 0) / kBucketWidth);
+        mBuckets[std::min(bucket, mBuckets.size() - 1)]++;
+        mCount++;
+        mSum += microseconds;
+        mMax = std::max(mMax, microseconds);
+    }
+
+    /// @return The lateness in microseconds that share of the messages stayed below
+    int64_t percentile(double share) const {
+        uint64_t target = static_cast<uint64_t>(share * static_cast<double>(mCount));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < mBuckets.size(); ++i) {
+            seen += mBuckets[i];
+            if (seen > target) {
+                return static_cast<int64_t>((i + 1) * kBucketWidth);
+            }
+        }
+        return mMax;
+    }
+
+    double mean() const {
+        return mCount ? static_cast<double>(mSum) / static_cast<double>(mCount) : 0.0;
+    }
+
+    int64_t max() const {
+        return mMax;
+    }
+
+private:
+    static constexpr int64_t kBucketWidth = 10;
+    std::vector<uint64_t> mBuckets = std::vector<uint64_t>(10000, 0);
+    uint64_t mCount = 0;
+    int64_t mSum = 0;
+    int64_t mMax = 0;
+};
+
+struct ReplaySession {
+    SRTNet mNet;
+    size_t mNext = 0;
+    std::chrono::steady_clock::time_point mStart; // When the message at offset 0 is due
+    int64_t mSrtStart = 0;                        // The SRT clock at mStart
+    uint64_t mSent = 0;
+    uint64_t mFailed = 0;
+    uint64_t mLoops = 0;
+    LatenessHistogram mLateness;
+};
+
+std::atomic<bool> gRunning = {true};
+
+void stopReplay(int) {
+    gRunning = false;
+}
+
+bool parseOptions(int argc, const char* argv[], ReplayOptions& options) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (argument == "--sessions" && hasValue) {
+            options.mSessions = std::stoul(argv[++i]);
+        } else if (argument == "--speed" && hasValue) {
+            options.mSpeed = std::stod(argv[++i]);
+        } else if (argument == "--start" && hasValue) {
+            options.mStart = std::stod(argv[++i]);
+        } else if (argument == "--stagger" && hasValue) {
+            options.mStagger = std::stoi(argv[++i]);
+        } else if (argument == "--latency" && hasValue) {
+            options.mLatency = std::stoi(argv[++i]);
+        } else if (argument == "--loop") {
+            options.mLoop = true;
+        } else if (argument.rfind("--", 0) == 0) {
+            return false;
+        } else {
+            positional.push_back(argument);
+        }
+    }
+    if (positional.size() < 3 || options.mSessions == 0 || options.mSpeed <= 0.0) {
+        return false;
+    }
+    options.mHost = positional[0];
+    options.mPort = static_cast<uint16_t>(std::stoi(positional[1]));
+    options.mFiles.assign(positional.begin() + 2, positional.end());
+    return true;
+}
+
+bool loadCapture(const ReplayOptions& options, std::vector<CapturedMessage>& messages) {
+    int64_t firstArrival = 0;
+    int64_t startArrival = 0;
+    for (size_t i = 0; i < options.mFiles.size(); ++i) {
+        SRTNetCaptureReader reader;
+        if (!reader.open(options.mFiles[i])) {
+            std::cerr << "Not a capture file: " << options.mFiles[i] << std::endl;
+            return false;
+        }
+        SRTNetCaptureRecordHeader header;
+        std::vector<uint8_t> payload;
+        if (i == 0) {
+            if (!reader.next(header, payload)) {
+                continue;
+            }
+            firstArrival = header.mArrivalTime;
+            startArrival = firstArrival + static_cast<int64_t>(options.mStart * 1000000.0);
+            reader.seek(startArrival);
+        } else if (startArrival > firstArrival && !reader.seek(startArrival)) {
+            continue;
+        }
+        while (reader.next(header, payload)) {
+            if (header.mArrivalTime < startArrival) {
+                continue;
+            }
+            CapturedMessage message;
+            message.mOffset = header.mArrivalTime - startArrival;
+            message.mPayload = payload;
+            messages.push_back(std::move(message));
+        }
+    }
+    if (messages.empty()) {
+        std::cerr << "No messages to replay" << std::endl;
+        return false;
+    }
+    // The first message after the start point is sent right away
+    int64_t firstOffset = messages.front().mOffset;
+    for (auto& message : messages) {
+        message.mOffset -= firstOffset;
+    }
+    return true;
+}
+
+void printReport(const std::vector<std::unique_ptr<ReplaySession>>& sessions, const LatenessHistogram& total) {
+    std::printf("%-8s %10s %8s %6s %10s %10s %10s\n", "session", "sent", "failed", "loops", "mean us", "p99 us",
+                "max us");
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        const ReplaySession& session = *sessions[i];
+        std::printf("%-8zu %10llu %8llu %6llu %10.1f %10lld %10lld\n", i,
+                    static_cast<unsigned long long>(session.mSent), static_cast<unsigned long long>(session.mFailed),
+                    static_cast<unsigned long long>(session.mLoops), session.mLateness.mean(), static_cast<long long>(session.mLateness.percentile(0.99)),
+                    static_cast<long long>(session.mLateness.max()));
+    }
+    std::printf("Send time error, all sessions: mean %.1f us, p50 %lld us, p99 %lld us, p99.9 %lld us, max %lld us\n",
+                total.mean(), static_cast<long long>(total.percentile(0.5)),
+                static_cast<long long>(total.percentile(0.99)), static_cast<long long>(total.percentile(0.999)),
+                static_cast<long long>(total.max()));
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cout << "Usage: " << argv[0]
+                  << " <host> <port> <capture file> [capture file ...] [--sessions n] [--speed factor]"
+                     " [--start seconds] [--stagger ms] [--latency ms] [--loop]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<CapturedMessage> messages;
+    if (!loadCapture(options, messages)) {
+        return EXIT_FAILURE;
+    }
+    int64_t captureDuration = messages.back().mOffset;
+    if (options.mLoop && captureDuration <= 0) {
+        // Every loop would be due at once, the replay would spin sending the capture as fast as it can
+        std::cerr << "Can't loop a capture of one message or with all messages at the same time" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Replaying " << messages.size() << " messages (" << captureDuration / 1000 << " ms) to "
+              << options.mHost << ":" << options.mPort << " with " << options.mSessions << " session(s) at "
+              << options.mSpeed << "x" << std::endl;
+
+    srt_startup();
+    std::signal(SIGINT, stopReplay);
+
+    std::vector<std::unique_ptr<ReplaySession>> sessions;
+    for (size_t i = 0; i < options.mSessions && gRunning; ++i) {
+        auto session = std::make_unique<ReplaySession>();
+        auto ctx = std::make_shared<SRTNet::NetworkConnection>();
+        if (!session->mNet.startClient(options.mHost, options.mPort, 16, options.mLatency, 25, ctx,
+                                       SRT_LIVE_MAX_PLSIZE)) {
+            std::cerr << "Session " << i << " failed to connect" << std::endl;
+            sessions.clear();
+            srt_cleanup();
+            return EXIT_FAILURE;
+        }
+        sessions.push_back(std::move(session));
+    }
+
+    // One timer queue for all sessions, ordered by the time the next message of the session is due
+    using Due = std::pair<std::chrono::steady_clock::time_point, size_t>;
+    std::priority_queue<Due, std::vector<Due>, std::greater<>> timers;
+    auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        sessions[i]->mStart = start + std::chrono::milliseconds(options.mStagger * static_cast<int>(i));
+        timers.emplace(sessions[i]->mStart, i);
+    }
+    auto scaled = [&](int64_t offset) {
+        return std::chrono::microseconds(static_cast<int64_t>(static_cast<double>(offset) / options.mSpeed));
+    };
+
+    LatenessHistogram total;
+    while (gRunning && !timers.empty()) {
+        auto [due, index] = timers.top();
+        timers.pop();
+        std::this_thread::sleep_until(due);
+        ReplaySession& session = *sessions[index];
+        auto now = std::chrono::steady_clock::now();
+        if (session.mSent + session.mFailed == 0) {
+            // The SRT clock of the first message, the source times of the session follow the capture from there
+            session.mSrtStart =
+                srt_time_now() - std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+        }
+
+        const CapturedMessage& message = messages[session.mNext];
+        SRT_MSGCTRL msgCtrl = srt_msgctrl_default;
+        msgCtrl.srctime = session.mSrtStart + scaled(message.mOffset).count();
+        if (session.mNet.sendData(message.mPayload.data(), message.mPayload.size(), &msgCtrl)) {
+            session.mSent++;
+        } else {
+            session.mFailed++;
+        }
+        int64_t lateness = std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+        session.mLateness.add(lateness);
+        total.add(lateness);
+
+        if (++session.mNext == messages.size()) {
+            if (!options.mLoop) {
+                continue;
+            }
+            // Start over one average message interval after the last message
+            int64_t gap = captureDuration / static_cast<int64_t>(messages.size());
+            session.mStart += scaled(captureDuration + gap);
+            session.mSrtStart += scaled(captureDuration + gap).count();
+            session.mNext = 0;
+            session.mLoops++;
+            timers.emplace(session.mStart, index);
+            continue;
+        }
+        timers.emplace(session.mStart + scaled(messages[session.mNext].mOffset), index);
+    }
+
+    printReport(sessions, total);
+    for (auto& session : sessions) {
+        session->mNet.stop(std::chrono::milliseconds(1000));
+    }
+    sessions.clear();
+    srt_cleanup();
+    return EXIT_SUCCESS;
+}